@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/score.hpp"
+
+namespace mastermyr {
+namespace {
+
+// Args: pegs, colours. Filters the full code space by the feedback of
+// 0011.. against 0123.., which keeps a typical first-move part.
+struct FilterCase {
+  explicit FilterCase(const benchmark::State& state)
+      : pegs(static_cast<unsigned>(state.range(0))),
+        colours(static_cast<unsigned>(state.range(1))) {
+    full.assign_all(pegs, colours);
+    for (unsigned i = 0; i < pegs; ++i) {
+      guess = guess.with_peg(i, i / 2);
+      secret = secret.with_peg(i, i % colours);
+    }
+    feedback = score(guess, secret, pegs);
+  }
+
+  unsigned pegs;
+  unsigned colours;
+  CandidateSet full;
+  Code guess;
+  Code secret;
+  Feedback feedback;
+};
+
+void filter_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"pegs", "colours"});
+  b->Args({4, 6});
+  b->Args({5, 8});
+  b->Args({6, 10});
+}
+
+void BM_FilterScore(benchmark::State& state) {
+  const FilterCase c(state);
+  CandidateSet set(c.full.size());
+  for (auto _ : state) {
+    state.PauseTiming();
+    set = c.full;
+    state.ResumeTiming();
+    set.filter(c.guess, c.feedback, c.pegs);
+    benchmark::DoNotOptimize(set.size());
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * c.full.size()));
+}
+BENCHMARK(BM_FilterScore)->Apply(filter_args);
+
+// Reads the feedback from a feedback-table row instead of scoring; only
+// boards small enough for a default table.
+void BM_FilterMatrixRow(benchmark::State& state) {
+  const FilterCase c(state);
+  const FeedbackMatrix matrix =
+      FeedbackMatrix::build({c.pegs, c.colours, DuplicateRule::kAllowed});
+  const auto row = matrix.row(code_index(c.guess, c.pegs, c.colours));
+  CandidateSet set(c.full.size());
+  for (auto _ : state) {
+    state.PauseTiming();
+    set = c.full;
+    state.ResumeTiming();
+    set.filter(row, c.feedback);
+    benchmark::DoNotOptimize(set.size());
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * c.full.size()));
+}
+BENCHMARK(BM_FilterMatrixRow)->ArgNames({"pegs", "colours"})->Args({4, 6});
+
+}  // namespace
+}  // namespace mastermyr
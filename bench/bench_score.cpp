@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "mastermyr/score.hpp"
+
+namespace mastermyr {
+namespace {
+
+using Kernel = void (*)(Code, const Code*, std::size_t, Feedback*, unsigned);
+
+std::vector<Code> random_codes(std::size_t n, unsigned pegs, unsigned colours) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<unsigned> colour(0, colours - 1);
+  std::vector<Code> codes(n);
+  for (Code& code : codes) {
+    for (unsigned i = 0; i < pegs; ++i) code = code.with_peg(i, colour(rng));
+  }
+  return codes;
+}
+
+// Args: pegs, colours, candidate count.
+void run_kernel(benchmark::State& state, Kernel kernel, Isa isa) {
+  if (!isa_supported(isa)) {
+    state.SkipWithError("the CPU lacks this ISA");
+    return;
+  }
+  const auto pegs = static_cast<unsigned>(state.range(0));
+  const auto colours = static_cast<unsigned>(state.range(1));
+  const auto n = static_cast<std::size_t>(state.range(2));
+  const std::vector<Code> candidates = random_codes(n, pegs, colours);
+  const Code guess = random_codes(1, pegs, colours).front();
+  std::vector<Feedback> out(n);
+  for (auto _ : state) {
+    kernel(guess, candidates.data(), n, out.data(), pegs);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(state.iterations() * n * sizeof(Code)));
+}
+
+void score_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"pegs", "colours", "n"});
+  b->Args({4, 6, 1296});
+  b->Args({5, 8, 32768});
+  b->Args({6, 10, 1 << 20});
+}
+
+void BM_ScoreBatch_scalar(benchmark::State& state) {
+  run_kernel(state, kernels::score_batch_scalar, Isa::kScalar);
+}
+BENCHMARK(BM_ScoreBatch_scalar)->Apply(score_args);
+
+#if defined(MASTERMYR_HAVE_AVX2)
+void BM_ScoreBatch_avx2(benchmark::State& state) {
+  run_kernel(state, kernels::score_batch_avx2, Isa::kAvx2);
+}
+BENCHMARK(BM_ScoreBatch_avx2)->Apply(score_args);
+#endif
+
+#if defined(MASTERMYR_HAVE_AVX512)
+void BM_ScoreBatch_avx512(benchmark::State& state) {
+  run_kernel(state, kernels::score_batch_avx512, Isa::kAvx512);
+}
+BENCHMARK(BM_ScoreBatch_avx512)->Apply(score_args);
+#endif
+
+#if defined(MASTERMYR_HAVE_NEON)
+void BM_ScoreBatch_neon(benchmark::State& state) {
+  run_kernel(state, kernels::score_batch_neon, Isa::kNeon);
+}
+BENCHMARK(BM_ScoreBatch_neon)->Apply(score_args);
+#endif
+
+}  // namespace
+}  // namespace mastermyr
@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr {
+namespace {
+
+// Single-threaded, so results compare across machines and releases.
+SolverOptions bench_options(Strategy strategy) {
+  SolverOptions options;
+  options.strategy = strategy;
+  options.search_opening = true;
+  return options;
+}
+
+const Strategy kStrategies[] = {Strategy::kMinimax, Strategy::kMaxParts,
+                                Strategy::kExpectedSize, Strategy::kEntropy};
+
+void strategy_args(benchmark::internal::Benchmark* b) {
+  b->ArgName("strategy")->DenseRange(0, std::size(kStrategies) - 1);
+}
+
+// Searches the opening move from scratch: the symmetric code space against
+// every code.
+template <unsigned Pegs, unsigned Colours>
+void BM_FirstMove(benchmark::State& state) {
+  const Strategy strategy = kStrategies[state.range(0)];
+  state.SetLabel(strategy_name(strategy));
+  Solver<Pegs, Colours> solver(bench_options(strategy));
+  for (auto _ : state) {
+    solver.reset();
+    benchmark::DoNotOptimize(solver.next_guess());
+  }
+}
+BENCHMARK(BM_FirstMove<4, 6>)->Apply(strategy_args);
+BENCHMARK(BM_FirstMove<5, 8>)->Apply(strategy_args);
+BENCHMARK(BM_FirstMove<6, 10>)->Apply(strategy_args)->Unit(
+    benchmark::kMillisecond);
+
+// Plays whole games against a fixed sequence of random secrets; items are
+// games.
+template <unsigned Pegs, unsigned Colours>
+void BM_SolveGame(benchmark::State& state) {
+  using S = Solver<Pegs, Colours>;
+  SolverOptions options;
+  S solver(options);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<std::uint32_t> index(0, S::kCodeCount - 1);
+  std::uint64_t guesses = 0;
+  for (auto _ : state) {
+    const Code secret = code_at_index(index(rng), Pegs, Colours);
+    solver.reset();
+    while (!solver.solved()) {
+      const Code guess = solver.next_guess();
+      solver.record(guess, S::score(guess, secret));
+      ++guesses;
+    }
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  state.counters["guesses"] = benchmark::Counter(
+      static_cast<double>(guesses), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SolveGame<4, 6>);
+BENCHMARK(BM_SolveGame<5, 8>)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SolveGame<6, 10>)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mastermyr
@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/transposition_table.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr std::size_t kTableBytes = std::size_t{64} << 20;
+constexpr std::size_t kKeys = 1 << 16;
+
+std::vector<PositionKey> make_keys(std::uint64_t seed) {
+  std::vector<PositionKey> keys(kKeys);
+  std::uint64_t x = seed;
+  for (PositionKey& key : keys) {
+    // splitmix64
+    x += 0x9E3779B97F4A7C15ULL;
+    std::uint64_t z = x;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    key = {z ^ (z >> 31), z * 0x9E3779B97F4A7C15ULL};
+  }
+  return keys;
+}
+
+// Shared by the threads of the multi-threaded runs.
+TranspositionTable& filled_table(const std::vector<PositionKey>& keys) {
+  static TranspositionTable table(kTableBytes);
+  static const bool filled = [&] {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      table.store(keys[i], {Code(static_cast<std::uint32_t>(i)), 1.0f});
+    }
+    return true;
+  }();
+  benchmark::DoNotOptimize(filled);
+  return table;
+}
+
+void BM_TableHit(benchmark::State& state) {
+  static const std::vector<PositionKey> keys = make_keys(1);
+  TranspositionTable& table = filled_table(keys);
+  std::size_t i = static_cast<std::size_t>(state.thread_index()) * 977;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(table.lookup(keys[i++ % kKeys]));
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_TableHit)->Threads(1)->Threads(4);
+
+void BM_TableMiss(benchmark::State& state) {
+  static const std::vector<PositionKey> stored = make_keys(1);
+  static const std::vector<PositionKey> keys = make_keys(2);
+  TranspositionTable& table = filled_table(stored);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(table.lookup(keys[i++ % kKeys]));
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_TableMiss);
+
+void BM_TableStore(benchmark::State& state) {
+  const std::vector<PositionKey> keys = make_keys(3);
+  TranspositionTable table(kTableBytes);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    table.store(keys[i % kKeys], {Code(static_cast<std::uint32_t>(i)), 1.0f});
+    ++i;
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_TableStore);
+
+// Hashing the candidate set is the other half of every probe. Arg: n, the
+// first n codes of the 5x8 board.
+void BM_PositionKey(benchmark::State& state) {
+  CandidateSet full;
+  full.assign_all(5, 8);
+  CandidateSet set(static_cast<std::size_t>(state.range(0)));
+  for (std::size_t i = 0; i < set.capacity(); ++i) {
+    set.push_back(full[i], full.ids()[i]);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(position_key(set, 0));
+  }
+  state.SetItemsProcessed(
+      static_cast<std::int64_t>(state.iterations() * set.size()));
+}
+BENCHMARK(BM_PositionKey)->ArgName("n")->Arg(16)->Arg(256)->Arg(4096);
+
+}  // namespace
+}  // namespace mastermyr
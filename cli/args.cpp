@@ -0,0 +1,49 @@
+#include "args.hpp"
+
+#include <charconv>
+
+namespace mastermyr::cli {
+
+Args::Args(int argc, char** argv, int first) {
+  for (int i = first; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (!arg.starts_with("--")) {
+      positional_.emplace_back(arg);
+      continue;
+    }
+    arg.remove_prefix(2);
+    if (const auto eq = arg.find('='); eq != std::string_view::npos) {
+      options_.emplace(arg.substr(0, eq), arg.substr(eq + 1));
+    } else if (i + 1 < argc &&
+               !std::string_view(argv[i + 1]).starts_with("--")) {
+      options_.emplace(arg, argv[++i]);
+    } else {
+      options_.emplace(arg, "");
+    }
+  }
+}
+
+bool Args::has(std::string_view name) const {
+  return options_.find(name) != options_.end();
+}
+
+std::string Args::get(std::string_view name, std::string_view fallback) const {
+  const auto it = options_.find(name);
+  return std::string(it == options_.end() ? fallback : it->second);
+}
+
+unsigned Args::get_unsigned(std::string_view name, unsigned fallback) const {
+  const auto it = options_.find(name);
+  if (it == options_.end()) return fallback;
+  const std::string& text = it->second;
+  unsigned value = 0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc() || end != text.data() + text.size()) {
+    throw UsageError("--" + std::string(name) + " expects a number, got '" +
+                     text + "'");
+  }
+  return value;
+}
+
+}  // namespace mastermyr::cli
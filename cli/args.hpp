@@ -0,0 +1,32 @@
+#pragma once
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mastermyr::cli {
+
+class UsageError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Minimal `--name value`, `--name=value` and `--flag` parser. A name not
+// followed by a value (end of input or another --option) is a flag.
+class Args {
+ public:
+  Args(int argc, char** argv, int first);
+
+  bool has(std::string_view name) const;
+  std::string get(std::string_view name, std::string_view fallback) const;
+  unsigned get_unsigned(std::string_view name, unsigned fallback) const;
+  const std::vector<std::string>& positional() const { return positional_; }
+
+ private:
+  std::map<std::string, std::string, std::less<>> options_;
+  std::vector<std::string> positional_;
+};
+
+}  // namespace mastermyr::cli
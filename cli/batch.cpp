@@ -0,0 +1,55 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "commands.hpp"
+#include "mastermyr/batch_solver.hpp"
+#include "mastermyr/metrics.hpp"
+#include "mastermyr/wire.hpp"
+
+namespace mastermyr::cli {
+
+int run_batch(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  const std::string input_path = args.get("input", "-");
+  const std::string output_path = args.get("output", "-");
+  const unsigned chunk = args.get_unsigned("batch", 1u << 16);
+  if (chunk == 0) throw UsageError("--batch must be positive");
+
+  std::ifstream input_file;
+  if (input_path != "-") {
+    input_file.open(input_path, std::ios::binary);
+    if (!input_file) throw UsageError("cannot open " + input_path);
+  }
+  std::ofstream output_file;
+  if (output_path != "-") {
+    output_file.open(output_path, std::ios::binary | std::ios::trunc);
+    if (!output_file) throw UsageError("cannot create " + output_path);
+  }
+  std::istream& input = input_path == "-" ? std::cin : input_file;
+  std::ostream& output = output_path == "-" ? std::cout : output_file;
+
+  BatchSolver solver(key.pegs, key.colours, solver_options(args, key));
+  wire::GameStateReader reader(input);
+  std::vector<std::byte> answers;
+  std::uint64_t unique_states = 0;
+  for (auto states = reader.next_batch(chunk); !states.empty();
+       states = reader.next_batch(chunk)) {
+    answers.clear();
+    solver.answer(states, answers);
+    unique_states += solver.last_stats().unique_states;
+    output.write(reinterpret_cast<const char*>(answers.data()),
+                 static_cast<std::streamsize>(answers.size()));
+  }
+  output.flush();
+  if (!output) throw std::runtime_error("cannot write " + output_path);
+  if (args.has("stats")) {
+    std::cerr << reader.count() << " states, " << unique_states
+              << " solved after merging equal positions\n";
+    metrics::write(std::cerr, metrics::snapshot());
+  }
+  return 0;
+}
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "commands.hpp"
+#include "mastermyr/opening_book.hpp"
+
+namespace mastermyr::cli {
+
+int run_book(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  const std::string input_path = args.get("input", "-");
+  const unsigned states = args.get_unsigned("states", 4096);
+  if (states == 0) throw UsageError("--states must be positive");
+  std::ifstream input_file;
+  if (input_path != "-") {
+    input_file.open(input_path, std::ios::binary);
+    if (!input_file) throw UsageError("cannot open " + input_path);
+  }
+  std::istream& input = input_path == "-" ? std::cin : input_file;
+
+  // The book has to be built with the options of the servers it is for, so
+  // that it plays the guesses their searches would.
+  const SolverOptions options = solver_options(args, key);
+  const auto start = std::chrono::steady_clock::now();
+  HistoryCounts counts(key, args.get_unsigned("depth",
+                                              HistoryCounts::kDefaultDepth));
+  counts.ingest(input);
+  const auto counted = std::chrono::steady_clock::now();
+  const StrategyTree book = build_opening_book(counts, states, options);
+  const std::chrono::duration<double> ingest_time = counted - start;
+  const std::chrono::duration<double> build_time =
+      std::chrono::steady_clock::now() - counted;
+
+  std::filesystem::path output = args.get("output", "");
+  if (output.empty()) {
+    output = cache_dir_from_args(args) /
+             opening_book_name(key, options.strategy);
+    std::filesystem::create_directories(output.parent_path());
+  }
+  book.save(output);
+  std::cout << counts.games() << " games (" << counts.skipped()
+            << " skipped), " << counts.size() << " positions counted in "
+            << ingest_time.count() << "s\n"
+            << output.string() << ": " << book.size() << " positions, "
+            << std::fixed << std::setprecision(1)
+            << 100 * book_coverage(book, counts)
+            << "% of those played, built in " << std::defaultfloat
+            << build_time.count() << "s\n";
+  return 0;
+}
+
+}  // namespace mastermyr::cli
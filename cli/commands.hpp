@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+
+#include "args.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr::cli {
+
+// Each command returns the process exit status.
+int run_play(const Args& args);
+int run_solve(const Args& args);
+int run_compile(const Args& args);
+int run_serve(const Args& args);
+int run_batch(const Args& args);
+int run_book(const Args& args);
+int run_evaluate(const Args& args);
+int run_coordinate(const Args& args);
+int run_work(const Args& args);
+
+// --pegs and --colours; throws UsageError for a board outside the code
+// encoding (at most 8 pegs and 16 colours).
+BoardKey board_from_args(const Args& args);
+
+// --variant, default mastermind; throws UsageError for an unknown name.
+Variant variant_from_args(const Args& args);
+
+// --cache-dir, else default_cache_dir().
+std::filesystem::path cache_dir_from_args(const Args& args);
+
+// Solver options from the board options, including the thread pool and the
+// cached feedback table.
+SolverOptions solver_options(const Args& args, const BoardKey& key);
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,33 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "commands.hpp"
+#include "mastermyr/strategy_tree.hpp"
+
+namespace mastermyr::cli {
+
+int run_compile(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  const SolverOptions options = solver_options(args, key);
+  const auto start = std::chrono::steady_clock::now();
+  const StrategyTree tree =
+      StrategyTree::compile(key.pegs, key.colours, options);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::filesystem::path output = args.get("output", "");
+  if (output.empty()) {
+    output = cache_dir_from_args(args) /
+             strategy_tree_name(key, options.strategy);
+    std::filesystem::create_directories(output.parent_path());
+  }
+  tree.save(output);
+  std::cout << output.string() << ": " << tree.size() << " nodes, at most "
+            << tree.depth() << " guesses, compiled in " << elapsed.count()
+            << "s\n";
+  return 0;
+}
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,91 @@
+#include <pthread.h>
+#include <signal.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "commands.hpp"
+#include "mastermyr/distributed.hpp"
+#include "mastermyr/strategy_tree.hpp"
+
+namespace mastermyr::cli {
+namespace {
+
+std::uint16_t port_from_args(const Args& args, std::uint16_t fallback) {
+  const unsigned port = args.get_unsigned("port", fallback);
+  if (port > 0xFFFF) throw UsageError("--port must be below 65536");
+  return static_cast<std::uint16_t>(port);
+}
+
+}  // namespace
+
+int run_coordinate(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  CoordinatorOptions coordinator_options;
+  coordinator_options.host = args.get("host", coordinator_options.host);
+  coordinator_options.port = port_from_args(args, coordinator_options.port);
+  coordinator_options.checkpoint_dir = args.get("checkpoint", "");
+  const SolverOptions options = solver_options(args, key);
+
+  std::filesystem::path output = args.get("output", "");
+  if (output.empty()) {
+    output = cache_dir_from_args(args) /
+             strategy_tree_name(key, options.strategy);
+  }
+  if (output.has_parent_path()) {
+    std::filesystem::create_directories(output.parent_path());
+  }
+
+  // Blocked before any thread starts so that only the waiter receives them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  const auto start = std::chrono::steady_clock::now();
+  Coordinator coordinator(coordinator_options, key.pegs, key.colours,
+                          options);
+  std::cout << "coordinating " << key.pegs << "x" << key.colours << " on "
+            << coordinator_options.host << ":" << coordinator.port() << ": "
+            << coordinator.jobs() << " jobs, " << coordinator.completed()
+            << " from checkpoints" << std::endl;
+  std::jthread waiter([&] {
+    int signal = 0;
+    sigwait(&signals, &signal);
+    coordinator.stop();
+  });
+  const std::optional<StrategyTree> tree = coordinator.run();
+  // The waiter is still in sigwait when the jobs finished on their own.
+  pthread_kill(waiter.native_handle(), SIGTERM);
+  if (!tree) {
+    std::cout << "stopped with " << coordinator.completed() << " of "
+              << coordinator.jobs() << " jobs done\n";
+    return 1;
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  tree->save(output);
+  std::cout << output.string() << ": " << tree->size() << " nodes, at most "
+            << tree->depth() << " guesses, compiled in " << elapsed.count()
+            << "s\n";
+  return 0;
+}
+
+int run_work(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  const SolverOptions options = solver_options(args, key);
+  const std::string host = args.get("host", "127.0.0.1");
+  const std::uint16_t port =
+      port_from_args(args, CoordinatorOptions{}.port);
+  const unsigned connections = args.get_unsigned("connections", 1);
+  const std::size_t jobs = run_worker(host, port, options, connections);
+  std::cout << jobs << " jobs compiled\n";
+  return 0;
+}
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,52 @@
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+
+#include "commands.hpp"
+#include "mastermyr/strategy_tree.hpp"
+
+namespace mastermyr::cli {
+
+int run_evaluate(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  const SolverOptions options = solver_options(args, key);
+
+  // Every game shares one tree: compiling it solves each distinct position
+  // once, where playing the secrets one by one would repeat the opening
+  // searches for every game.
+  std::optional<StrategyTree> tree;
+  if (args.has("tree")) {
+    tree = StrategyTree::load(args.get("tree", ""), key);
+  } else {
+    const auto start = std::chrono::steady_clock::now();
+    tree = StrategyTree::compile(key.pegs, key.colours, options);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "compiled " << tree->size() << " nodes in "
+              << elapsed.count() << "s\n";
+    if (const std::string output = args.get("output", ""); !output.empty()) {
+      tree->save(output);
+    }
+  }
+
+  const TreeEvaluation result = evaluate(*tree, options.pool.get());
+  std::cout << key.pegs << "x" << key.colours << ' '
+            << strategy_name(tree->strategy()) << ": " << result.secrets()
+            << " secrets, average " << std::fixed << std::setprecision(4)
+            << result.average() << " guesses, worst " << result.worst()
+            << '\n';
+  for (std::size_t n = 1; n < result.games.size(); ++n) {
+    std::cout << std::setw(4) << n << ' ' << std::setw(9) << result.games[n]
+              << '\n';
+  }
+  if (result.failures != 0) {
+    std::cout << result.failures << " secrets not solved\n";
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,106 @@
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "args.hpp"
+#include "commands.hpp"
+
+namespace {
+
+constexpr std::string_view kUsage =
+    "usage: mastermyr <command> [options]\n"
+    "\n"
+    "commands:\n"
+    "  play     solve a code you think of, reading feedback from stdin\n"
+    "  solve    solve --secret CODE and print every move\n"
+    "  compile  write the board's strategy tree to --output FILE\n"
+    "           (default: in the cache directory)\n"
+    "  evaluate play every secret (through --tree FILE, else a tree\n"
+    "           compiled in parallel, saved to --output FILE) and print\n"
+    "           the guess-count distribution\n"
+    "  serve    answer next-guess requests over TCP on --host (0.0.0.0)\n"
+    "           and --port (7411) with --io-threads event loops (1),\n"
+    "           answering from the opening book --book FILE first and\n"
+    "           reloading it on SIGHUP\n"
+    "  batch    answer wire game-state frames from --input FILE (stdin)\n"
+    "           into answer frames on --output FILE (stdout)\n"
+    "  book     count the positions of the recorded games in --input\n"
+    "           FILE (stdin) up to --depth N moves (6) and write the\n"
+    "           --states N (4096) most frequent the solver reaches as an\n"
+    "           opening book to --output FILE (default: in the cache\n"
+    "           directory)\n"
+    "  coordinate compile the strategy tree on workers connecting to\n"
+    "           --port (7412), keeping results in --checkpoint DIR, and\n"
+    "           write it to --output FILE (default: in the cache directory)\n"
+    "  work     compile jobs for the coordinator at --host (127.0.0.1)\n"
+    "           and --port (7412) over --connections N (1)\n"
+    "\n"
+    "board options:\n"
+    "  --pegs N         pegs per code (default 4)\n"
+    "  --colours N      colours per peg (default 6)\n"
+    "  --variant NAME   play/solve: mastermind, no-duplicates (alias\n"
+    "                   bulls-and-cows, e.g. on 4x10) or static, each on\n"
+    "                   the boards compiled for it (default mastermind)\n"
+    "  --strategy NAME  minimax, max-parts, expected-size or entropy\n"
+    "                   (default minimax)\n"
+    "  --max-guesses N  guesses evaluated per move (default 4096)\n"
+    "  --reservoir N    boards without a specialisation (e.g. 8x12):\n"
+    "                   candidates sampled per move (default 1024)\n"
+    "  --budget N       consistent codes enumerated per move; larger sets\n"
+    "                   get N / pegs random descents (default 262144)\n"
+    "  --estimate-from N rank guesses on a sample of the candidates when\n"
+    "                   at least N remain, rating 16 finalists exactly\n"
+    "                   (default 16384, never below 4096; 0: rate every\n"
+    "                   guess exactly)\n"
+    "  --time-budget US search each move for at most US microseconds and\n"
+    "                   play the best guess found (default 0: no limit)\n"
+    "  --search-opening search the first move instead of playing 0011..\n"
+    "  --threads N      search threads (default: all cores)\n"
+    "  --numa           pin threads across NUMA nodes; serve also keeps\n"
+    "                   each connection and a table copy on one node\n"
+    "  --no-prune       rate every guess fully (no branch and bound)\n"
+    "  --no-symmetry    rate symmetric guesses separately\n"
+    "  --backend NAME   auto, cpu, host or cuda: scorer of big searches\n"
+    "                   (default auto: cuda when a device is present)\n"
+    "  --tt-size MIB    cache searched positions in a table of this size\n"
+    "  --cache-dir DIR  feedback table cache (default ~/.cache/mastermyr)\n"
+    "  --no-cache       score every move instead of using the table\n"
+    "  --tree FILE      play/solve from a compiled strategy tree\n"
+    "  --stats          solve/batch/serve: print memory use and, in a\n"
+    "                   MASTERMYR_METRICS build, counters and timers;\n"
+    "                   solve also prints each move's search\n";
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace mastermyr::cli;
+  if (argc < 2) {
+    std::cerr << kUsage;
+    return 2;
+  }
+  const std::string_view command = argv[1];
+  try {
+    const Args args(argc, argv, 2);
+    if (command == "play") return run_play(args);
+    if (command == "solve") return run_solve(args);
+    if (command == "compile") return run_compile(args);
+    if (command == "serve") return run_serve(args);
+    if (command == "batch") return run_batch(args);
+    if (command == "book") return run_book(args);
+    if (command == "evaluate") return run_evaluate(args);
+    if (command == "coordinate") return run_coordinate(args);
+    if (command == "work") return run_work(args);
+    if (command == "help" || command == "--help") {
+      std::cout << kUsage;
+      return 0;
+    }
+    throw UsageError("unknown command '" + std::string(command) + "'");
+  } catch (const UsageError& e) {
+    std::cerr << "mastermyr: " << e.what() << "\n\n" << kUsage;
+    return 2;
+  } catch (const std::exception& e) {
+    std::cerr << "mastermyr: " << e.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "commands.hpp"
+
+namespace mastermyr::cli {
+
+BoardKey board_from_args(const Args& args) {
+  const unsigned pegs = args.get_unsigned("pegs", 4);
+  const unsigned colours = args.get_unsigned("colours", 6);
+  if (!is_valid_board(pegs, colours)) {
+    throw UsageError("invalid board " + std::to_string(pegs) + "x" +
+                     std::to_string(colours));
+  }
+  return {pegs, colours, DuplicateRule::kAllowed};
+}
+
+Variant variant_from_args(const Args& args) {
+  const std::string name = args.get("variant", "mastermind");
+  const auto variant = parse_variant(name);
+  if (!variant) throw UsageError("unknown variant '" + name + "'");
+  return *variant;
+}
+
+SolverOptions solver_options(const Args& args, const BoardKey& key) {
+  SolverOptions options;
+  options.max_guesses = args.get_unsigned(
+      "max-guesses", static_cast<unsigned>(options.max_guesses));
+  options.search_opening = args.has("search-opening");
+  options.prune = !args.has("no-prune");
+  options.symmetry = !args.has("no-symmetry");
+  const std::string strategy =
+      args.get("strategy", strategy_name(options.strategy));
+  const auto parsed = parse_strategy(strategy);
+  if (!parsed) throw UsageError("unknown strategy '" + strategy + "'");
+  options.strategy = *parsed;
+  options.reservoir = args.get_unsigned(
+      "reservoir", static_cast<unsigned>(options.reservoir));
+  options.sample_budget = args.get_unsigned(
+      "budget", static_cast<unsigned>(options.sample_budget));
+  options.estimate_from = args.get_unsigned(
+      "estimate-from", static_cast<unsigned>(options.estimate_from));
+  options.time_budget =
+      std::chrono::microseconds(args.get_unsigned("time-budget", 0));
+  const unsigned threads =
+      args.get_unsigned("threads", ThreadPool::default_threads() + 1);
+  const auto placement = args.has("numa") ? ThreadPool::Placement::kPinned
+                                          : ThreadPool::Placement::kFloating;
+  if (threads > 1) {
+    options.pool = std::make_shared<ThreadPool>(threads - 1, placement);
+  }
+  try {
+    options.backend = make_partition_backend(args.get("backend", "auto"));
+  } catch (const std::invalid_argument& e) {
+    throw UsageError(e.what());
+  }
+  if (const unsigned mib = args.get_unsigned("tt-size", 0); mib > 0) {
+    options.transposition_table =
+        std::make_shared<TranspositionTable>(std::size_t{mib} << 20);
+  }
+  if (!args.has("no-cache") &&
+      code_count(key.pegs, key.colours) <= FeedbackMatrix::kDefaultMaxCodes) {
+    options.feedback_matrix = std::make_shared<const FeedbackMatrix>(
+        FeedbackMatrix::open(key, cache_dir_from_args(args)));
+  }
+  return options;
+}
+
+std::filesystem::path cache_dir_from_args(const Args& args) {
+  const std::string dir = args.get("cache-dir", "");
+  return dir.empty() ? default_cache_dir() : std::filesystem::path(dir);
+}
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "commands.hpp"
+#include "mastermyr/metrics.hpp"
+#include "mastermyr/solver.hpp"
+#include "mastermyr/strategy_tree.hpp"
+
+namespace mastermyr::cli {
+namespace {
+
+std::unique_ptr<GameSolver> solver_from_args(const Args& args) {
+  BoardKey key = board_from_args(args);
+  const Variant variant = variant_from_args(args);
+  if (args.has("tree")) {
+    if (variant != Variant::kMastermind) {
+      throw UsageError("--tree plays mastermind only");
+    }
+    return make_tree_solver(std::make_shared<const StrategyTree>(
+        StrategyTree::load(args.get("tree", ""), key)));
+  }
+  if (!is_supported_board(key.pegs, key.colours, variant)) {
+    throw UsageError(std::string("no ") + variant_name(variant) +
+                     " solver for the board");
+  }
+  // The feedback table has to cover the variant's code space.
+  key.duplicates = duplicate_rule(variant);
+  return make_solver(key.pegs, key.colours, variant,
+                     solver_options(args, key));
+}
+
+// Accepts "B W" or "BbWw".
+bool parse_feedback(const std::string& line, unsigned pegs, Feedback& out) {
+  std::string normalized = line;
+  for (char& ch : normalized) {
+    if (ch == 'b' || ch == 'w' || ch == 'B' || ch == 'W' || ch == ',') ch = ' ';
+  }
+  std::istringstream in(normalized);
+  unsigned black = 0;
+  unsigned white = 0;
+  if (!(in >> black >> white) || black + white > pegs) return false;
+  out = Feedback(black, white);
+  return true;
+}
+
+}  // namespace
+
+int run_play(const Args& args) {
+  auto solver = solver_from_args(args);
+  const unsigned pegs = solver->pegs();
+  std::cout << "Think of a " << pegs << "-peg code over colours 0-"
+            << solver->colours() - 1
+            << ". Answer each guess with black and white counts, "
+               "e.g. \"1 2\".\n";
+  unsigned turn = 0;
+  while (!solver->solved()) {
+    const Code guess = solver->next_guess();
+    std::cout << "guess " << ++turn << ": " << to_string(guess, pegs) << "\n> "
+              << std::flush;
+    Feedback feedback;
+    std::string line;
+    while (true) {
+      if (!std::getline(std::cin, line)) return 1;
+      if (parse_feedback(line, pegs, feedback)) break;
+      std::cout << "expected two counts summing to at most " << pegs << "\n> "
+                << std::flush;
+    }
+    solver->record(guess, feedback);
+  }
+  std::cout << "solved in " << turn << " guesses\n";
+  return 0;
+}
+
+int run_solve(const Args& args) {
+  auto solver = solver_from_args(args);
+  const unsigned pegs = solver->pegs();
+  const auto secret =
+      parse_code(args.get("secret", ""), pegs, solver->colours());
+  if (!secret ||
+      (duplicate_rule(variant_from_args(args)) == DuplicateRule::kForbidden &&
+       has_repeated_colour(*secret, pegs))) {
+    throw UsageError("--secret must be a code for the board");
+  }
+  const bool stats = args.has("stats");
+  unsigned turn = 0;
+  while (!solver->solved()) {
+    const Code guess = solver->next_guess();
+    const SearchStats search = solver->last_search();
+    const Feedback feedback = score(guess, *secret, pegs);
+    solver->record(guess, feedback);
+    std::cout << ++turn << ": " << to_string(guess, pegs) << ' '
+              << to_string(feedback) << " (" << solver->remaining()
+              << " left)";
+    if (stats && search.space > 0) {
+      std::cout << " rated " << search.visited << '/' << search.space
+                << " in " << search.elapsed.count() / 1000 << " us, gap "
+                << search.gap();
+    }
+    std::cout << '\n';
+  }
+  if (stats) {
+    const ArenaStats arena = solver->arena_stats();
+    std::cout << "arena: peak " << arena.peak << " bytes, reserved "
+              << arena.reserved << " bytes\n";
+    metrics::write(std::cout, metrics::snapshot());
+  }
+  return 0;
+}
+
+}  // namespace mastermyr::cli
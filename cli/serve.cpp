@@ -0,0 +1,111 @@
+#include <pthread.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "commands.hpp"
+#include "mastermyr/numa.hpp"
+#include "mastermyr/server.hpp"
+#include "mastermyr/strategy_tree.hpp"
+
+namespace mastermyr::cli {
+
+int run_serve(const Args& args) {
+  const BoardKey key = board_from_args(args);
+  ServerOptions server_options;
+  server_options.host = args.get("host", server_options.host);
+  const unsigned port = args.get_unsigned("port", server_options.port);
+  if (port > 0xFFFF) throw UsageError("--port must be below 65536");
+  server_options.port = static_cast<std::uint16_t>(port);
+  server_options.io_threads =
+      args.get_unsigned("io-threads", server_options.io_threads);
+  server_options.numa = args.has("numa");
+  if (server_options.numa) {
+    server_options.io_threads =
+        std::max(server_options.io_threads, numa::nodes());
+  }
+
+  // Solvers share the pool, feedback table and transposition table; the
+  // request tasks run on the same pool as the searches they start. With
+  // --numa each node reads its own copy of the tables, picked by the pool
+  // thread that builds the solver.
+  SolverOptions options = solver_options(args, key);
+  if (!options.pool) options.pool = std::make_shared<ThreadPool>(0);
+  SolverFactory factory = [key, options] {
+    return make_solver(key.pegs, key.colours, options);
+  };
+  if (server_options.numa && options.feedback_matrix) {
+    auto matrices = std::make_shared<numa::Replicated<FeedbackMatrix>>(
+        options.feedback_matrix);
+    factory = [key, options, matrices] {
+      SolverOptions local = options;
+      local.feedback_matrix = matrices->local();
+      return make_solver(key.pegs, key.colours, std::move(local));
+    };
+  }
+  if (args.has("tree")) {
+    auto tree = std::make_shared<const StrategyTree>(
+        StrategyTree::load(args.get("tree", ""), key));
+    if (!tree->complete()) {
+      throw UsageError(args.get("tree", "") +
+                       " is an opening book, not a complete tree; pass it "
+                       "as --book");
+    }
+    if (server_options.numa) {
+      auto trees = std::make_shared<numa::Replicated<StrategyTree>>(tree);
+      factory = [trees] { return make_tree_solver(trees->local()); };
+    } else {
+      factory = [tree] { return make_tree_solver(tree); };
+    }
+  }
+
+  // Blocked before any thread starts so that only the waiter receives them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigaddset(&signals, SIGHUP);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  Server server(server_options, key.pegs, key.colours, std::move(factory),
+                options.pool);
+  const std::string book_file = args.get("book", "");
+  auto load_book = [&] {
+    server.set_book(std::make_shared<const StrategyTree>(
+        StrategyTree::load(book_file, key)));
+    std::cout << "book " << book_file << ": " << server.book()->size()
+              << " positions" << std::endl;
+  };
+  if (!book_file.empty()) load_book();
+  std::cout << "serving " << key.pegs << "x" << key.colours << " on "
+            << server_options.host << ":" << server.port() << std::endl;
+  std::jthread waiter([&] {
+    int signal = 0;
+    while (sigwait(&signals, &signal) == 0 && signal == SIGHUP) {
+      // A book that fails to load leaves the one being served in place.
+      if (book_file.empty()) continue;
+      try {
+        load_book();
+      } catch (const std::exception& e) {
+        std::cerr << "mastermyr: keeping the old book: " << e.what()
+                  << std::endl;
+      }
+    }
+    server.stop();
+  });
+  server.run();
+  // The waiter is still in sigwait when the loops stopped on their own.
+  pthread_kill(waiter.native_handle(), SIGTERM);
+  if (args.has("stats")) {
+    std::cout << server.stats();
+  } else {
+    std::cout << server.requests() << " requests served\n";
+  }
+  return 0;
+}
+
+}  // namespace mastermyr::cli
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace mastermyr {
+
+struct ArenaStats {
+  std::size_t used = 0;      // bytes handed out since the last release()
+  std::size_t peak = 0;      // largest `used` ever seen
+  std::size_t reserved = 0;  // bytes held from the upstream resource
+};
+
+// Monotonic memory resource for the scratch of one game. Allocation bumps a
+// pointer through chunks taken from the upstream resource; deallocation is a
+// no-op; release() rewinds to the first chunk in O(1) and keeps the chunks,
+// so a solver that plays game after game stops touching the upstream
+// allocator once its arena has grown to the largest game's needs.
+//
+// Not thread-safe: one arena belongs to one solver.
+class GameArena final : public std::pmr::memory_resource {
+ public:
+  static constexpr std::size_t kDefaultChunk = std::size_t{64} << 10;
+
+  explicit GameArena(
+      std::size_t first_chunk = kDefaultChunk,
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+  ~GameArena() override;
+
+  GameArena(const GameArena&) = delete;
+  GameArena& operator=(const GameArena&) = delete;
+
+  // Invalidates everything allocated so far.
+  void release();
+
+  ArenaStats stats() const { return {used_, peak_, reserved_}; }
+
+ private:
+  struct Chunk {
+    std::byte* data;
+    std::size_t size;
+    std::size_t alignment;
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void*, std::size_t, std::size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource& other)
+      const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream_;
+  std::vector<Chunk> chunks_;
+  std::size_t current_ = 0;  // chunk being bumped through
+  std::size_t offset_ = 0;   // next free byte in it
+  std::size_t used_ = 0;
+  std::size_t peak_ = 0;
+  std::size_t reserved_ = 0;
+};
+
+}  // namespace mastermyr
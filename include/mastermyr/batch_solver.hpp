@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/solver.hpp"
+#include "mastermyr/wire.hpp"
+
+namespace mastermyr {
+
+// The moves of one game so far.
+using History = std::span<const Move>;
+
+struct BatchStats {
+  std::size_t games = 0;
+  std::size_t unique_states = 0;
+};
+
+// Answers next_guess() for many independent games at once. Games whose
+// histories hold the same moves reach the same position, so each distinct
+// position is solved once and its guess is copied to every game at it. The
+// order of the moves does not matter for the position -- the candidates and
+// the symmetries left are the same -- so histories are compared as sorted
+// sets of moves, which also merges transpositions of the same guesses.
+//
+// Distinct positions are solved in parallel on the options' pool, one solver
+// per participant, kept between calls.
+class BatchSolver {
+ public:
+  // Throws std::invalid_argument for a board without a specialisation.
+  BatchSolver(unsigned pegs, unsigned colours, SolverOptions options = {});
+
+  // The next guess of each game, or nullopt where its feedback is
+  // inconsistent.
+  std::vector<std::optional<Code>> next_guesses(std::span<const History> games);
+  // Same for games decoded in place from wire frames.
+  std::vector<std::optional<Code>> next_guesses(
+      std::span<const wire::GameStateView> games);
+
+  // Appends one wire answer frame per state, in order. States for another
+  // board are answered kUnsupported and states with malformed moves
+  // kInvalid; both count towards last_stats().games.
+  void answer(std::span<const wire::GameStateView> states,
+              std::vector<std::byte>& out);
+
+  // Counts from the last next_guesses() call.
+  const BatchStats& last_stats() const { return stats_; }
+
+ private:
+  // A position's moves in canonical order, packed guess | feedback << 32.
+  using Key = std::vector<std::uint64_t>;
+
+  template <typename Game>
+  std::vector<std::optional<Code>> solve_all(std::span<const Game> games);
+  std::optional<Code> solve(GameSolver& solver, const Key& key);
+
+  unsigned pegs_;
+  unsigned colours_;
+  SolverOptions options_;
+  std::vector<std::unique_ptr<GameSolver>> solvers_;
+  BatchStats stats_;
+};
+
+}  // namespace mastermyr
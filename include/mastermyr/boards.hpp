@@ -0,0 +1,19 @@
+#pragma once
+
+// Board sizes that get a compile-time specialised Solver. X(pegs, colours) is
+// expanded once per board wherever a specialisation has to be named, e.g. for
+// explicit instantiation and for runtime dispatch.
+#define MASTERMYR_FOR_EACH_BOARD(X) \
+  X(4, 6)                           \
+  X(5, 8)                           \
+  X(6, 10)
+
+// Variant boards with a specialised Solver, as X(pegs, colours, rules) with
+// rules one of the Rules aliases of rules.hpp. 4x10 without duplicates is
+// Bulls & Cows. Static Mastermind builds its probe set over the whole board
+// per probe, so it is only compiled for a board small enough to do so.
+#define MASTERMYR_FOR_EACH_VARIANT_BOARD(X) \
+  X(4, 6, NoDuplicates)                     \
+  X(5, 8, NoDuplicates)                     \
+  X(4, 10, NoDuplicates)                    \
+  X(4, 6, StaticMastermind)
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/propagator.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr {
+
+// Produces the codes consistent with a history one at a time, without ever
+// materialising the code space, for boards too large to enumerate (8x12 has
+// 430 million codes).
+//
+// A depth-first search assigns one peg at a time and keeps, per past move,
+// the blacks and the colour matches forced by the pegs assigned so far. Each
+// can only grow by one per remaining peg, so a prefix is cut as soon as some
+// move's blacks or matches exceed its feedback or can no longer reach it;
+// whole subtrees of inconsistent codes are skipped without being visited.
+// The search is resumable and its state is O(pegs x moves).
+//
+// The search starts from a Propagator's fixpoint: each peg only tries the
+// colours in its domain, and a prefix is also cut when it uses a colour
+// more often than its bound allows or leaves too few pegs for the colours
+// still owed their minimum. A history the propagator proves inconsistent
+// produces nothing without a search.
+//
+// With a non-zero seed every node tries the colours in its own random order;
+// with seed 0 the order is lexicographic in pegs 0, 1, ... Either way the
+// search finishes a subtree before it starts the next, so a prefix of the
+// codes produced shares its first pegs and is no sample of the set. draw()
+// samples instead: it descends from the root with a random colour per peg.
+class CandidateGenerator {
+ public:
+  CandidateGenerator(unsigned pegs, unsigned colours,
+                     std::span<const Move> history, std::uint64_t seed = 0);
+  // Over the codes consistent with `propagator`'s history; the propagator
+  // is only read during construction.
+  explicit CandidateGenerator(const Propagator& propagator,
+                              std::uint64_t seed = 0);
+
+  // The next consistent code, or nullopt once all have been produced.
+  std::optional<Code> next();
+
+  // A consistent code drawn by a random descent: each peg takes a colour
+  // picked uniformly from those the assigned prefix can still take, or the
+  // draw ends at a dead end, a prefix no colour extends, and returns
+  // nullopt. `weight` is set to the product of the number of colours each
+  // peg had to pick from, the inverse of the code's chance of being drawn,
+  // and to 0 at a dead end; its mean over draws is an unbiased estimate of
+  // the number of consistent codes (Knuth's estimator). Codes in sparse
+  // subtrees are drawn more often than others, so uniform sampling weights
+  // each draw by `weight`.
+  //
+  // A generator is used for next() or for draw(), not both: draw() starts
+  // at the root and would clash with the prefix of a search under way.
+  std::optional<Code> draw(std::mt19937_64& rng, double& weight);
+
+  // Codes produced so far.
+  std::uint64_t produced() const { return produced_; }
+  bool exhausted() const { return exhausted_; }
+
+ private:
+  struct Constraint {
+    Code guess;
+    std::uint8_t blacks;
+    std::uint8_t total;  // blacks + whites
+    std::array<std::uint8_t, kMaxColours> counts;  // guess colour counts
+  };
+
+  // Adds colour `colour` at peg `depth`; returns false, leaving the state
+  // unchanged, if some constraint can no longer be met.
+  bool push(unsigned depth, unsigned colour);
+  void pop(unsigned depth, unsigned colour);
+  void shuffle_level(unsigned depth);
+
+  unsigned pegs_;
+  unsigned colours_;
+  std::vector<Constraint> constraints_;
+  // Per constraint, blacks and matches of the assigned prefix.
+  std::vector<std::uint8_t> blacks_;
+  std::vector<std::uint8_t> totals_;
+  std::array<std::uint8_t, kMaxColours> assigned_counts_{};
+  // Propagated domains and colour bounds, and the pegs the prefix still
+  // owes to colours below their minimum.
+  std::array<Propagator::Domain, kMaxPegs> domains_{};
+  std::array<std::uint8_t, kMaxColours> lo_{};
+  std::array<std::uint8_t, kMaxColours> hi_{};
+  unsigned deficit_ = 0;
+  // Per level, the domain's colours in trial order, how many there are and
+  // the next position in the order.
+  std::array<std::array<std::uint8_t, kMaxColours>, kMaxPegs> order_{};
+  std::array<unsigned, kMaxPegs> sizes_{};
+  std::array<unsigned, kMaxPegs> cursor_{};
+  Code code_;
+  unsigned depth_ = 0;
+  bool randomise_;
+  std::mt19937_64 rng_;
+  std::uint64_t produced_ = 0;
+  bool exhausted_ = false;
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+// The codes still consistent with a game's history, stored structure-of-arrays:
+// the packed codes in one cache-line aligned buffer that the scoring kernels
+// stream over, and alongside it each code's index in the board's code space
+// (see enumerate_codes).
+// Filtering compacts both arrays in place, so a set never allocates after it
+// has been sized for its board. Buffers come from a std::pmr resource, so a
+// scratch set can live in a GameArena; copies use the default resource.
+class CandidateSet {
+ public:
+  static constexpr std::size_t kAlignment = 64;
+
+  CandidateSet() = default;
+  explicit CandidateSet(std::size_t capacity,
+                        std::pmr::memory_resource* resource =
+                            std::pmr::get_default_resource())
+      : resource_(resource) {
+    reserve(capacity);
+  }
+
+  CandidateSet(const CandidateSet& other);
+  CandidateSet& operator=(const CandidateSet& other);
+  CandidateSet(CandidateSet&&) noexcept = default;
+  CandidateSet& operator=(CandidateSet&&) noexcept = default;
+
+  // Grows the buffers to hold at least `capacity` codes, keeping the contents.
+  void reserve(std::size_t capacity);
+
+  // Replaces the contents with every code of a pegs x colours board in index
+  // order, so that ids()[i] == i. Without duplicates the repeating codes are
+  // skipped and the ids are ranks among the rest, as in enumerate_codes.
+  void assign_all(unsigned pegs, unsigned colours,
+                  DuplicateRule duplicates = DuplicateRule::kAllowed);
+
+  void clear() { size_ = 0; }
+  void push_back(Code code, std::uint32_t id) {
+    if (size_ == capacity_) reserve(capacity_ < 8 ? 16 : capacity_ * 2);
+    codes_[size_] = code;
+    ids_[size_] = id;
+    ++size_;
+  }
+
+  // Keeps only the codes that score `feedback` against `guess`, preserving
+  // their order.
+  void filter(Code guess, Feedback feedback, unsigned pegs);
+
+  // Same, reading the feedback of each candidate from a precomputed row
+  // indexed by candidate id (see FeedbackMatrix::row) instead of scoring.
+  void filter(std::span<const Feedback> row, Feedback feedback);
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  Code operator[](std::size_t i) const { return codes_[i]; }
+  std::span<const Code> codes() const { return {codes_.get(), size_}; }
+  std::span<const std::uint32_t> ids() const { return {ids_.get(), size_}; }
+
+ private:
+  struct BufferDelete {
+    std::pmr::memory_resource* resource;
+    std::size_t bytes;
+    void operator()(void* p) const {
+      resource->deallocate(p, bytes, kAlignment);
+    }
+  };
+  template <typename T>
+  using Buffer = std::unique_ptr<T[], BufferDelete>;
+
+  template <typename T>
+  Buffer<T> allocate(std::size_t n);
+
+  std::pmr::memory_resource* resource_ = std::pmr::get_default_resource();
+  Buffer<Code> codes_;
+  Buffer<std::uint32_t> ids_;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = 0;
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mastermyr {
+
+inline constexpr unsigned kBitsPerPeg = 4;
+inline constexpr unsigned kMaxPegs = 8;
+inline constexpr unsigned kMaxColours = 1u << kBitsPerPeg;
+
+// Nibble mask covering the first `pegs` pegs of a packed code.
+constexpr std::uint32_t peg_mask(unsigned pegs) {
+  return pegs >= kMaxPegs ? ~std::uint32_t{0}
+                          : (std::uint32_t{1} << (pegs * kBitsPerPeg)) - 1;
+}
+
+// A code packed as fixed-width 4-bit colour fields, peg 0 in the lowest
+// nibble. Nibbles past the board's peg count are always zero, so two codes of
+// the same board are equal iff their bits are equal.
+class Code {
+ public:
+  constexpr Code() = default;
+  constexpr explicit Code(std::uint32_t bits) : bits_(bits) {}
+
+  constexpr std::uint32_t bits() const { return bits_; }
+
+  constexpr unsigned peg(unsigned i) const {
+    return (bits_ >> (i * kBitsPerPeg)) & (kMaxColours - 1);
+  }
+
+  constexpr Code with_peg(unsigned i, unsigned colour) const {
+    const unsigned shift = i * kBitsPerPeg;
+    return Code((bits_ & ~(std::uint32_t{kMaxColours - 1} << shift)) |
+                (std::uint32_t{colour} << shift));
+  }
+
+  friend constexpr bool operator==(Code, Code) = default;
+  friend constexpr auto operator<=>(Code, Code) = default;
+
+ private:
+  std::uint32_t bits_ = 0;
+};
+
+static_assert(sizeof(Code) == sizeof(std::uint32_t),
+              "kernels load arrays of Code as packed 32-bit lanes");
+
+// Index of `code` in the full pegs x colours code space, with peg 0 as the
+// least significant base-`colours` digit. This is the order in which
+// CandidateSet::assign_all enumerates a board.
+constexpr std::uint32_t code_index(Code code, unsigned pegs, unsigned colours) {
+  std::uint32_t index = 0;
+  for (unsigned i = pegs; i-- > 0;) index = index * colours + code.peg(i);
+  return index;
+}
+
+constexpr Code code_at_index(std::uint32_t index, unsigned pegs,
+                             unsigned colours) {
+  Code code;
+  for (unsigned i = 0; i < pegs; ++i) {
+    code = code.with_peg(i, index % colours);
+    index /= colours;
+  }
+  return code;
+}
+
+// Whether a board's codes may repeat a colour. Bulls & Cows and the
+// no-duplicates variants forbid it.
+enum class DuplicateRule : std::uint8_t {
+  kAllowed = 0,
+  kForbidden = 1,
+};
+
+constexpr bool has_repeated_colour(Code code, unsigned pegs) {
+  unsigned seen = 0;
+  for (unsigned i = 0; i < pegs; ++i) {
+    const unsigned bit = 1u << code.peg(i);
+    if (seen & bit) return true;
+    seen |= bit;
+  }
+  return false;
+}
+
+// Black (right colour, right place) and white (right colour, wrong place)
+// counts packed into one byte as black << 4 | white.
+class Feedback {
+ public:
+  constexpr Feedback() = default;
+  constexpr explicit Feedback(std::uint8_t raw) : raw_(raw) {}
+  constexpr Feedback(unsigned black, unsigned white)
+      : raw_(static_cast<std::uint8_t>(black << 4 | white)) {}
+
+  constexpr std::uint8_t raw() const { return raw_; }
+  constexpr unsigned black() const { return raw_ >> 4; }
+  constexpr unsigned white() const { return raw_ & 0xF; }
+
+  friend constexpr bool operator==(Feedback, Feedback) = default;
+
+ private:
+  std::uint8_t raw_ = 0;
+};
+
+static_assert(sizeof(Feedback) == 1);
+
+// Feedback for a guess that is the secret.
+constexpr Feedback solved_feedback(unsigned pegs) { return Feedback(pegs, 0); }
+
+// Number of distinct raw feedback values a board of `pegs` pegs can produce,
+// i.e. the size of an array indexed by Feedback::raw().
+constexpr std::size_t feedback_slots(unsigned pegs) {
+  return (std::size_t{pegs} << 4) + 1;
+}
+
+// Number of (black, white) pairs with black + white <= pegs, and a dense
+// black-major rank over them. Stored tables indexed by feedback use the rank
+// rather than raw() to avoid the unused slots.
+constexpr std::size_t feedback_ranks(unsigned pegs) {
+  return std::size_t{pegs + 1} * (pegs + 2) / 2;
+}
+constexpr unsigned feedback_rank(Feedback feedback, unsigned pegs) {
+  const unsigned black = feedback.black();
+  return black * (pegs + 1) - black * (black - 1) / 2 + feedback.white();
+}
+
+// Reference scorer. Straightforward colour-histogram implementation that the
+// batched kernels are checked against.
+Feedback score(Code guess, Code secret, unsigned pegs);
+
+// Codes are written one character per peg, peg 0 first, using the hex digits
+// 0-9a-f for colours.
+std::string to_string(Code code, unsigned pegs);
+std::string to_string(Feedback feedback);
+
+// Parses a code produced by to_string; returns nullopt on a wrong length or a
+// colour outside [0, colours).
+std::optional<Code> parse_code(std::string_view text, unsigned pegs,
+                               unsigned colours);
+
+}  // namespace mastermyr
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+// A set of candidate ids over a board's code space, in whichever of two
+// encodings is smaller for its density: a bitmap with a rank directory while
+// more than one code in kDenseRatio is a candidate, and a sorted array of
+// ids below that. A dense 6x10 set takes 128 KiB where a CandidateSet takes
+// 8 bytes per code, up to 8 MiB. Compact sets are for keeping positions; a
+// search scores the CandidateSet expanded from one, since the kernels stream
+// over contiguous codes.
+class CompactCandidates {
+ public:
+  // A sorted id costs 32 bits, so sets denser than 1 in 32 are bitmaps.
+  static constexpr std::size_t kDenseRatio = 32;
+  // Words per rank-directory entry.
+  static constexpr std::size_t kBlockWords = 8;
+
+  CompactCandidates() = default;
+  // The ids of `set`, which must be increasing (as assign_all and filter
+  // keep them), over a code space of `universe` codes.
+  CompactCandidates(const CandidateSet& set, std::size_t universe);
+  // The same, reusing this set's storage.
+  void assign(const CandidateSet& set, std::size_t universe);
+  // The ids whose bits are set in `bits`, a bitmap over `universe` codes.
+  CompactCandidates(std::span<const std::uint64_t> bits, std::size_t universe);
+
+  std::size_t size() const { return size_; }
+  std::size_t universe() const { return universe_; }
+  bool empty() const { return size_ == 0; }
+  bool dense() const { return !words_.empty(); }
+  // Heap bytes held by the encoding.
+  std::size_t bytes() const;
+
+  bool contains(std::uint32_t id) const;
+  // Candidates with an id below `id`.
+  std::size_t rank(std::uint32_t id) const;
+  // Id of the candidate of rank `i`; requires i < size().
+  std::uint32_t select(std::size_t i) const;
+
+  // Keeps the candidates whose bit is set in `mask`, a bitmap over the code
+  // space such as FeedbackBitmaps::of(): a word-wise AND while dense.
+  void intersect(std::span<const std::uint64_t> mask);
+
+  // Replaces `out` with the candidates in id order, taking their codes from
+  // `all` (the board's assign_all set) when given and decoding the ids
+  // otherwise.
+  void expand(CandidateSet& out, unsigned pegs, unsigned colours,
+              const CandidateSet* all = nullptr) const;
+
+  // Same for the ids set in `bits`, without building a compact set first.
+  static void expand(std::span<const std::uint64_t> bits, CandidateSet& out,
+                     unsigned pegs, unsigned colours,
+                     const CandidateSet* all = nullptr);
+
+ private:
+  static std::size_t words_for(std::size_t universe) {
+    return (universe + 63) / 64;
+  }
+  bool dense_for(std::size_t size) const {
+    return size * kDenseRatio > universe_;
+  }
+  // Recounts size_ and the directory after the bitmap changed, then moves to
+  // the sorted array if the set became sparse.
+  void finish_bits();
+
+  std::size_t universe_ = 0;
+  std::size_t size_ = 0;
+  std::vector<std::uint64_t> words_;      // dense: one bit per code
+  std::vector<std::uint32_t> directory_;  // dense: candidates before a block
+  std::vector<std::uint32_t> ids_;        // sparse: increasing ids
+};
+
+// For one guess, the codes of a board that get each feedback, as bitmaps
+// over the code space; built by one scoring pass over the board. A solver
+// keeps its opening's, so that the first move of a game takes the surviving
+// codes from a bitmap instead of filtering the whole board.
+class FeedbackBitmaps {
+ public:
+  FeedbackBitmaps() = default;
+  FeedbackBitmaps(Code guess, unsigned pegs, unsigned colours);
+  // Over the board whose codes in id order are `codes`, for boards whose ids
+  // are not code_index(), such as those without duplicates.
+  FeedbackBitmaps(Code guess, std::span<const Code> codes, unsigned pegs);
+
+  bool empty() const { return bits_.empty(); }
+  Code guess() const { return guess_; }
+  std::size_t universe() const { return universe_; }
+  std::span<const std::uint64_t> of(Feedback feedback) const {
+    return std::span<const std::uint64_t>(bits_).subspan(
+        feedback_rank(feedback, pegs_) * words_, words_);
+  }
+
+ private:
+  // Scores the board, taking code id j from code_at(j).
+  template <typename CodeAt>
+  void build(CodeAt code_at);
+
+  Code guess_;
+  unsigned pegs_ = 0;
+  std::size_t universe_ = 0;
+  std::size_t words_ = 0;
+  std::vector<std::uint64_t> bits_;  // one bitmap per feedback rank
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mastermyr/solver.hpp"
+#include "mastermyr/strategy_tree.hpp"
+
+namespace mastermyr {
+
+// Strategy-tree compiles spread over machines. The coordinator splits the
+// compile (StrategyTree::split), hands every job, i.e. the moves leading to
+// one position at the split level, to whichever worker asks, and splices
+// the returned subtrees into the tree compile() would build. Time budgets
+// are ignored on both sides, so the tree does not depend on how fast the
+// machines are.
+//
+// Protocol: wire frames (u32 length, body) both ways over one TCP
+// connection per worker thread, little-endian and packed.
+//
+//   job:    u32 job, u8 pegs, u8 colours, u8 strategy, u8 flags
+//           (1 search_opening, 2 symmetry, 4 prune), u32 max_guesses,
+//           u32 estimate_from, u8 move count, then per move u32 guess and
+//           u8 feedback
+//   result: u32 job, u32 depth, u32 node count, u32 slot count, then the
+//           subtree's nodes and child slots as in a tree file
+//   done:   an empty frame from the coordinator; the worker disconnects
+//
+// Each worker connection has one job at a time. A connection that drops or
+// sends a malformed result puts its job back at the front of the queue, so
+// a lost worker costs only the jobs it held; TCP keepalive notices hosts
+// that vanish without closing. With a checkpoint directory every result is
+// also written there as it arrives, and a restarted coordinator reloads the
+// results of the same split instead of handing their jobs out again.
+struct CoordinatorOptions {
+  std::string host = "0.0.0.0";
+  // 0 picks a free port; see Coordinator::port().
+  std::uint16_t port = 7412;
+  // Empty: results are only kept in memory.
+  std::filesystem::path checkpoint_dir;
+  int backlog = 64;
+};
+
+class Coordinator {
+ public:
+  // Splits the compile, loads matching checkpoints and listens. Throws
+  // std::invalid_argument for a board without a Solver specialisation and
+  // std::system_error.
+  Coordinator(CoordinatorOptions options, unsigned pegs, unsigned colours,
+              const SolverOptions& solver_options);
+  ~Coordinator();
+
+  Coordinator(const Coordinator&) = delete;
+  Coordinator& operator=(const Coordinator&) = delete;
+
+  std::uint16_t port() const { return port_; }
+  std::size_t jobs() const { return split_.jobs.size(); }
+  // Results in hand, including those restored from checkpoints.
+  std::size_t completed() const;
+
+  // Serves workers until every job has its subtree, then tells them to
+  // stop and returns the tree; nullopt when stop() came first.
+  std::optional<StrategyTree> run();
+  // Safe to call from any thread, including a signal-handling one.
+  void stop();
+
+ private:
+  void accept_loop();
+  void session(int fd);
+  // The next job to hand out, or nullopt once all are done or stopping.
+  std::optional<std::size_t> take();
+  void complete(std::size_t job, StrategyTree::Subtree subtree);
+  void requeue(std::size_t job);
+  void load_checkpoints();
+  std::filesystem::path checkpoint_path(std::size_t job) const;
+
+  CoordinatorOptions options_;
+  SolverOptions solver_options_;
+  StrategyTree::Split split_;
+  std::uint64_t plan_ = 0;  // hash of the split, keying its checkpoints
+  int listen_fd_ = -1;
+  int wake_fd_ = -1;
+  std::uint16_t port_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::deque<std::size_t> queue_;
+  std::vector<std::optional<StrategyTree::Subtree>> results_;
+  std::size_t completed_ = 0;
+  std::vector<int> sessions_fds_;
+  std::vector<std::jthread> sessions_;
+  std::atomic<bool> stopping_{false};
+};
+
+// Connects to a coordinator and compiles the jobs it hands out, on
+// `connections` connections at once, until it sends done. `options`
+// supplies everything but the search settings, which come with each job;
+// its time budget is ignored, as the coordinator's is.
+// Returns the jobs compiled; throws std::system_error when it cannot
+// connect and wire::WireError for a malformed job.
+std::size_t run_worker(const std::string& host, std::uint16_t port,
+                       const SolverOptions& options, unsigned connections = 1);
+
+}  // namespace mastermyr
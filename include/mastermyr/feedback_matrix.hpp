@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/mapped_file.hpp"
+#include "mastermyr/numa.hpp"
+
+namespace mastermyr {
+
+// Identifies a code space: which codes exist and in what order they are
+// indexed. Also the key of every on-disk table derived from that space.
+struct BoardKey {
+  unsigned pegs = 4;
+  unsigned colours = 6;
+  DuplicateRule duplicates = DuplicateRule::kAllowed;
+
+  friend bool operator==(const BoardKey&, const BoardKey&) = default;
+};
+
+// The board's codes in index order. With duplicates allowed the index of a
+// code is code_index(); otherwise codes keep that relative order but the
+// repeating ones are skipped.
+std::vector<Code> enumerate_codes(const BoardKey& key);
+
+// Thrown when a table file is missing, truncated, from another format version
+// or board, or fails its checksum.
+class CacheError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Dense guess x code feedback table: at(g, c) is the feedback of the code with
+// index g guessed against the code with index c. The table is either owned or
+// a read-only mapping of a cache file, in which case every process that opens
+// the same board shares the pages.
+//
+// File layout (little endian): a 64-byte header carrying the magic, format
+// version, board key, code count and a checksum of the payload, followed by
+// code_count^2 raw feedback bytes in row-major order.
+class FeedbackMatrix {
+ public:
+  static constexpr std::uint32_t kFormatVersion = 1;
+  // Boards above this size are not tabulated by default (16384^2 = 256 MiB).
+  static constexpr std::size_t kDefaultMaxCodes = 16384;
+
+  // Computes the table in memory.
+  static FeedbackMatrix build(const BoardKey& key);
+
+  // Maps a cache file, validating its header against `key` and its checksum.
+  // Throws CacheError or std::system_error.
+  static FeedbackMatrix load(const std::filesystem::path& file,
+                             const BoardKey& key);
+
+  // Maps the cached table for `key` from `cache_dir`, or builds it and tries
+  // to store it there first. A cache directory that cannot be written only
+  // costs the persistence; the built table is still returned.
+  static FeedbackMatrix open(const BoardKey& key,
+                             const std::filesystem::path& cache_dir);
+
+  // Writes the table to `file` atomically (temporary file and rename).
+  void save(const std::filesystem::path& file) const;
+
+  // A copy held in memory on `node`, for numa::Replicated.
+  FeedbackMatrix copy_to_node(unsigned node) const;
+
+  const BoardKey& key() const { return key_; }
+  std::size_t size() const { return size_; }
+  bool is_mapped() const { return mapping_.is_open(); }
+
+  Feedback at(std::uint32_t guess, std::uint32_t code) const {
+    return data_[std::size_t{guess} * size_ + code];
+  }
+  std::span<const Feedback> row(std::uint32_t guess) const {
+    return {data_ + std::size_t{guess} * size_, size_};
+  }
+
+ private:
+  FeedbackMatrix() = default;
+
+  BoardKey key_;
+  std::size_t size_ = 0;
+  const Feedback* data_ = nullptr;
+  std::vector<Feedback> owned_;
+  MappedFile mapping_;
+  numa::NodeBuffer replica_;
+};
+
+// $MASTERMYR_CACHE_DIR, else $XDG_CACHE_HOME/mastermyr, else
+// $HOME/.cache/mastermyr, else ./.mastermyr-cache.
+std::filesystem::path default_cache_dir();
+
+// File name of a board's feedback table, e.g. feedback-v1-4x6-dup.bin.
+std::string feedback_cache_name(const BoardKey& key);
+
+}  // namespace mastermyr
@@ -0,0 +1,610 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/code.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/metrics.hpp"
+#include "mastermyr/partition_backend.hpp"
+#include "mastermyr/score.hpp"
+#include "mastermyr/thread_pool.hpp"
+
+namespace mastermyr {
+
+// How a guess is rated from the partition its feedback induces on the
+// candidates.
+enum class Strategy : std::uint8_t {
+  kMinimax,       // Knuth: smallest largest partition
+  kMaxParts,      // most non-empty partitions
+  kExpectedSize,  // smallest expected partition size
+  kEntropy,       // most information
+};
+
+const char* strategy_name(Strategy strategy);
+// Whether a byte read from a file or the wire names a Strategy.
+constexpr bool is_strategy(std::uint8_t value) {
+  return value <= static_cast<std::uint8_t>(Strategy::kEntropy);
+}
+std::optional<Strategy> parse_strategy(std::string_view name);
+
+// Cost of splitting `total` candidates as `histogram` does; lower is better.
+// Every strategy is expressed as a cost so that one reduction serves all:
+// the largest part, minus the number of parts, sum(n^2) / total, and
+// sum(n log2 n) / total (which is log2 total minus the entropy).
+inline double partition_cost(Strategy strategy,
+                             std::span<const std::uint32_t> histogram,
+                             std::size_t total) {
+  switch (strategy) {
+    case Strategy::kMinimax:
+      return *std::max_element(histogram.begin(), histogram.end());
+    case Strategy::kMaxParts:
+      return -static_cast<double>(
+          std::count_if(histogram.begin(), histogram.end(),
+                        [](std::uint32_t n) { return n != 0; }));
+    case Strategy::kExpectedSize: {
+      std::uint64_t sum = 0;
+      for (const std::uint32_t n : histogram) sum += std::uint64_t{n} * n;
+      return static_cast<double>(sum) / static_cast<double>(total);
+    }
+    case Strategy::kEntropy: {
+      double sum = 0;
+      for (const std::uint32_t n : histogram) {
+        if (n > 1) sum += n * std::log2(static_cast<double>(n));
+      }
+      return sum / static_cast<double>(total);
+    }
+  }
+  return 0;
+}
+
+// The lowest cost any guess can have: `total` candidates split as evenly
+// as `parts` feedbacks allow. It bounds how far from the best guess an
+// incomplete search can be.
+inline double partition_cost_bound(Strategy strategy, std::size_t total,
+                                   std::size_t parts) {
+  if (total == 0) return 0;
+  parts = std::min(parts, total);
+  const std::size_t q = total / parts;
+  const std::size_t r = total % parts;  // parts of q + 1, the rest of q
+  auto sum = [&](auto term) {
+    return (static_cast<double>(r) * term(q + 1) +
+            static_cast<double>(parts - r) * term(q)) /
+           static_cast<double>(total);
+  };
+  switch (strategy) {
+    case Strategy::kMinimax:
+      return static_cast<double>(r != 0 ? q + 1 : q);
+    case Strategy::kMaxParts:
+      return -static_cast<double>(parts);
+    case Strategy::kExpectedSize:
+      return sum([](std::size_t n) { return static_cast<double>(n * n); });
+    case Strategy::kEntropy:
+      return sum([](std::size_t n) {
+        return n > 1 ? n * std::log2(static_cast<double>(n)) : 0.0;
+      });
+  }
+  return 0;
+}
+
+// The guesses a search may choose from, structure-of-arrays. is_candidate
+// marks guesses that are still consistent and so could win outright. Order
+// matters: consistent guesses usually rate well, so listing them first gives
+// the pruning bound below a good value early.
+struct SearchSpace {
+  std::span<const Code> codes;
+  std::span<const std::uint32_t> ids;
+  std::span<const std::uint8_t> is_candidate;
+
+  std::size_t size() const { return codes.size(); }
+};
+
+struct GuessChoice {
+  Code guess;
+  std::uint32_t id = 0;
+  double cost = std::numeric_limits<double>::infinity();
+  bool is_candidate = false;
+  std::size_t index = std::numeric_limits<std::size_t>::max();
+};
+
+// What a search did. A search that ran out of time chose from the guesses
+// it got to; it is at most gap() worse than the best guess of its space.
+struct SearchStats {
+  std::size_t visited = 0;  // guesses rated, or pruned as no better
+  std::size_t space = 0;    // guesses in the search space
+  std::size_t sample = 0;   // candidates guesses were estimated on; 0: none
+  double cost = 0;          // of the chosen guess
+  double bound = 0;         // partition_cost_bound(): no guess costs less
+  std::chrono::nanoseconds elapsed{0};
+
+  bool complete() const { return visited == space; }
+  // Every guess rated against every candidate: the choice is the best.
+  bool exact() const { return complete() && sample == 0; }
+  double gap() const { return exact() ? 0 : cost - bound; }
+};
+
+// Lower cost wins, then a guess that could be the secret, then the earlier
+// guess in the search space, so the result does not depend on scheduling.
+inline bool better_choice(const GuessChoice& a, const GuessChoice& b) {
+  if (a.cost != b.cost) return a.cost < b.cost;
+  if (a.is_candidate != b.is_candidate) return a.is_candidate;
+  return a.index < b.index;
+}
+
+// Rates every guess of a search space against a candidate set, in parallel
+// over a work-stealing pool. The pool splits the guess space into small
+// chunks, so the uneven cost of guesses (a feedback-table row versus a
+// scoring pass, or pruned evaluations later on) is balanced by stealing.
+// Each participant keeps its own best choice in a padded slot and the slots
+// are reduced once the loop has finished, so no lock is taken.
+//
+// Minimax searches with pruning on are a branch and bound. The best largest
+// part found by any thread is shared through an atomic, and a guess is
+// abandoned as soon as one of its parts, counted over the candidates scored
+// so far, is already bigger. Only strictly worse guesses are cut, so the
+// result is the same as an exhaustive search. To tighten the bound early,
+// guesses are visited candidates first (the order of the search space) and,
+// for large candidate sets, in order of their cost on a small sample of the
+// candidates. The other strategies' partial costs bound their final cost too,
+// but too loosely to pay for the checks, so they are always rated in full.
+//
+// With a PartitionBackend, searches of at least kOffloadWork scores hand the
+// whole guess x candidate count to it in one call and only rate the returned
+// histograms on the CPU. Offloaded guesses are never pruned; the device does
+// the full count faster than the CPU does the pruned one.
+//
+// Searches over at least `estimate_from` candidates first estimate every
+// guess's cost on a random sample of them, which grows until the best few
+// guesses stay the same, and rate only those kFinalists exactly. Their
+// result is no longer guaranteed optimal, so it counts as inexact.
+//
+// A search given a deadline is anytime: it rates the candidates first, then
+// the other guesses at a stride that spreads any prefix of them evenly over
+// the space, and returns the best guess rated when time runs out. It is
+// never offloaded or presorted, since neither can stop part-way.
+template <unsigned Pegs, unsigned Colours>
+class GuessSearch {
+ public:
+  static constexpr std::size_t kFeedbackSlots = feedback_slots(Pegs);
+  using Histogram = std::array<std::uint32_t, kFeedbackSlots>;
+
+  // Guesses per parallel_for chunk.
+  static constexpr std::size_t kGrain = 8;
+  // Candidates scored per kernel call.
+  static constexpr std::size_t kBlock = 256;
+  // Blocks between two bound checks. Cuts mostly come late, so checking after
+  // every block costs more than it saves.
+  static constexpr std::size_t kCheckEvery = 4;
+  // Guesses are presorted by their cost on kSample candidates when there are
+  // at least kPresortFactor times as many candidates.
+  static constexpr std::size_t kSample = 256;
+  static constexpr std::size_t kPresortFactor = 8;
+  // Guesses x candidates from which a search is offloaded to the backend.
+  static constexpr std::size_t kOffloadWork = std::size_t{1} << 24;
+  // Estimated searches rate this many finalists exactly, after sampling
+  // kEstimateSample candidates and up to kMaxEstimateSample (see finalists).
+  static constexpr std::size_t kFinalists = 16;
+  static constexpr std::size_t kLeaders = 4;
+  static constexpr std::size_t kSurvivors = 4 * kFinalists;
+  static constexpr std::size_t kEstimateSample = 1024;
+  static constexpr std::size_t kMaxEstimateSample = std::size_t{1} << 14;
+  // Fewer candidates than this are always rated exactly, whatever
+  // estimate_from says: the first sample must be at most a quarter of them.
+  static constexpr std::size_t kMinEstimated = 4 * kEstimateSample;
+
+  using Clock = std::chrono::steady_clock;
+  static constexpr Clock::time_point kNoDeadline = Clock::time_point::max();
+
+  // `estimate_from` 0 never estimates.
+  GuessSearch(Strategy strategy, ThreadPool* pool,
+              const FeedbackMatrix* matrix, bool prune = true,
+              PartitionBackend* backend = nullptr,
+              std::size_t estimate_from = 0)
+      : strategy_(strategy),
+        pool_(pool),
+        matrix_(matrix),
+        backend_(backend),
+        estimate_from_(estimate_from),
+        prune_(prune && strategy == Strategy::kMinimax) {}
+
+  Strategy strategy() const { return strategy_; }
+
+  // Feedback histogram of `guess` (whose code-space index is `guess_id`) over
+  // the candidates.
+  Histogram partition(Code guess, std::uint32_t guess_id,
+                      const CandidateSet& candidates) const {
+    Histogram histogram{};
+    fill_partition(guess, guess_id, candidates, kNoBound, histogram);
+    return histogram;
+  }
+
+  // Rates `guess`. Under minimax pruning, returns false, leaving `cost`
+  // unset, once the guess is known to cost more than `bound`.
+  bool rate(Code guess, std::uint32_t guess_id,
+            const CandidateSet& candidates, double bound,
+            double& cost) const {
+    const Rater rater(strategy_, candidates.size(), false,
+                      std::pmr::get_default_resource());
+    if (strategy_ != Strategy::kMinimax) bound = kNoBound;
+    return rate(guess, guess_id, candidates, rater, bound, cost);
+  }
+
+  // The best guess of `space`. With `histograms` (indexed by guess id, as
+  // kept by PartitionCache) guesses are rated from those instead of being
+  // scored against the candidates. Per-call scratch comes from `scratch`.
+  // Past `deadline` the search stops with what it has rated, always at least
+  // one guess; `stats`, when given, receives what it did.
+  GuessChoice best(const CandidateSet& candidates, const SearchSpace& space,
+                   std::span<const Histogram> histograms = {},
+                   std::pmr::memory_resource* scratch =
+                       std::pmr::get_default_resource(),
+                   Clock::time_point deadline = kNoDeadline,
+                   SearchStats* stats = nullptr) const {
+    const Clock::time_point start =
+        stats != nullptr ? Clock::now() : Clock::time_point();
+    if (stats != nullptr) *stats = {};
+    if (space.size() == 0) return {};
+    const metrics::ScopedTimer timer(metrics::Phase::kSearch);
+    metrics::add(metrics::Counter::kSearches);
+    const bool anytime = deadline != kNoDeadline;
+    std::size_t visited = 0;
+    std::size_t sample = 0;
+    GuessChoice best;
+    if (!anytime && histograms.empty() && estimate_from_ != 0 &&
+        candidates.size() >= std::max(estimate_from_, kMinEstimated) &&
+        space.size() > 2 * kFinalists && !offloads(candidates, space)) {
+      // Rate only the guesses that estimate best, exactly and in space
+      // order, so that ties still go to the earlier guess.
+      std::pmr::vector<std::uint32_t> picked =
+          finalists(candidates, space, sample, scratch);
+      std::sort(picked.begin(), picked.end());
+      std::pmr::vector<Code> codes(scratch);
+      std::pmr::vector<std::uint32_t> ids(scratch);
+      std::pmr::vector<std::uint8_t> is_candidate(scratch);
+      for (const std::uint32_t i : picked) {
+        codes.push_back(space.codes[i]);
+        ids.push_back(space.ids[i]);
+        is_candidate.push_back(space.is_candidate[i]);
+      }
+      best = rate_all(candidates, {codes, ids, is_candidate}, {}, scratch,
+                      kNoDeadline, visited);
+      best.index = picked[best.index];
+      visited = space.size();
+    } else {
+      best = rate_all(candidates, space, histograms, scratch, deadline,
+                      visited);
+    }
+    metrics::add(metrics::Counter::kGuessesRated, visited);
+    if (stats != nullptr) {
+      stats->visited = visited;
+      stats->space = space.size();
+      stats->sample = sample;
+      stats->cost = best.cost;
+      stats->bound = partition_cost_bound(strategy_, candidates.size(),
+                                          feedback_ranks(Pegs) - 1);
+      stats->elapsed = Clock::now() - start;
+    }
+    return best;
+  }
+
+ private:
+  // The search proper: rates the guesses of a non-empty space, adding the
+  // number it got to before `deadline` to `visited`.
+  GuessChoice rate_all(const CandidateSet& candidates,
+                       const SearchSpace& space,
+                       std::span<const Histogram> histograms,
+                       std::pmr::memory_resource* scratch,
+                       Clock::time_point deadline,
+                       std::size_t& visited) const {
+    struct alignas(64) Slot {
+      GuessChoice choice;
+      std::size_t visited = 0;
+    };
+    const bool anytime = deadline != kNoDeadline;
+    const unsigned participants = pool_ ? pool_->concurrency() : 1;
+    std::pmr::vector<Slot> slots(participants, scratch);
+    alignas(64) std::atomic<double> bound{kNoBound};
+    alignas(64) std::atomic<bool> expired{false};
+    const Rater rater(strategy_, candidates.size(), space.size() > 1, scratch);
+    std::pmr::vector<std::uint32_t> offloaded(scratch);
+    if (!anytime && histograms.empty() && offloads(candidates, space)) {
+      offloaded.resize(space.size() * kFeedbackSlots);
+      backend_->partitions(space.codes, candidates.codes(), Pegs, offloaded);
+    }
+    const std::pmr::vector<std::uint32_t> order =
+        anytime ? anytime_order(space, scratch)
+        : histograms.empty() && offloaded.empty()
+            ? visit_order(candidates, space, scratch)
+            : std::pmr::vector<std::uint32_t>(scratch);
+
+    auto visit = [&](std::size_t k, Slot& slot) {
+      if (anytime && k != 0) {
+        if (expired.load(std::memory_order_relaxed)) return;
+        if (Clock::now() >= deadline) {
+          expired.store(true, std::memory_order_relaxed);
+          return;
+        }
+      }
+      ++slot.visited;
+      GuessChoice& local = slot.choice;
+      const std::size_t i = order.empty() ? k : order[k];
+      GuessChoice choice;
+      choice.guess = space.codes[i];
+      choice.id = space.ids[i];
+      choice.is_candidate = space.is_candidate[i] != 0;
+      choice.index = i;
+      if (!histograms.empty()) {
+        choice.cost = rater.cost(histograms[choice.id]);
+      } else if (!offloaded.empty()) {
+        Histogram histogram;
+        std::copy_n(offloaded.begin() + i * kFeedbackSlots, kFeedbackSlots,
+                    histogram.begin());
+        choice.cost = rater.cost(histogram);
+      } else if (!rate(choice.guess, choice.id, candidates, rater,
+                       prune_ ? bound.load(std::memory_order_relaxed)
+                              : kNoBound,
+                       choice.cost)) {
+        metrics::add(metrics::Counter::kGuessesPruned);
+        return;
+      }
+      if (better_choice(choice, local)) local = choice;
+      double current = bound.load(std::memory_order_relaxed);
+      while (choice.cost < current &&
+             !bound.compare_exchange_weak(current, choice.cost,
+                                          std::memory_order_relaxed)) {
+      }
+    };
+
+    // Rate the first guess up front so that every thread starts with a
+    // finite bound rather than racing to establish one.
+    visit(0, slots[0]);
+    parallel(space.size() - 1,
+             [&](std::size_t begin, std::size_t end, unsigned participant) {
+               Slot& slot = slots[participant];
+               for (std::size_t k = begin; k < end; ++k) visit(k + 1, slot);
+             });
+    GuessChoice best;
+    for (const Slot& slot : slots) {
+      if (better_choice(slot.choice, best)) best = slot.choice;
+      visited += slot.visited;
+    }
+    return best;
+  }
+
+  bool offloads(const CandidateSet& candidates,
+                const SearchSpace& space) const {
+    return backend_ != nullptr &&
+           space.size() * candidates.size() >= kOffloadWork;
+  }
+
+  // Positions of the kFinalists guesses of `space` that rate best on a
+  // sample of the candidates. The sample is drawn uniformly with
+  // replacement, so every part's share of it estimates the part's share of
+  // the candidates without bias. It doubles from kEstimateSample until the
+  // kLeaders best guesses were all finalists of the round before, or until
+  // it reaches kMaxEstimateSample or a quarter of the candidates; leaders
+  // rather than all finalists must agree because the last finalists are
+  // often tied with many other guesses. Each round scores only its new draws
+  // and only the better half of the guesses still in the race, down to
+  // kSurvivors: a guess that ranks in the worse half on a thousand
+  // candidates is very unlikely to end in the top few. Draws are seeded by
+  // the candidate set, so a position always gets the same finalists.
+  // `sample` receives the final sample size.
+  std::pmr::vector<std::uint32_t> finalists(
+      const CandidateSet& candidates, const SearchSpace& space,
+      std::size_t& sample, std::pmr::memory_resource* scratch) const {
+    const std::size_t n = candidates.size();
+    const std::span<const std::uint32_t> candidate_ids = candidates.ids();
+    std::mt19937_64 rng(n ^ std::uint64_t{candidate_ids.front()} << 24 ^
+                        std::uint64_t{candidate_ids.back()} << 44);
+    std::pmr::vector<Histogram> parts(space.size(), scratch);
+    std::pmr::vector<double> cost(space.size(), scratch);
+    std::pmr::vector<std::uint32_t> alive(space.size(), scratch);
+    for (std::size_t i = 0; i < alive.size(); ++i) {
+      alive[i] = static_cast<std::uint32_t>(i);
+    }
+    // better_choice() on positions.
+    auto before = [&](std::uint32_t a, std::uint32_t b) {
+      if (cost[a] != cost[b]) return cost[a] < cost[b];
+      if (space.is_candidate[a] != space.is_candidate[b]) {
+        return space.is_candidate[a] != 0;
+      }
+      return a < b;
+    };
+    std::pmr::vector<std::uint32_t> top(scratch);
+    std::pmr::vector<std::uint32_t> previous(scratch);
+    CandidateSet draws(kMaxEstimateSample, scratch);
+    sample = 0;
+    for (std::size_t want = kEstimateSample;; want *= 2) {
+      draws.clear();
+      for (; sample < want; ++sample) {
+        const std::size_t j = rng() % n;
+        draws.push_back(candidates[j], candidate_ids[j]);
+      }
+      const Rater rater(strategy_, sample, true, scratch);
+      parallel(alive.size(),
+               [&](std::size_t begin, std::size_t end, unsigned) {
+                 for (std::size_t k = begin; k < end; ++k) {
+                   const std::uint32_t i = alive[k];
+                   fill_partition(space.codes[i], space.ids[i], draws,
+                                  kNoBound, parts[i]);
+                   cost[i] = rater.cost(parts[i]);
+                 }
+               });
+      std::sort(alive.begin(), alive.end(), before);
+      top.assign(alive.begin(), alive.begin() + kFinalists);
+      const bool stable = std::all_of(
+          top.begin(), top.begin() + kLeaders, [&](std::uint32_t i) {
+            return std::binary_search(previous.begin(), previous.end(), i);
+          });
+      std::sort(top.begin(), top.end());
+      if (stable || 2 * want > kMaxEstimateSample || 4 * want > n) return top;
+      previous = top;
+      if (alive.size() > kSurvivors) {
+        alive.resize(std::max(alive.size() / 2, kSurvivors));
+      }
+    }
+  }
+
+  static constexpr double kNoBound = std::numeric_limits<double>::infinity();
+
+  // partition_cost() for one candidate count, with n log2 n tabulated for
+  // entropy. The table holds exactly the terms partition_cost() adds, so
+  // costs are bit-identical either way.
+  class Rater {
+   public:
+    Rater(Strategy strategy, std::size_t total, bool tabulate,
+          std::pmr::memory_resource* resource)
+        : strategy_(strategy), total_(total), nlogn_(resource) {
+      if (strategy == Strategy::kEntropy && tabulate) {
+        nlogn_.resize(total + 1);
+        for (std::size_t n = 2; n <= total; ++n) {
+          nlogn_[n] = static_cast<std::uint32_t>(n) *
+                      std::log2(static_cast<double>(n));
+        }
+      }
+    }
+
+    double cost(const Histogram& histogram) const {
+      if (nlogn_.empty()) return partition_cost(strategy_, histogram, total_);
+      double sum = 0;
+      for (const std::uint32_t n : histogram) sum += nlogn_[n];
+      return sum / static_cast<double>(total_);
+    }
+
+   private:
+    Strategy strategy_;
+    std::size_t total_;
+    std::pmr::vector<double> nlogn_;
+  };
+
+  template <typename Body>
+  void parallel(std::size_t n, Body&& body) const {
+    if (pool_ != nullptr) {
+      pool_->parallel_for(n, kGrain, body);
+    } else {
+      body(0, n, 0);
+    }
+  }
+
+  bool rate(Code guess, std::uint32_t guess_id,
+            const CandidateSet& candidates, const Rater& rater, double bound,
+            double& cost) const {
+    Histogram histogram{};
+    if (!fill_partition(guess, guess_id, candidates, bound, histogram)) {
+      return false;
+    }
+    cost = rater.cost(histogram);
+    return true;
+  }
+
+  // Positions of the search space, candidates in space order and then the
+  // others at a stride near the golden section of their count and coprime
+  // with it, so that every prefix of them is spread over the whole space.
+  static std::pmr::vector<std::uint32_t> anytime_order(
+      const SearchSpace& space, std::pmr::memory_resource* scratch) {
+    std::pmr::vector<std::uint32_t> order(scratch);
+    std::pmr::vector<std::uint32_t> others(scratch);
+    order.reserve(space.size());
+    for (std::size_t i = 0; i < space.size(); ++i) {
+      (space.is_candidate[i] ? order : others)
+          .push_back(static_cast<std::uint32_t>(i));
+    }
+    const std::size_t m = others.size();
+    if (m == 0) return order;
+    std::size_t stride = std::max<std::size_t>(
+        1, static_cast<std::size_t>(static_cast<double>(m) * 0.618));
+    while (std::gcd(stride, m) != 1) ++stride;
+    for (std::size_t j = 0, k = 0; j < m; ++j, k = (k + stride) % m) {
+      order.push_back(others[k]);
+    }
+    return order;
+  }
+
+  // Positions of the search space sorted by cost on an even sample of the
+  // candidates, ties in space order; empty means space order.
+  std::pmr::vector<std::uint32_t> visit_order(
+      const CandidateSet& candidates, const SearchSpace& space,
+      std::pmr::memory_resource* scratch) const {
+    std::pmr::vector<std::uint32_t> order(scratch);
+    if (!prune_ || space.size() < 2 ||
+        candidates.size() < kSample * kPresortFactor) {
+      return order;
+    }
+    CandidateSet sample(kSample, scratch);
+    const std::size_t stride = candidates.size() / kSample;
+    for (std::size_t i = 0; i < kSample; ++i) {
+      sample.push_back(candidates[i * stride], candidates.ids()[i * stride]);
+    }
+    const Rater rater(strategy_, kSample, true, scratch);
+    std::pmr::vector<double> estimate(space.size(), scratch);
+    parallel(space.size(), [&](std::size_t begin, std::size_t end, unsigned) {
+      for (std::size_t i = begin; i < end; ++i) {
+        rate(space.codes[i], space.ids[i], sample, rater, kNoBound,
+             estimate[i]);
+      }
+    });
+    order.resize(space.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      order[i] = static_cast<std::uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::uint32_t a, std::uint32_t b) {
+                       return estimate[a] < estimate[b];
+                     });
+    return order;
+  }
+
+  // Accumulates the histogram block by block, comparing its largest part
+  // with `bound` every kCheckEvery blocks. Returns false once it exceeds it.
+  bool fill_partition(Code guess, std::uint32_t guess_id,
+                      const CandidateSet& candidates, double bound,
+                      Histogram& histogram) const {
+    const std::size_t total = candidates.size();
+    const bool check = bound != kNoBound;
+    const std::span<const std::uint32_t> ids = candidates.ids();
+    const std::span<const Code> codes = candidates.codes();
+    std::array<Feedback, kBlock> scores;
+    std::size_t blocks = 0;
+    for (std::size_t begin = 0; begin < total; begin += kBlock) {
+      const std::size_t n = std::min(kBlock, total - begin);
+      if (matrix_ != nullptr) {
+        const std::span<const Feedback> row = matrix_->row(guess_id);
+        for (std::size_t j = 0; j < n; ++j) {
+          ++histogram[row[ids[begin + j]].raw()];
+        }
+      } else {
+        score_batch(guess, codes.data() + begin, n, scores.data(), Pegs);
+        for (std::size_t j = 0; j < n; ++j) ++histogram[scores[j].raw()];
+      }
+      if (check && ++blocks % kCheckEvery == 0 && begin + n < total &&
+          *std::max_element(histogram.begin(), histogram.end()) > bound) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Strategy strategy_;
+  ThreadPool* pool_;
+  const FeedbackMatrix* matrix_;
+  PartitionBackend* backend_;
+  std::size_t estimate_from_;
+  bool prune_;
+};
+
+}  // namespace mastermyr
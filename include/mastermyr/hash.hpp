@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mastermyr {
+
+// Fast non-cryptographic 64-bit hash, used as the checksum of on-disk tables.
+// Processes eight bytes per step, so checksumming a mapped table costs about
+// as much as reading it once.
+std::uint64_t hash_bytes(const void* data, std::size_t size,
+                         std::uint64_t seed = 0);
+
+}  // namespace mastermyr
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#if !defined(MASTERMYR_METRICS)
+#define MASTERMYR_METRICS 0
+#endif
+
+#if MASTERMYR_METRICS && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace mastermyr::metrics {
+
+// Hot-path counters and phase timers, compiled in with -DMASTERMYR_METRICS=ON
+// (CMake option of the same name). Without it add() and ScopedTimer are
+// empty inline functions and snapshot() returns zeros.
+//
+// Every thread owns a cache-line aligned block of counters that only it
+// writes, with plain relaxed loads and stores rather than atomic
+// read-modify-writes; snapshot() sums the live blocks and the totals left by
+// exited threads. Timers read the time-stamp counter, so a phase costs two
+// rdtsc's; phases nest (a search's time includes the scoring it does).
+inline constexpr bool kEnabled = MASTERMYR_METRICS != 0;
+
+enum class Counter : unsigned {
+  kCodesScored,    // candidates passed through score_batch
+  kCodesFiltered,  // candidates examined by CandidateSet::filter
+  kSearches,       // GuessSearch::best calls
+  kGuessesRated,   // guesses visited by those searches
+  kGuessesPruned,  // of which abandoned by branch and bound
+  kTableHits,      // transposition-table probes that found a guess
+  kTableMisses,
+  kRequests,       // server requests
+  kBookHits,       // of which answered from the opening book
+  kBytesRead,      // server socket bytes
+  kBytesWritten,
+  kCount
+};
+
+enum class Phase : unsigned {
+  kScore,
+  kFilter,
+  kSearch,
+  kTable,
+  kIo,
+  kCount
+};
+
+inline constexpr std::size_t kCounters = static_cast<std::size_t>(Counter::kCount);
+inline constexpr std::size_t kPhases = static_cast<std::size_t>(Phase::kCount);
+
+const char* counter_name(Counter counter);
+const char* phase_name(Phase phase);
+
+struct Snapshot {
+  std::array<std::uint64_t, kCounters> counters{};
+  std::array<std::uint64_t, kPhases> calls{};
+  std::array<std::uint64_t, kPhases> ticks{};
+  // Timer ticks per second, measured against the steady clock since start.
+  double ticks_per_second = 0;
+
+  std::uint64_t operator[](Counter counter) const {
+    return counters[static_cast<std::size_t>(counter)];
+  }
+  double seconds(Phase phase) const {
+    return ticks_per_second > 0
+               ? static_cast<double>(ticks[static_cast<std::size_t>(phase)]) /
+                     ticks_per_second
+               : 0;
+  }
+};
+
+Snapshot snapshot();
+
+// One "name value" line per counter and one "phase calls seconds" line per
+// phase, or a single line saying metrics are compiled out.
+void write(std::ostream& out, const Snapshot& snapshot);
+
+namespace detail {
+
+struct alignas(64) ThreadBlock {
+  std::array<std::atomic<std::uint64_t>, kCounters> counters{};
+  std::array<std::atomic<std::uint64_t>, kPhases> calls{};
+  std::array<std::atomic<std::uint64_t>, kPhases> ticks{};
+};
+
+inline thread_local ThreadBlock* tls_block = nullptr;
+
+// Registers the calling thread's block.
+ThreadBlock& attach();
+
+inline ThreadBlock& block() {
+  ThreadBlock* b = tls_block;
+  return b != nullptr ? *b : attach();
+}
+
+// Only the owning thread writes, so this needs no read-modify-write.
+inline void bump(std::atomic<std::uint64_t>& word, std::uint64_t n) {
+  word.store(word.load(std::memory_order_relaxed) + n,
+             std::memory_order_relaxed);
+}
+
+inline std::uint64_t ticks() {
+#if MASTERMYR_METRICS && (defined(__x86_64__) || defined(__i386__))
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+}  // namespace detail
+
+inline void add([[maybe_unused]] Counter counter,
+                [[maybe_unused]] std::uint64_t n = 1) {
+  if constexpr (kEnabled) {
+    detail::bump(detail::block().counters[static_cast<std::size_t>(counter)],
+                 n);
+  }
+}
+
+// Adds its lifetime to a phase.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer([[maybe_unused]] Phase phase) {
+#if MASTERMYR_METRICS
+    phase_ = phase;
+    start_ = detail::ticks();
+#endif
+  }
+  ~ScopedTimer() {
+#if MASTERMYR_METRICS
+    detail::ThreadBlock& b = detail::block();
+    const auto i = static_cast<std::size_t>(phase_);
+    detail::bump(b.ticks[i], detail::ticks() - start_);
+    detail::bump(b.calls[i], 1);
+#endif
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+#if MASTERMYR_METRICS
+  Phase phase_;
+  std::uint64_t start_;
+#endif
+};
+
+}  // namespace mastermyr::metrics
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mastermyr::numa {
+
+// NUMA topology and placement. With libnuma (MASTERMYR_NUMA) and a kernel
+// that reports nodes, these see the real topology; otherwise the machine is
+// one node holding every CPU the process may use, pinning still works and
+// node-bound memory is plain memory.
+
+// Whether the build uses libnuma and the kernel reports NUMA.
+bool available();
+
+// Memory nodes, at least 1.
+unsigned nodes();
+
+// CPUs of `node` the process may run on, ascending.
+std::vector<unsigned> cpus(unsigned node);
+
+// The node of the CPU the calling thread runs on.
+unsigned current_node();
+
+// Restricts the calling thread to one CPU or to the CPUs of one node.
+// False when the CPU set is empty or the kernel refuses it.
+bool pin_to_cpu(unsigned cpu);
+bool pin_to_node(unsigned node);
+
+// Memory whose pages are placed on one node. Moves only.
+class NodeBuffer {
+ public:
+  NodeBuffer() = default;
+  // Throws std::bad_alloc.
+  NodeBuffer(std::size_t bytes, unsigned node);
+  ~NodeBuffer();
+
+  NodeBuffer(NodeBuffer&& other) noexcept;
+  NodeBuffer& operator=(NodeBuffer&& other) noexcept;
+  NodeBuffer(const NodeBuffer&) = delete;
+  NodeBuffer& operator=(const NodeBuffer&) = delete;
+
+  std::byte* data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+ private:
+  void free();
+
+  std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Read-only table copied once per node, so that threads read the copy on
+// their own node instead of crossing the interconnect. T provides
+// `T copy_to_node(unsigned node) const`. On a single node the original is
+// the only copy.
+template <typename T>
+class Replicated {
+ public:
+  explicit Replicated(std::shared_ptr<const T> table) {
+    const unsigned count = nodes();
+    if (count == 1) {
+      copies_.push_back(std::move(table));
+      return;
+    }
+    copies_.reserve(count);
+    for (unsigned node = 0; node < count; ++node) {
+      copies_.push_back(std::make_shared<const T>(table->copy_to_node(node)));
+    }
+  }
+
+  const std::shared_ptr<const T>& on(unsigned node) const {
+    return copies_[node % copies_.size()];
+  }
+  // The copy on the calling thread's node.
+  const std::shared_ptr<const T>& local() const {
+    return copies_.size() == 1 ? copies_.front() : on(current_node());
+  }
+
+ private:
+  std::vector<std::shared_ptr<const T>> copies_;
+};
+
+}  // namespace mastermyr::numa
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/solver.hpp"
+#include "mastermyr/strategy_tree.hpp"
+#include "mastermyr/wire.hpp"
+
+namespace mastermyr {
+
+// How often recorded games pass through each position of one board, for
+// choosing what an opening book covers. A recorded game is a wire game
+// state holding one game's moves, as far as it got. Every position in which
+// it needed a guess counts once: the empty history, then the one after each
+// move but a solving one. Positions form a trie of moves, one node per
+// position, so no position counts less than any of its extensions.
+//
+// Memory stays bounded over streams of any length. Positions deeper than
+// max_depth moves are not counted. Once the trie holds more than
+// max_states positions, the rarest are dropped until at most half remain.
+// Counts fall along every path, so the survivors are still a trie. A
+// dropped position that recurs counts again from zero, so a count is low by
+// at most error().
+class HistoryCounts {
+ public:
+  using NodeIndex = std::uint32_t;
+
+  static constexpr NodeIndex kRoot = 0;
+  static constexpr NodeIndex kNone = ~NodeIndex{0};
+  static constexpr unsigned kDefaultDepth = 6;
+  static constexpr std::size_t kDefaultStates = std::size_t{1} << 22;
+
+  struct Node {
+    std::uint64_t count = 0;
+    Move move;  // the move leading here from the parent; none at the root
+    NodeIndex parent = kNone;
+    NodeIndex first_child = kNone;
+    NodeIndex next_sibling = kNone;
+  };
+
+  explicit HistoryCounts(const BoardKey& key,
+                         unsigned max_depth = kDefaultDepth,
+                         std::size_t max_states = kDefaultStates);
+
+  // Counts the positions of one game of the board.
+  void add(std::span<const Move> moves);
+  // Same for a recorded game. Games of another board and games with
+  // malformed moves are not counted but added to skipped(); returns whether
+  // the game counted.
+  bool add(const wire::GameStateView& game);
+  // Counts every game of a stream of game-state frames, in constant memory
+  // besides the trie. Throws wire::WireError for a malformed stream.
+  void ingest(std::istream& in);
+
+  const BoardKey& key() const { return key_; }
+  unsigned max_depth() const { return max_depth_; }
+  std::uint64_t games() const { return games_; }
+  std::uint64_t skipped() const { return skipped_; }
+  // Highest count of a dropped position.
+  std::uint64_t error() const { return error_; }
+  // Positions counted.
+  std::size_t size() const { return nodes_.size(); }
+
+  const Node& node(NodeIndex index) const { return nodes_[index]; }
+  // The position the moves lead to, or kNone when it is not counted.
+  NodeIndex find(std::span<const Move> moves) const;
+  std::uint64_t count(std::span<const Move> moves) const {
+    const NodeIndex index = find(moves);
+    return index == kNone ? 0 : nodes_[index].count;
+  }
+  // Replaces `out` with the moves leading to the position.
+  void history(NodeIndex index, std::vector<Move>& out) const;
+
+ private:
+  struct Edge {
+    NodeIndex parent;
+    std::uint32_t guess;
+    std::uint8_t feedback;
+
+    friend bool operator==(const Edge&, const Edge&) = default;
+  };
+  struct EdgeHash {
+    std::size_t operator()(const Edge& edge) const;
+  };
+
+  static Edge edge(NodeIndex parent, Move move) {
+    return {parent, move.guess.bits(), move.feedback.raw()};
+  }
+  // The child of `parent` by `move`, added when new.
+  NodeIndex child(NodeIndex parent, Move move);
+  void link(NodeIndex index);
+  void prune();
+
+  BoardKey key_;
+  unsigned max_depth_;
+  std::size_t max_states_;
+  std::uint64_t games_ = 0;
+  std::uint64_t skipped_ = 0;
+  std::uint64_t error_ = 0;
+  // Parents come before their children.
+  std::vector<Node> nodes_;
+  std::unordered_map<Edge, NodeIndex, EdgeHash> edges_;
+};
+
+// An opening book: the partial StrategyTree (see StrategyTree::partial) of
+// the `states` most frequent positions, as `counts` has them, that a solver
+// with `options` reaches by playing its own guesses. A position where games
+// guessed something else cannot be in a tree, so it is left to the search.
+// Each node is the solver's guess at its position. The positions are taken
+// most frequent first. Those the solver finds inconsistent are skipped.
+// Throws std::invalid_argument for a board make_solver has no solver for.
+StrategyTree build_opening_book(const HistoryCounts& counts,
+                                std::size_t states,
+                                const SolverOptions& options);
+
+// Fraction of the positions counted in `counts` that `book` answers, each
+// weighted by its count.
+double book_coverage(const StrategyTree& book, const HistoryCounts& counts);
+
+// File name of a board's opening book, e.g. book-v1-4x6-dup-minimax.bin.
+std::string opening_book_name(const BoardKey& key, Strategy strategy);
+
+}  // namespace mastermyr
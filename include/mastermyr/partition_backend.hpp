@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+// Computes the feedback histograms of many guesses at once, for searches
+// large enough to pay for handing them to an accelerator. Implementations
+// are thread-safe.
+class PartitionBackend {
+ public:
+  virtual ~PartitionBackend() = default;
+
+  virtual const char* name() const = 0;
+
+  // counts[g * feedback_slots(pegs) + f.raw()] = number of candidates that
+  // score f against guesses[g]. `counts` holds guesses.size() *
+  // feedback_slots(pegs) entries.
+  virtual void partitions(std::span<const Code> guesses,
+                          std::span<const Code> candidates, unsigned pegs,
+                          std::span<std::uint32_t> counts) = 0;
+};
+
+// The CUDA backend when the library was built with MASTERMYR_CUDA and a
+// device is present at runtime, else null.
+std::shared_ptr<PartitionBackend> detect_partition_backend();
+
+// The backend interface implemented with the CPU scoring kernels, as a
+// reference to check device backends against.
+std::shared_ptr<PartitionBackend> make_host_backend();
+
+// "auto" (detect_partition_backend), "cpu" (null: search on the CPU),
+// "host" or "cuda". Throws std::invalid_argument for another name or for
+// "cuda" without a device.
+std::shared_ptr<PartitionBackend> make_partition_backend(std::string_view name);
+
+}  // namespace mastermyr
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/guess_search.hpp"
+#include "mastermyr/thread_pool.hpp"
+
+namespace mastermyr {
+
+// The feedback histogram of every code of the board, as a guess, over the
+// current candidates, kept up to date across moves. A move removes the
+// candidates that did not score its feedback; subtracting their histograms
+// costs guesses x removed, where recounting costs guesses x remaining, so
+// the owner updates incrementally when fewer candidates go than stay and
+// invalidates otherwise. While valid, a search rates any guess with one
+// histogram read instead of a pass over the candidates.
+template <unsigned Pegs, unsigned Colours>
+class PartitionCache {
+ public:
+  using Search = GuessSearch<Pegs, Colours>;
+  using Histogram = typename Search::Histogram;
+
+  PartitionCache(const Search* search, ThreadPool* pool)
+      : search_(search), pool_(pool) {}
+
+  bool valid() const { return valid_; }
+  void invalidate() { valid_ = false; }
+
+  // Counts every code of `guesses`, whose ids must be 0..n-1 in order, over
+  // `candidates`.
+  void rebuild(const CandidateSet& guesses, const CandidateSet& candidates) {
+    histograms_.resize(guesses.size());
+    parallel(guesses.size(), [&](std::size_t begin, std::size_t end) {
+      for (std::size_t g = begin; g < end; ++g) {
+        histograms_[g] = search_->partition(guesses[g], guesses.ids()[g],
+                                            candidates);
+      }
+    });
+    valid_ = true;
+  }
+
+  // Takes `removed`, which must have been among the candidates, out of every
+  // histogram.
+  void remove(const CandidateSet& guesses, const CandidateSet& removed) {
+    parallel(guesses.size(), [&](std::size_t begin, std::size_t end) {
+      for (std::size_t g = begin; g < end; ++g) {
+        const Histogram gone =
+            search_->partition(guesses[g], guesses.ids()[g], removed);
+        Histogram& histogram = histograms_[g];
+        for (std::size_t k = 0; k < histogram.size(); ++k) {
+          histogram[k] -= gone[k];
+        }
+      }
+    });
+  }
+
+  // Indexed by guess id; only meaningful while valid().
+  std::span<const Histogram> histograms() const { return histograms_; }
+
+ private:
+  // Guesses per parallel_for chunk.
+  static constexpr std::size_t kGrain = 16;
+
+  template <typename Body>
+  void parallel(std::size_t n, Body&& body) {
+    if (pool_ != nullptr) {
+      pool_->parallel_for(
+          n, kGrain,
+          [&](std::size_t begin, std::size_t end, unsigned) {
+            body(begin, end);
+          });
+    } else {
+      body(0, n);
+    }
+  }
+
+  const Search* search_;
+  ThreadPool* pool_;
+  std::vector<Histogram> histograms_;
+  bool valid_ = false;
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr {
+
+// Constraint propagation over a game's feedback, CSP style: a domain of
+// possible colours per peg and bounds on how often each colour occurs in the
+// secret, narrowed to a fixpoint after every move without looking at a
+// single code. Every rule only removes values that no consistent code uses,
+// so the domains over-approximate the candidates; an empty domain or
+// crossed bounds prove the history inconsistent outright.
+//
+// Rules, per move with guess g, b blacks and t = b + w matches:
+//   - blacks: pegs whose domain is {g[i]} are certain blacks and pegs whose
+//     domain holds g[i] possible ones; b between them, and equal to either
+//     bound, fixes the rest of the pegs against g.
+//   - matches: t = sum over colours c of min(g_c, s_c), so the bounds on the
+//     other colours bound min(g_c, s_c), hence s_c, from both sides.
+//   - counts: a colour occurs at most once per peg whose domain holds it,
+//     at least once per peg fixed to it, and the lower bounds of all colours
+//     share the pegs; a colour whose pegs are all needed fixes them.
+//
+// The propagator answers consistency questions cheaply and seeds the
+// CandidateGenerator, whose search then only tries colours in each domain.
+class Propagator {
+ public:
+  using Domain = std::uint16_t;  // bit c set when colour c is possible
+
+  Propagator(unsigned pegs, unsigned colours);
+
+  // Back to an empty history.
+  void reset();
+
+  // Adds a move and propagates. Returns false once the history is proven
+  // inconsistent; further moves are ignored after that.
+  bool add(Move move);
+  bool add(std::span<const Move> moves);
+
+  // False only when no code can be consistent.
+  bool consistent() const { return consistent_; }
+
+  unsigned pegs() const { return pegs_; }
+  unsigned colours() const { return colours_; }
+  std::span<const Move> history() const { return history_; }
+  Domain domain(unsigned peg) const { return domains_[peg]; }
+  unsigned min_count(unsigned colour) const { return lo_[colour]; }
+  unsigned max_count(unsigned colour) const { return hi_[colour]; }
+
+  // Whether `code` fits the domains and colour bounds: a necessary
+  // condition for consistency, checked in O(pegs + colours).
+  bool admits(Code code) const;
+
+  // Whether `secret` is still possible: admitted and scoring every move's
+  // feedback. For checking a player's claimed secret at the end of a game.
+  bool possible(Code secret) const;
+
+  // Whether any code is consistent, by propagation and, if that does not
+  // decide it, a search for one code.
+  bool satisfiable() const;
+
+  // Product of the domain sizes: an upper bound on the candidates.
+  double space_size() const;
+
+ private:
+  bool propagate();
+  bool propagate_blacks(const Move& move, bool& changed);
+  bool propagate_matches(const Move& move, bool& changed);
+  bool propagate_counts(bool& changed);
+  bool restrict(unsigned peg, Domain domain, bool& changed);
+
+  unsigned pegs_;
+  unsigned colours_;
+  std::vector<Move> history_;
+  std::array<Domain, kMaxPegs> domains_{};
+  std::array<std::uint8_t, kMaxColours> lo_{};
+  std::array<std::uint8_t, kMaxColours> hi_{};
+  bool consistent_ = true;
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+// The rules of a game variant, as a compile-time policy of Solver: which
+// codes the board has, how a guess scores against a secret, the opening,
+// and whether a guess may depend on the feedback of earlier ones. A
+// variant's Solver enumerates, numbers and tabulates only the variant's
+// codes, and picks its opening and probe schedule at compile time.
+//
+// Two codes of any variant score as in Mastermind, so candidate filtering
+// and partitioning use the shared score_batch kernels or feedback matrix
+// for every variant. score() here is the scalar reference behind
+// Solver::score, which tests, benchmarks and the strategy-tree compiler's
+// feedback checks call.
+template <DuplicateRule Duplicates, bool Adaptive>
+struct Rules {
+  static constexpr DuplicateRule kDuplicates = Duplicates;
+  static constexpr bool kDistinct = Duplicates == DuplicateRule::kForbidden;
+  // False for Static Mastermind: every probe is chosen before any feedback
+  // is known, and the last guess is the code that their feedback pins down.
+  static constexpr bool kAdaptive = Adaptive;
+
+  // Codes of the board: colours^pegs, or the falling factorial when no
+  // colour may repeat.
+  static constexpr std::size_t code_count(unsigned pegs, unsigned colours) {
+    std::size_t n = 1;
+    for (unsigned i = 0; i < pegs; ++i) n *= kDistinct ? colours - i : colours;
+    return n;
+  }
+
+  static constexpr bool is_code(Code code, unsigned pegs) {
+    return !kDistinct || !has_repeated_colour(code, pegs);
+  }
+
+  // Feedback of `guess` against `secret`, both codes of the board. Without
+  // repeats a colour occurs at most once in each, so the colours in common
+  // are one AND of colour masks instead of a loop over colour counts. The
+  // result is Mastermind's either way.
+  template <unsigned Pegs, unsigned Colours>
+  static constexpr Feedback score(Code guess, Code secret) {
+    unsigned black = 0;
+    for (unsigned i = 0; i < Pegs; ++i) black += guess.peg(i) == secret.peg(i);
+    unsigned total = 0;
+    if constexpr (kDistinct) {
+      std::uint32_t g = 0;
+      std::uint32_t s = 0;
+      for (unsigned i = 0; i < Pegs; ++i) {
+        g |= std::uint32_t{1} << guess.peg(i);
+        s |= std::uint32_t{1} << secret.peg(i);
+      }
+      total = static_cast<unsigned>(std::popcount(g & s));
+    } else {
+      std::array<std::uint8_t, Colours> g{};
+      std::array<std::uint8_t, Colours> s{};
+      for (unsigned i = 0; i < Pegs; ++i) {
+        ++g[guess.peg(i)];
+        ++s[secret.peg(i)];
+      }
+      for (unsigned c = 0; c < Colours; ++c) total += std::min(g[c], s[c]);
+    }
+    return Feedback(black, total - black);
+  }
+
+  // Knuth-style colours in pairs (0011 on four pegs), or 0123.. when no
+  // colour may repeat.
+  template <unsigned Pegs, unsigned Colours>
+  static constexpr Code opening() {
+    Code code;
+    for (unsigned i = 0; i < Pegs; ++i) {
+      code = code.with_peg(i, (kDistinct ? i : i / 2) % Colours);
+    }
+    return code;
+  }
+};
+
+using Mastermind = Rules<DuplicateRule::kAllowed, true>;
+// Bulls & Cows is this on 4x10: bulls are black pegs, cows white ones.
+using NoDuplicates = Rules<DuplicateRule::kForbidden, true>;
+using StaticMastermind = Rules<DuplicateRule::kAllowed, false>;
+
+// The variants by name, for picking rules at runtime (see make_solver).
+enum class Variant : std::uint8_t {
+  kMastermind,
+  kNoDuplicates,
+  kStatic,
+};
+
+const char* variant_name(Variant variant);
+// Also accepts "bulls-and-cows" for kNoDuplicates.
+std::optional<Variant> parse_variant(std::string_view name);
+
+template <typename R>
+constexpr Variant variant_of() {
+  if constexpr (!R::kAdaptive) {
+    return Variant::kStatic;
+  } else {
+    return R::kDistinct ? Variant::kNoDuplicates : Variant::kMastermind;
+  }
+}
+
+constexpr DuplicateRule duplicate_rule(Variant variant) {
+  return variant == Variant::kNoDuplicates ? DuplicateRule::kForbidden
+                                           : DuplicateRule::kAllowed;
+}
+
+}  // namespace mastermyr
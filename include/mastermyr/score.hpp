@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+enum class Isa { kScalar, kAvx2, kAvx512, kNeon };
+
+const char* isa_name(Isa isa);
+
+// Whether this build has a kernel for `isa` and the CPU can run it, from
+// cpuid on x86 and getauxval on AArch64.
+bool isa_supported(Isa isa);
+
+// The kernel score_batch runs, chosen once on first use: the widest
+// supported one, or the one named by the MASTERMYR_ISA environment variable
+// (scalar, avx2, avx512 or neon) when that is supported too.
+Isa active_isa();
+
+// Scores `guess` against candidates[0, count) and writes one feedback per
+// candidate to out[0, count). This is the solver's inner loop; filtering and
+// partition histograms run on it.
+void score_batch(Code guess, const Code* candidates, std::size_t count,
+                 Feedback* out, unsigned pegs);
+
+namespace kernels {
+
+// Per-ISA entry points, exposed so that benchmarks and tests can compare
+// them. The build defines MASTERMYR_HAVE_* for the kernels of the target
+// architecture, each compiled for its own ISA whatever the rest of the
+// library targets; call one only when isa_supported says the CPU has it.
+void score_batch_scalar(Code guess, const Code* candidates, std::size_t count,
+                        Feedback* out, unsigned pegs);
+
+#if defined(MASTERMYR_HAVE_AVX2)
+void score_batch_avx2(Code guess, const Code* candidates, std::size_t count,
+                      Feedback* out, unsigned pegs);
+#endif
+
+#if defined(MASTERMYR_HAVE_AVX512)
+void score_batch_avx512(Code guess, const Code* candidates, std::size_t count,
+                        Feedback* out, unsigned pegs);
+#endif
+
+#if defined(MASTERMYR_HAVE_NEON)
+void score_batch_neon(Code guess, const Code* candidates, std::size_t count,
+                      Feedback* out, unsigned pegs);
+#endif
+
+}  // namespace kernels
+}  // namespace mastermyr
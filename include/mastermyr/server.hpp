@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/solver.hpp"
+#include "mastermyr/strategy_tree.hpp"
+#include "mastermyr/thread_pool.hpp"
+#include "mastermyr/wire.hpp"
+
+namespace mastermyr {
+
+struct ServerOptions {
+  std::string host = "0.0.0.0";
+  // 0 picks a free port; see Server::port().
+  std::uint16_t port = 7411;
+  // Event loops, each with its own SO_REUSEPORT listener and epoll set.
+  unsigned io_threads = 1;
+  int backlog = 1024;
+  // Requests a connection may have unanswered; past it the connection is
+  // not read until answers go out, so a client that stops reading stops
+  // costing memory and solver time.
+  std::size_t max_pipelined = 1024;
+  // Loop i is pinned to NUMA node i % numa::nodes() and its requests run on
+  // that node's pool workers, so every game a connection plays stays on one
+  // node. Wants a pinned pool and at least one loop per node.
+  bool numa = false;
+};
+
+// Builds a solver for the served board. Called from pool threads.
+using SolverFactory = std::function<std::unique_ptr<GameSolver>()>;
+
+// Event-loop server answering next-guess requests for one board. A request
+// is a wire game-state frame and its response a wire answer frame; clients
+// may send any number of requests without waiting, and responses come back
+// in request order. A client may shut down its sending side once it has
+// sent everything; it is still answered, and the connection closes after the
+// last response.
+//
+// I/O threads only move bytes: they accept, read frames, and write
+// responses. Every request becomes a task on the pool, which takes an idle
+// solver from a shared free list, replays the history and searches. The
+// finished response is posted back to the connection's I/O thread through
+// an eventfd, and the I/O thread writes responses out in request order, so
+// pipelined requests on one connection are solved in parallel. Idle solvers
+// are kept per NUMA node, so a solver's arena stays on the node whose
+// threads first touched it.
+//
+// With an opening book set, a request whose history follows the book is
+// answered from it by the pool task, one lookup per move, before any solver
+// is taken. The book can be replaced while serving.
+class Server {
+ public:
+  // Binds and listens; throws std::system_error.
+  Server(ServerOptions options, unsigned pegs, unsigned colours,
+         SolverFactory factory, std::shared_ptr<ThreadPool> pool);
+  ~Server();
+
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+
+  std::uint16_t port() const { return port_; }
+
+  // Runs the I/O threads until stop(); returns once they have exited.
+  void run();
+  // Safe to call from any thread, including a signal-handling one.
+  void stop();
+
+  std::uint64_t requests() const {
+    return requests_.load(std::memory_order_relaxed);
+  }
+  std::uint64_t book_hits() const {
+    return book_hits_.load(std::memory_order_relaxed);
+  }
+
+  // Swaps in a book (see opening_book.hpp), or removes it when null. Safe
+  // to call from any thread; requests already past the lookup finish on the
+  // book they read. Throws std::invalid_argument for another board's tree.
+  // The book has to come from solvers like the factory's to play the same
+  // guesses they would.
+  void set_book(std::shared_ptr<const StrategyTree> book);
+  std::shared_ptr<const StrategyTree> book() const {
+    return book_.load(std::memory_order_acquire);
+  }
+  // Request count and metrics dump; also the reply to a stats request.
+  std::string stats() const;
+
+ private:
+  class Loop;
+  friend class Loop;
+
+  std::unique_ptr<GameSolver> acquire_solver();
+  void release_solver(std::unique_ptr<GameSolver> solver);
+  // Solves one game-state body into an answer frame.
+  void solve(std::span<const std::byte> request, std::byte* response);
+
+  ServerOptions options_;
+  unsigned pegs_;
+  unsigned colours_;
+  SolverFactory factory_;
+  std::shared_ptr<ThreadPool> pool_;
+  std::uint16_t port_ = 0;
+  std::vector<std::unique_ptr<Loop>> loops_;
+  std::mutex idle_mutex_;
+  std::vector<std::vector<std::unique_ptr<GameSolver>>> idle_;  // per node
+  std::atomic<std::uint64_t> requests_{0};
+  std::atomic<std::uint64_t> book_hits_{0};
+  std::atomic<std::shared_ptr<const StrategyTree>> book_;
+  // Pool tasks not yet finished; the destructor waits for them.
+  std::atomic<std::uint64_t> inflight_{0};
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "mastermyr/arena.hpp"
+#include "mastermyr/code.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr {
+
+class SessionHost;
+
+enum class SessionState : std::uint8_t {
+  kPlaying,       // guess() waits for its feedback
+  kSolved,        // the last guess scored all blacks
+  kInconsistent,  // no code fits the feedback given
+  kFailed,        // the solver threw; feedback() or start() rethrew it
+};
+
+// One game as a coroutine: it computes a guess, suspends until feedback()
+// hands it the score, and resumes straight into the solver for the next
+// guess. A suspended game holds no thread and no solver, only its coroutine
+// frame and the moves so far, both taken from a small per-game arena on its
+// host's pooled memory, so one thread can keep hundreds of thousands of
+// games open and advance whichever has feedback.
+//
+// Moves only; destroying a session ends its game. Not thread-safe, and the
+// host must outlive it.
+class GameSession {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  GameSession(GameSession&& other) noexcept;
+  GameSession& operator=(GameSession&& other) noexcept;
+  GameSession(const GameSession&) = delete;
+  GameSession& operator=(const GameSession&) = delete;
+  ~GameSession();
+
+  SessionState state() const;
+  // The guess waiting for feedback; meaningful while kPlaying.
+  Code guess() const;
+  // Resumes the game with the feedback for guess() and returns once it has
+  // its next guess or is over. Precondition: kPlaying. Rethrows what the
+  // solver throws besides InconsistentFeedback, which ends the game.
+  void feedback(Feedback feedback);
+
+  std::span<const Move> history() const;
+  ArenaStats arena_stats() const;
+
+ private:
+  friend class SessionHost;
+  explicit GameSession(Handle handle) : handle_(handle) {}
+
+  Handle handle_;
+};
+
+struct GameSession::promise_type {
+  explicit promise_type(SessionHost& host);
+  ~promise_type();
+
+  // The frame comes from the host's pool; its resource is stored in front
+  // of it for operator delete.
+  static void* operator new(std::size_t size, SessionHost& host);
+  static void operator delete(void* frame, std::size_t size);
+
+  GameSession get_return_object() {
+    return GameSession(Handle::from_promise(*this));
+  }
+  // Runs to the first guess before start() returns.
+  std::suspend_never initial_suspend() noexcept { return {}; }
+  // Kept until the session is destroyed, which frees the frame.
+  std::suspend_always final_suspend() noexcept { return {}; }
+  void return_void() {}
+  void unhandled_exception() { error = std::current_exception(); }
+
+  // co_await promise.ask(guess) publishes the guess and suspends; it
+  // resumes with the feedback passed to GameSession::feedback().
+  auto ask(Code next) {
+    struct Awaiter {
+      promise_type& promise;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(Handle) const noexcept {}
+      Feedback await_resume() const noexcept { return promise.answer; }
+    };
+    guess = next;
+    return Awaiter{*this};
+  }
+
+  SessionHost& host;
+  // The host's solver state belongs to the session with this id.
+  std::uint64_t id;
+  GameArena arena;
+  std::pmr::vector<Move> history;
+  Code guess;
+  Feedback answer;
+  SessionState state = SessionState::kPlaying;
+  std::exception_ptr error;
+};
+
+// Runs games on the calling thread with one shared solver. Advancing a game
+// replays its moves into the solver unless the solver last advanced that
+// same game, so games played move after move without interleaving cost no
+// more than a solver of their own.
+//
+// Not thread-safe: one host per thread.
+class SessionHost {
+ public:
+  explicit SessionHost(std::unique_ptr<GameSolver> solver);
+
+  SessionHost(const SessionHost&) = delete;
+  SessionHost& operator=(const SessionHost&) = delete;
+
+  unsigned pegs() const { return solver_->pegs(); }
+  unsigned colours() const { return solver_->colours(); }
+
+  // Starts a game; it returns with its first guess.
+  GameSession start();
+
+  // Sessions started and not yet destroyed.
+  std::size_t live() const { return live_; }
+  // Moves recorded into the solver to switch it between games.
+  std::uint64_t replayed_moves() const { return replayed_; }
+
+ private:
+  friend struct GameSession::promise_type;
+
+  // Per-game arenas start this small; the history of a long game grows it.
+  static constexpr std::size_t kSessionChunk = 256;
+
+  static GameSession play(SessionHost& host);
+  // The solver's next guess after `game`'s history.
+  Code advance(const GameSession::promise_type& game);
+
+  std::unique_ptr<GameSolver> solver_;
+  std::pmr::unsynchronized_pool_resource frames_;
+  std::uint64_t next_id_ = 0;
+  static constexpr std::uint64_t kNoOwner = ~std::uint64_t{0};
+
+  std::uint64_t owner_ = kNoOwner;  // id of the game in the solver
+  std::size_t owner_moves_ = 0;     // of its moves recorded there
+  std::size_t live_ = 0;
+  std::uint64_t replayed_ = 0;
+};
+
+}  // namespace mastermyr
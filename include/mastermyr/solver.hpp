@@ -0,0 +1,544 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "mastermyr/arena.hpp"
+#include "mastermyr/boards.hpp"
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/compact_candidates.hpp"
+#include "mastermyr/code.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/guess_search.hpp"
+#include "mastermyr/partition_cache.hpp"
+#include "mastermyr/rules.hpp"
+#include "mastermyr/score.hpp"
+#include "mastermyr/symmetry.hpp"
+#include "mastermyr/thread_pool.hpp"
+#include "mastermyr/transposition_table.hpp"
+
+namespace mastermyr {
+
+struct Move {
+  Code guess;
+  Feedback feedback;
+};
+
+// Thrown when the recorded feedback leaves no code consistent with it.
+class InconsistentFeedback : public std::runtime_error {
+ public:
+  InconsistentFeedback()
+      : std::runtime_error("feedback is inconsistent with the history") {}
+};
+
+struct SolverOptions {
+  Strategy strategy = Strategy::kMinimax;
+  // Upper bound on the guesses evaluated per move. Boards with at most this
+  // many codes search the whole code space; larger ones search the
+  // candidates, sampled at an even stride down to this many.
+  std::size_t max_guesses = 4096;
+  // Search the first move too instead of playing opening_guess().
+  bool search_opening = false;
+  // Rate one guess per orbit of the position's colour and peg symmetries.
+  bool symmetry = true;
+  // Branch-and-bound pruning of guesses that cannot beat the best so far.
+  bool prune = true;
+  // On boards whose whole code space is searched, keep every guess's
+  // partition across moves and update it by the removed candidates.
+  bool incremental = true;
+  // Precomputed feedback for the board. When set, scoring becomes a table
+  // lookup by code index.
+  std::shared_ptr<const FeedbackMatrix> feedback_matrix;
+  // Pool the guess search runs on; null searches on the calling thread.
+  std::shared_ptr<ThreadPool> pool;
+  // Accelerator for large searches; null scores everything on the CPU.
+  std::shared_ptr<PartitionBackend> backend;
+  // Cache of searched positions, consulted before every search. May be
+  // shared by solvers of any board, strategy, max_guesses and symmetry
+  // setting. Only exact searches are stored, never estimated or timed-out
+  // ones, so an entry is the guess a full search of the position would make.
+  std::shared_ptr<TranspositionTable> transposition_table;
+  // Boards without a specialisation (see make_solver) never enumerate their
+  // code space. Each move enumerates the consistent codes while there are
+  // at most `sample_budget` of them, and samples a larger set by
+  // `sample_budget / pegs` random descents of the generator instead (see
+  // CandidateGenerator::draw), which take about as long. Either way it
+  // draws up to `reservoir` candidates uniformly from the consistent set
+  // and rates up to max_guesses of them against that sample.
+  std::size_t reservoir = 1024;
+  std::size_t sample_budget = std::size_t{1} << 18;
+  // Time a move's search may take; zero searches to completion. Searches
+  // stopped by it play the best guess rated so far (see GuessSearch) and
+  // are not stored in the transposition table. A budget also turns off
+  // `symmetry` and `incremental`, whose passes over the whole code space
+  // take longer than a short budget.
+  std::chrono::microseconds time_budget{0};
+  // Searches over at least this many candidates estimate every guess on a
+  // growing random sample of them and rate only the best few exactly (see
+  // GuessSearch), but never fewer than GuessSearch::kMinEstimated (4096);
+  // 0 rates every guess exactly. Such moves are no longer
+  // guaranteed the strategy's best, but large boards' early moves get
+  // faster by an order of magnitude.
+  std::size_t estimate_from = std::size_t{1} << 14;
+};
+
+constexpr std::size_t code_count(unsigned pegs, unsigned colours) {
+  std::size_t n = 1;
+  for (unsigned i = 0; i < pegs; ++i) n *= colours;
+  return n;
+}
+
+// Solver specialised for one board. Everything that depends on the board size
+// -- peg loops, colour histograms and the feedback histogram -- is sized at
+// compile time, so scoring unrolls completely and partitions are counted in a
+// flat std::array indexed by Feedback::raw(). The variant's rules (see
+// rules.hpp) are a compile-time policy too: they decide the board's codes,
+// its scoring and, for Static Mastermind, how guesses are chosen.
+template <unsigned Pegs, unsigned Colours, typename GameRules = Mastermind>
+class Solver {
+  static_assert(Pegs >= 1 && Pegs <= kMaxPegs, "unsupported peg count");
+  static_assert(Colours >= 2 && Colours <= kMaxColours,
+                "unsupported colour count");
+  static_assert(!GameRules::kDistinct || Colours >= Pegs,
+                "too few colours for codes without repeats");
+
+ public:
+  static constexpr unsigned kPegs = Pegs;
+  static constexpr unsigned kColours = Colours;
+  static constexpr std::size_t kCodeCount =
+      GameRules::code_count(Pegs, Colours);
+  static constexpr std::size_t kFeedbackSlots = feedback_slots(Pegs);
+  static constexpr Feedback kSolved = solved_feedback(Pegs);
+
+  using Histogram = typename GuessSearch<Pegs, Colours>::Histogram;
+
+  // Feedback of two codes of the board.
+  static constexpr Feedback score(Code guess, Code secret) {
+    return GameRules::template score<Pegs, Colours>(guess, secret);
+  }
+
+  // Knuth-style opening: colours in pairs, 0011 on four pegs; 0123 when
+  // colours may not repeat.
+  static constexpr Code opening_guess() {
+    return GameRules::template opening<Pegs, Colours>();
+  }
+
+  static constexpr BoardKey kBoardKey = {Pegs, Colours,
+                                         GameRules::kDuplicates};
+
+  explicit Solver(SolverOptions options = {})
+      : options_(std::move(options)),
+        matrix_(options_.feedback_matrix.get()),
+        search_(options_.strategy, options_.pool.get(), matrix_,
+                options_.prune, options_.backend.get(),
+                options_.estimate_from),
+        partitions_(&search_, options_.pool.get()),
+        candidates_(kCodeCount),
+        symmetry_(Pegs, Colours),
+        tracking_(GameRules::kAdaptive && options_.incremental &&
+                  options_.time_budget.count() == 0 &&
+                  kCodeCount <= options_.max_guesses) {
+    if (matrix_ != nullptr && matrix_->key() != kBoardKey) {
+      throw std::invalid_argument("feedback matrix is for another board");
+    }
+    // Without duplicates ids are ranks, which only all_codes_ maps to codes;
+    // static probes are chosen from the whole board.
+    if (kCodeCount <= options_.max_guesses || options_.symmetry ||
+        GameRules::kDistinct || !GameRules::kAdaptive) {
+      all_codes_.assign_all(Pegs, Colours, GameRules::kDuplicates);
+      ordered_.reserve(kCodeCount);
+      member_.resize(kCodeCount);
+      is_candidate_.reserve(kCodeCount);
+    }
+    reset();
+  }
+
+  // Holds pointers into itself.
+  Solver(const Solver&) = delete;
+  Solver& operator=(const Solver&) = delete;
+
+  // Starts a new game. Reuses the candidate buffers and rewinds the game
+  // arena, so after the first few games it does not allocate.
+  void reset() {
+    rewind_arena();
+    candidates_.assign_all(Pegs, Colours, GameRules::kDuplicates);
+    symmetry_.reset();
+    partitions_.invalidate();
+  }
+
+  // Next guess by the configured strategy. Throws InconsistentFeedback when
+  // no code is left. Under static rules this is the probe book's next probe
+  // whatever the feedback so far (see build_probes), and once the book is
+  // played, the code its feedback leaves.
+  Code next_guess() {
+    using Search = GuessSearch<Pegs, Colours>;
+    const typename Search::Clock::time_point start = Search::Clock::now();
+    const typename Search::Clock::time_point deadline =
+        options_.time_budget.count() == 0 ? Search::kNoDeadline
+                                          : start + options_.time_budget;
+    last_search_ = {};
+    if (candidates_.empty()) throw InconsistentFeedback();
+    if constexpr (!GameRules::kAdaptive) {
+      if (probes_.empty()) build_probes();
+      return history_.size() < probes_.size() ? probes_[history_.size()]
+                                              : candidates_[0];
+    }
+    if (history_.empty() && !options_.search_opening) return opening_guess();
+    if (candidates_.size() <= 2) return candidates_[0];
+    TranspositionTable* table = options_.transposition_table.get();
+    PositionKey key;
+    if (table != nullptr) {
+      key = position_key(candidates_, table_seed());
+      if (const auto hit = table->lookup(key)) return hit->guess;
+    }
+    // The cache is only worth building when no symmetry shrinks the space;
+    // once built, it serves any space.
+    if (tracking_ && !partitions_.valid() && !reduce_symmetry()) {
+      partitions_.rebuild(all_codes_, candidates_);
+    }
+    const SearchSpace space = search_space();
+    const GuessChoice choice = search_.best(
+        candidates_, space,
+        partitions_.valid() ? partitions_.histograms()
+                            : std::span<const Histogram>(),
+        &arena_, deadline, &last_search_);
+    last_search_.elapsed = Search::Clock::now() - start;
+    if (table != nullptr && last_search_.exact()) {
+      table->store(key, {choice.guess, static_cast<float>(choice.cost)});
+    }
+    return choice.guess;
+  }
+
+  // Records the feedback for a guess and drops the codes it rules out.
+  void record(Code guess, Feedback feedback) {
+    const bool first = history_.empty() && candidates_.size() == kCodeCount;
+    history_.push_back({guess, feedback});
+    symmetry_.record(guess);
+    const bool update = partitions_.valid();
+    if (update) previous_ = candidates_;
+    if (first && !update && guess == opening_guess()) {
+      // Most games open alike, so the opening's survivors are kept as
+      // bitmaps rather than filtered out of the whole board every game.
+      if (opening_.empty()) {
+        opening_ = all_codes_.empty()
+                       ? FeedbackBitmaps(guess, Pegs, Colours)
+                       : FeedbackBitmaps(guess, all_codes_.codes(), Pegs);
+      }
+      CompactCandidates::expand(opening_.of(feedback), candidates_, Pegs,
+                                Colours, all_codes());
+    } else if (matrix_ != nullptr && GameRules::is_code(guess, Pegs)) {
+      candidates_.filter(matrix_->row(board_id(guess)), feedback);
+    } else {
+      candidates_.filter(guess, feedback, Pegs);
+    }
+    if (!update) return;
+    // Subtracting the removed candidates beats recounting the remaining
+    // ones only while fewer go than stay.
+    if (previous_.size() - candidates_.size() < candidates_.size()) {
+      collect_removed();
+      partitions_.remove(all_codes_, removed_);
+    } else {
+      partitions_.invalidate();
+    }
+  }
+
+  // Everything record() changes, so that a caller can explore several
+  // continuations of one position without replaying its history. The
+  // candidates are kept compact, a bitmap while dense.
+  struct Position {
+    CompactCandidates candidates;
+    Symmetry symmetry{Pegs, Colours};
+    std::vector<Move> history;
+  };
+
+  void save(Position& position) const {
+    position.candidates.assign(candidates_, kCodeCount);
+    position.symmetry = symmetry_;
+    position.history.assign(history_.begin(), history_.end());
+  }
+  void restore(const Position& position) {
+    rewind_arena();
+    position.candidates.expand(candidates_, Pegs, Colours, all_codes());
+    symmetry_ = position.symmetry;
+    partitions_.invalidate();
+    history_.assign(position.history.begin(), position.history.end());
+  }
+
+  bool solved() const {
+    return !history_.empty() && history_.back().feedback == kSolved;
+  }
+  std::size_t remaining() const { return candidates_.size(); }
+  const CandidateSet& candidates() const { return candidates_; }
+  std::span<const Move> history() const { return history_; }
+  const SolverOptions& options() const { return options_; }
+  // The search of the last next_guess(), its elapsed time being the whole
+  // call's; empty when it played a guess without one (the opening, a last
+  // candidate, a table hit).
+  const SearchStats& last_search() const { return last_search_; }
+  // Per-game scratch: searches and the history allocate from the arena,
+  // which is released whenever a game starts or a position is restored.
+  ArenaStats arena_stats() const { return arena_.stats(); }
+
+ private:
+  // The history lives in the arena, so it is dropped before rewinding.
+  void rewind_arena() {
+    history_ = std::pmr::vector<Move>(&arena_);
+    arena_.release();
+    history_.reserve(16);
+  }
+
+  // The board in id order when the solver keeps it, for expanding ids.
+  const CandidateSet* all_codes() const {
+    return all_codes_.empty() ? nullptr : &all_codes_;
+  }
+
+  // Id of a code of the board: its index, or without duplicates its rank,
+  // found in all_codes_ since codes order as their indices do.
+  std::uint32_t board_id(Code code) const {
+    if constexpr (GameRules::kDistinct) {
+      const std::span<const Code> codes = all_codes_.codes();
+      return static_cast<std::uint32_t>(
+          std::lower_bound(codes.begin(), codes.end(), code) - codes.begin());
+    } else {
+      return code_index(code, Pegs, Colours);
+    }
+  }
+
+  // Static Mastermind's probes, chosen greedily: each is the guess whose
+  // feedback best splits the classes of codes that the probes before it
+  // cannot tell apart, rated by the strategy over every (class, feedback)
+  // cell, until every class is a single code. Guesses are tried one per
+  // orbit of the probes' symmetries and must split some class. Built on the
+  // first move; later games replay it.
+  void build_probes() {
+    constexpr std::size_t kRanks = feedback_ranks(Pegs);
+    constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> class_of(kCodeCount, 0);
+    std::vector<std::uint32_t> cells;
+    std::vector<Feedback> scores(kCodeCount);
+    Symmetry symmetry(Pegs, Colours);
+    const std::span<const Code> codes = all_codes_.codes();
+    auto split = [&](Code guess) {
+      score_batch(guess, codes.data(), codes.size(), scores.data(), Pegs);
+      for (std::size_t i = 0; i < kCodeCount; ++i) {
+        ++cells[class_of[i] * kRanks + feedback_rank(scores[i], Pegs)];
+      }
+    };
+    for (std::size_t classes = 1; classes < kCodeCount;) {
+      Code best;
+      double best_cost = std::numeric_limits<double>::infinity();
+      std::size_t best_parts = classes;
+      for (const Code guess : codes) {
+        if (!symmetry.is_canonical(guess)) continue;
+        cells.assign(classes * kRanks, 0);
+        split(guess);
+        const auto parts = static_cast<std::size_t>(
+            std::count_if(cells.begin(), cells.end(),
+                          [](std::uint32_t n) { return n != 0; }));
+        if (parts == classes) continue;
+        const double cost =
+            partition_cost(options_.strategy, cells, kCodeCount);
+        if (cost < best_cost || (cost == best_cost && parts > best_parts)) {
+          best = guess;
+          best_cost = cost;
+          best_parts = parts;
+        }
+      }
+      // Renumber the non-empty cells as the next probe's classes.
+      cells.assign(classes * kRanks, 0);
+      split(best);
+      std::uint32_t next = 0;
+      for (std::uint32_t& cell : cells) cell = cell != 0 ? next++ : kNone;
+      for (std::size_t i = 0; i < kCodeCount; ++i) {
+        class_of[i] =
+            cells[class_of[i] * kRanks + feedback_rank(scores[i], Pegs)];
+      }
+      classes = next;
+      symmetry.record(best);
+      probes_.push_back(best);
+    }
+  }
+
+  // Reducing takes a pass over the whole code space, which alone can take
+  // longer than a time budget.
+  bool reduce_symmetry() const {
+    return options_.symmetry && options_.time_budget.count() == 0 &&
+           !symmetry_.trivial();
+  }
+
+  // removed_ = previous_ minus candidates_; both are in id order.
+  void collect_removed() {
+    removed_.clear();
+    const std::span<const std::uint32_t> kept = candidates_.ids();
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < previous_.size(); ++i) {
+      const std::uint32_t id = previous_.ids()[i];
+      if (k < kept.size() && kept[k] == id) {
+        ++k;
+      } else {
+        removed_.push_back(previous_[i], id);
+      }
+    }
+  }
+
+  // Keeps the entries of different boards, strategies and search spaces
+  // apart; max_guesses bounds the space an exact search chooses from, and
+  // symmetry reduction leaves it only canonical guesses, so that ties may
+  // go to another member of the winning orbit.
+  std::uint64_t table_seed() const {
+    return std::uint64_t{Pegs} | std::uint64_t{Colours} << 8 |
+           std::uint64_t{static_cast<std::uint8_t>(options_.strategy)} << 16 |
+           std::uint64_t{static_cast<std::uint8_t>(variant_of<GameRules>())}
+               << 24 |
+           std::uint64_t{options_.symmetry} << 31 |
+           std::uint64_t{static_cast<std::uint32_t>(options_.max_guesses)}
+               << 32;
+  }
+
+  // Candidates first, then the rest of the code space, keeping only orbit
+  // representatives when `reduce` is set. Gives up, returning false, once
+  // the space grows past max_guesses.
+  bool order_code_space(bool reduce) {
+    std::fill(member_.begin(), member_.end(), 0);
+    ordered_.clear();
+    for (std::size_t i = 0; i < candidates_.size(); ++i) {
+      member_[candidates_.ids()[i]] = 1;
+      if (!reduce || symmetry_.is_canonical(candidates_[i])) {
+        ordered_.push_back(candidates_[i], candidates_.ids()[i]);
+      }
+    }
+    const std::size_t consistent = ordered_.size();
+    for (std::size_t i = 0; i < all_codes_.size(); ++i) {
+      if (member_[i] || (reduce && !symmetry_.is_canonical(all_codes_[i]))) {
+        continue;
+      }
+      if (ordered_.size() == options_.max_guesses) return false;
+      ordered_.push_back(all_codes_[i], all_codes_.ids()[i]);
+    }
+    if (ordered_.size() > options_.max_guesses) return false;
+    is_candidate_.assign(ordered_.size(), 0);
+    std::fill_n(is_candidate_.begin(), consistent, 1);
+    return true;
+  }
+
+  SearchSpace search_space() {
+    // With a non-trivial symmetry group even a large board's code space
+    // often fits in max_guesses once reduced, notably on the first moves.
+    const bool reduce = reduce_symmetry();
+    if ((reduce || kCodeCount <= options_.max_guesses) &&
+        order_code_space(reduce)) {
+      return {ordered_.codes(), ordered_.ids(), is_candidate_};
+    }
+    // Even stride over the (representative) candidates down to max_guesses.
+    auto eligible = [&](std::size_t i) {
+      return !reduce || symmetry_.is_canonical(candidates_[i]);
+    };
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < candidates_.size(); ++i) count += eligible(i);
+    const std::size_t n = std::min(count, options_.max_guesses);
+    const std::size_t stride = count / n;
+    sampled_.clear();
+    for (std::size_t i = 0, k = 0; sampled_.size() < n; ++i) {
+      if (!eligible(i)) continue;
+      if (k++ % stride == 0) {
+        sampled_.push_back(candidates_[i], candidates_.ids()[i]);
+      }
+    }
+    is_candidate_.assign(n, 1);
+    return {sampled_.codes(), sampled_.ids(), is_candidate_};
+  }
+
+  SolverOptions options_;
+  GameArena arena_;
+  const FeedbackMatrix* matrix_;
+  GuessSearch<Pegs, Colours> search_;
+  PartitionCache<Pegs, Colours> partitions_;
+  CandidateSet candidates_;
+  Symmetry symmetry_;
+  bool tracking_;
+  SearchStats last_search_;
+  // The whole code space as a guess space, for boards small enough to
+  // search it or, reduced by symmetry, often enough to be worth trying;
+  // otherwise empty and guesses are sampled from the candidates.
+  CandidateSet all_codes_;
+  CandidateSet ordered_;
+  CandidateSet sampled_;
+  CandidateSet previous_;
+  CandidateSet removed_;
+  FeedbackBitmaps opening_;  // built by the first opening recorded
+  std::vector<Code> probes_;  // static rules: the probe book
+  std::vector<std::uint8_t> member_;
+  std::vector<std::uint8_t> is_candidate_;
+  std::pmr::vector<Move> history_{&arena_};
+};
+
+#define MASTERMYR_DECLARE_SOLVER(P, C) extern template class Solver<P, C>;
+MASTERMYR_FOR_EACH_BOARD(MASTERMYR_DECLARE_SOLVER)
+#undef MASTERMYR_DECLARE_SOLVER
+#define MASTERMYR_DECLARE_VARIANT_SOLVER(P, C, R) \
+  extern template class Solver<P, C, R>;
+MASTERMYR_FOR_EACH_VARIANT_BOARD(MASTERMYR_DECLARE_VARIANT_SOLVER)
+#undef MASTERMYR_DECLARE_VARIANT_SOLVER
+
+// Board-agnostic front end over the Solver specialisations, so one binary can
+// serve every compiled board size picked at runtime.
+class GameSolver {
+ public:
+  virtual ~GameSolver() = default;
+
+  virtual unsigned pegs() const = 0;
+  virtual unsigned colours() const = 0;
+  virtual void reset() = 0;
+  virtual Code next_guess() = 0;
+  virtual void record(Code guess, Feedback feedback) = 0;
+  virtual bool solved() const = 0;
+  virtual std::size_t remaining() const = 0;
+  virtual ArenaStats arena_stats() const = 0;
+  // What the search for the last next_guess() did.
+  virtual SearchStats last_search() const = 0;
+};
+
+// Whether the board has a Solver specialisation.
+bool is_supported_board(unsigned pegs, unsigned colours);
+// Same for a variant's rules; every valid board supports kMastermind.
+bool is_supported_board(unsigned pegs, unsigned colours, Variant variant);
+// Whether codes of the board fit the packed Code encoding.
+constexpr bool is_valid_board(unsigned pegs, unsigned colours) {
+  return pegs >= 1 && pegs <= kMaxPegs && colours >= 2 &&
+         colours <= kMaxColours;
+}
+
+// The specialised solver for the board, or the sampled solver (see
+// make_sampled_solver) for any other valid board. Throws
+// std::invalid_argument for a board that is not valid.
+std::unique_ptr<GameSolver> make_solver(unsigned pegs, unsigned colours,
+                                        SolverOptions options = {});
+
+// The variant's specialised solver (see MASTERMYR_FOR_EACH_VARIANT_BOARD);
+// kMastermind is the overload above. Variants have no sampled fallback, so
+// any other board throws std::invalid_argument. A feedback matrix in the
+// options must be for the variant's board key.
+std::unique_ptr<GameSolver> make_solver(unsigned pegs, unsigned colours,
+                                        Variant variant,
+                                        SolverOptions options = {});
+
+// Solver for boards too large to enumerate. Candidates come from a
+// CandidateGenerator seeded by the history, so a history always gets the
+// same guess; memory stays O(reservoir) whatever the board. remaining() is
+// exact while at most options.sample_budget codes are consistent. Above
+// that it is an estimate from the descents, clamped to at least
+// sample_budget + 1 and at most the previous move's remaining().
+std::unique_ptr<GameSolver> make_sampled_solver(unsigned pegs,
+                                                unsigned colours,
+                                                SolverOptions options = {});
+
+}  // namespace mastermyr
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/guess_search.hpp"
+#include "mastermyr/mapped_file.hpp"
+#include "mastermyr/numa.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr {
+
+// A whole strategy for one board, precomputed: the decision tree a solver
+// walks when it plays every secret. Serving a move is then one array lookup
+// per feedback instead of a search.
+//
+// Nodes are stored in an array in depth-first order, root first. A node
+// holds its guess and the offset of its child slots: feedback_ranks(pegs)
+// consecutive node indices in a second array, indexed by feedback_rank(),
+// with kNone for feedback the node's candidates cannot produce and for the
+// solved feedback. A node whose candidates all end the game has no slots.
+//
+// An opening book (see opening_book.hpp) is a partial tree: it holds only
+// the positions real games reach most, and a kNone slot of one may also be
+// a position to search.
+//
+// File layout (little endian): a 64-byte header carrying the magic, format
+// version, board key, strategy, node and slot counts, depth, flags and a
+// checksum of the payload, followed by the node array and the slot array.
+// Loading maps the file and validates it, then serves straight from the
+// mapping.
+class StrategyTree {
+ public:
+  using NodeIndex = std::uint32_t;
+
+  static constexpr std::uint32_t kFormatVersion = 1;
+  static constexpr NodeIndex kRoot = 0;
+  static constexpr NodeIndex kNone = ~NodeIndex{0};
+  // More guesses than any board's strategy needs.
+  static constexpr unsigned kMaxDepth = 64;
+
+  struct Node {
+    std::uint32_t guess;       // Code::bits()
+    std::uint32_t children;    // first child slot, or kNone
+    std::uint32_t candidates;  // codes still consistent at this node
+  };
+  static_assert(sizeof(Node) == 12);
+
+  // Records the moves a solver with `options` makes against every secret of
+  // the board. With a pool in the options the subtrees below the first two
+  // moves are compiled in parallel; the tree is the same either way. Throws
+  // std::invalid_argument for a board without a Solver specialisation.
+  static StrategyTree compile(unsigned pegs, unsigned colours,
+                              const SolverOptions& options);
+
+  // A compile cut into pieces that can be built apart, on other machines
+  // (see distributed.hpp): the levels above the split, whose child slots
+  // hold kJob | j for the j-th position at the split, and the moves leading
+  // to each of those positions.
+  struct Split {
+    static constexpr NodeIndex kJob = NodeIndex{1} << 31;
+
+    BoardKey key;
+    Strategy strategy = Strategy::kMinimax;
+    unsigned depth = 0;  // of the top levels alone
+    std::vector<Node> nodes;
+    std::vector<NodeIndex> children;
+    std::vector<std::vector<Move>> jobs;
+  };
+
+  // A tree in the file's layout, indices relative to its own arrays.
+  struct Subtree {
+    std::vector<Node> nodes;
+    std::vector<NodeIndex> children;
+    unsigned depth = 0;
+  };
+
+  // The top of compile()'s tree and its jobs; with a pool the top levels
+  // search in parallel.
+  static Split split(unsigned pegs, unsigned colours,
+                     const SolverOptions& options);
+  // The subtree below the position the moves lead to, as compile() would
+  // build it.
+  static Subtree compile_subtree(unsigned pegs, unsigned colours,
+                                 const SolverOptions& options,
+                                 std::span<const Move> moves);
+  // Splices one subtree per job, in job order, under the split's top; the
+  // result is the tree compile() returns. Throws std::invalid_argument when
+  // the subtree count does not match.
+  static StrategyTree assemble(const Split& split,
+                               std::span<const Subtree> subtrees);
+
+  // A partial tree of the subtree's nodes, such as an opening book. Throws
+  // std::invalid_argument for an empty one.
+  static StrategyTree partial(const BoardKey& key, Strategy strategy,
+                              Subtree subtree);
+
+  // Maps a tree file, validating its header against `key`, its checksum
+  // and its structure (see well_formed), so that a corrupt or hand-built
+  // file cannot make child() or lookup() read out of bounds. Throws
+  // CacheError or std::system_error.
+  static StrategyTree load(const std::filesystem::path& file,
+                           const BoardKey& key);
+
+  // Whether every node's child slots lie inside `children` and every slot
+  // is kNone or a node inside `nodes`.
+  static bool well_formed(std::span<const Node> nodes,
+                          std::span<const NodeIndex> children, unsigned pegs);
+
+  // Writes the tree to `file` atomically (temporary file and rename).
+  void save(const std::filesystem::path& file) const;
+
+  // A copy held in memory on `node`, for numa::Replicated.
+  StrategyTree copy_to_node(unsigned node) const;
+
+  const BoardKey& key() const { return key_; }
+  Strategy strategy() const { return strategy_; }
+  std::size_t size() const { return nodes_.size(); }
+  // Most guesses the strategy needs for any secret.
+  unsigned depth() const { return depth_; }
+  bool is_mapped() const { return mapping_.is_open(); }
+  // False for a partial tree, which does not solve every secret.
+  bool complete() const { return complete_; }
+
+  Code guess(NodeIndex node) const { return Code(nodes_[node].guess); }
+  std::size_t candidates(NodeIndex node) const {
+    return nodes_[node].candidates;
+  }
+  // The node reached when `node`'s guess scores `feedback`, or kNone if the
+  // game is solved or the feedback is impossible.
+  NodeIndex child(NodeIndex node, Feedback feedback) const {
+    const std::uint32_t first = nodes_[node].children;
+    if (first == kNone) return kNone;
+    return children_[first + feedback_rank(feedback, key_.pegs)];
+  }
+
+  // The guess at the position the moves of `game` lead to, or nullopt when
+  // a move is not the tree's guess or its feedback leaves the tree. `Game`
+  // has size() and an operator[] returning Moves, like std::span<const Move>
+  // and wire::GameStateView.
+  template <typename Game>
+  std::optional<Code> lookup(const Game& game) const {
+    NodeIndex node = kRoot;
+    for (std::size_t i = 0; i < game.size(); ++i) {
+      const Move move = game[i];
+      if (move.guess != guess(node)) return std::nullopt;
+      node = child(node, move.feedback);
+      if (node == kNone) return std::nullopt;
+    }
+    return guess(node);
+  }
+
+ private:
+  template <unsigned Pegs, unsigned Colours>
+  friend class TreeCompiler;
+
+  StrategyTree() = default;
+
+  BoardKey key_;
+  Strategy strategy_ = Strategy::kMinimax;
+  unsigned depth_ = 0;
+  bool complete_ = true;
+  std::span<const Node> nodes_;
+  std::span<const NodeIndex> children_;
+  std::vector<Node> owned_nodes_;
+  std::vector<NodeIndex> owned_children_;
+  MappedFile mapping_;
+  numa::NodeBuffer replica_;
+};
+
+// Outcome of playing a tree against every secret of its board.
+struct TreeEvaluation {
+  // games[n] is the number of secrets solved with exactly n guesses.
+  std::vector<std::uint64_t> games;
+  // Secrets the tree does not solve (a missing branch); 0 for a sound tree.
+  std::uint64_t failures = 0;
+
+  std::uint64_t secrets() const;
+  double average() const;
+  unsigned worst() const;
+};
+
+// Plays every secret through the tree, in parallel over `pool` when given.
+TreeEvaluation evaluate(const StrategyTree& tree, ThreadPool* pool = nullptr);
+
+// A GameSolver that plays a compiled tree. next_guess() never searches;
+// record() throws std::invalid_argument for a guess other than the tree's.
+// Throws std::invalid_argument for a partial tree, whose positions off the
+// tree need a search.
+std::unique_ptr<GameSolver> make_tree_solver(
+    std::shared_ptr<const StrategyTree> tree);
+
+// File name of a board's compiled strategy, e.g.
+// strategy-v1-4x6-dup-minimax.bin.
+std::string strategy_tree_name(const BoardKey& key, Strategy strategy);
+
+}  // namespace mastermyr
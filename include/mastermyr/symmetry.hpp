@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+// Symmetries of a game position: relabellings of the colours no guess has
+// used yet, and permutations of positions that every guess so far coloured
+// alike. Both fix every past guess, hence every past feedback, so they map
+// the candidate set onto itself and two guesses in the same orbit split it
+// identically. A search only has to rate one representative per orbit.
+//
+// This is a subgroup of the full stabiliser of the history (it ignores
+// combined colour-and-position symmetries such as swapping the halves of
+// 0011 while swapping colours 0 and 1), which keeps canonicalisation cheap;
+// the reductions it misses are small next to the ones it finds.
+class Symmetry {
+ public:
+  Symmetry(unsigned pegs, unsigned colours);
+
+  // Back to the symmetries of an empty history.
+  void reset();
+
+  // Narrows the symmetries to those that also fix `guess`.
+  void record(Code guess);
+
+  // True once the group is trivial, i.e. every code is its own orbit.
+  bool trivial() const { return trivial_; }
+
+  // The representative of `code`'s orbit. Independent of which member of
+  // the orbit is passed in.
+  Code canonical(Code code) const;
+  bool is_canonical(Code code) const { return canonical(code) == code; }
+
+ private:
+  void update_trivial();
+
+  unsigned pegs_;
+  unsigned colours_;
+  std::uint32_t free_colours_ = 0;  // bit c: no guess has used colour c
+  unsigned classes_ = 0;
+  // Position class of each peg, numbered in order of first position.
+  std::array<std::uint8_t, kMaxPegs> class_of_{};
+  bool trivial_ = false;
+};
+
+}  // namespace mastermyr
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace mastermyr {
+
+// Work-stealing thread pool.
+//
+// submit() pushes onto the submitting worker's own deque (or a round-robin
+// one from outside the pool); idle workers pop their own deque LIFO and steal
+// from the others FIFO.
+//
+// parallel_for() splits an index range into chunks and hands every
+// participant -- the workers plus the calling thread -- a contiguous run of
+// chunks. A run is one atomic word holding [lo, hi): the owner takes chunks
+// from the front and idle participants steal half of the remainder from the
+// back, both with a single CAS, so uneven chunk costs even out without locks.
+// The caller always works too, which makes nested parallel_for calls from
+// inside pool tasks safe.
+//
+// A pinned pool fixes every worker to one CPU, spread evenly over the CPUs
+// of every NUMA node (see numa.hpp), and its idle workers steal from the
+// workers of their own node before crossing to another one, so tasks
+// submitted to a node stay there while it has work.
+class ThreadPool {
+ public:
+  enum class Placement {
+    kFloating,  // workers run wherever the scheduler puts them
+    kPinned,
+  };
+
+  // `threads` worker threads; 0 gives a pool whose parallel_for runs entirely
+  // on the calling thread.
+  explicit ThreadPool(unsigned threads = default_threads(),
+                      Placement placement = Placement::kFloating);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // One less than the hardware concurrency, since callers of parallel_for
+  // take part in the work.
+  static unsigned default_threads();
+
+  unsigned workers() const { return static_cast<unsigned>(threads_.size()); }
+  // Number of distinct participant indices parallel_for can pass to a body.
+  unsigned concurrency() const { return workers() + 1; }
+
+  // NUMA nodes the workers are placed by: 1 unless pinned on a NUMA machine.
+  unsigned nodes() const {
+    return static_cast<unsigned>(node_workers_.size());
+  }
+  unsigned worker_node(unsigned worker) const { return worker_node_[worker]; }
+
+  void submit(std::function<void()> task);
+  // Queues the task on a worker of `node` (modulo nodes()); from a worker on
+  // that node, on its own queue.
+  void submit(std::function<void()> task, unsigned node);
+
+  // Calls body(begin, end, participant) for consecutive chunks of at most
+  // `grain` indices covering [0, n), and returns when all of them are done.
+  // `participant` is in [0, concurrency()) and no two concurrent calls share
+  // one, so bodies can accumulate into per-participant slots without
+  // synchronisation.
+  template <typename Body>
+  void parallel_for(std::size_t n, std::size_t grain, Body&& body);
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // Where a node's idle workers sleep, so that a task submitted to a node
+  // wakes one of its own workers while it has any asleep.
+  struct Sleepers {
+    std::condition_variable wake;
+    unsigned count = 0;  // guarded by sleep_mutex_
+  };
+
+  // A participant's remaining chunks, packed as lo | hi << 32.
+  struct alignas(64) Range {
+    std::atomic<std::uint64_t> bounds{0};
+  };
+
+  struct ForState {
+    explicit ForState(unsigned participants) : ranges(participants) {}
+
+    std::vector<Range> ranges;
+    std::size_t n = 0;
+    std::size_t grain = 1;
+    void (*invoke)(void*, std::size_t, std::size_t, unsigned) = nullptr;
+    void* body = nullptr;
+    std::atomic<unsigned> next_participant{1};
+    std::atomic<std::size_t> remaining{0};
+  };
+
+  static constexpr std::uint64_t pack(std::uint32_t lo, std::uint32_t hi) {
+    return std::uint64_t{lo} | std::uint64_t{hi} << 32;
+  }
+
+  void push(unsigned queue, std::function<void()> task);
+  bool try_pop(unsigned self, std::function<void()>& task);
+  bool try_steal(unsigned victim, std::function<void()>& task);
+  void worker_loop(unsigned index);
+  void run_for(ForState& state);
+  static void run_participant(ForState& state, unsigned participant);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::vector<unsigned> worker_node_;
+  std::vector<std::vector<unsigned>> node_workers_;
+  std::vector<int> worker_cpu_;  // -1 when floating
+  std::atomic<std::size_t> pending_{0};
+  std::atomic<unsigned> next_queue_{0};
+  std::mutex sleep_mutex_;
+  std::vector<std::unique_ptr<Sleepers>> sleepers_;  // per node
+  bool stopping_ = false;
+};
+
+template <typename Body>
+void ThreadPool::parallel_for(std::size_t n, std::size_t grain, Body&& body) {
+  if (n == 0) return;
+  grain = std::max<std::size_t>(grain, 1);
+  auto state = std::make_shared<ForState>(concurrency());
+  state->n = n;
+  state->grain = grain;
+  state->body = static_cast<void*>(&body);
+  state->invoke = [](void* b, std::size_t begin, std::size_t end,
+                     unsigned participant) {
+    (*static_cast<std::remove_reference_t<Body>*>(b))(begin, end, participant);
+  };
+  run_for(*state);
+  // Helpers that have not started yet only find empty ranges; they keep the
+  // state alive through their own reference and never touch `body`.
+  for (unsigned i = 1; i < concurrency(); ++i) {
+    submit([state] {
+      const unsigned participant = state->next_participant.fetch_add(1);
+      if (participant < state->ranges.size()) {
+        run_participant(*state, participant);
+      }
+    });
+  }
+  run_participant(*state, 0);
+  for (std::size_t left = state->remaining.load(std::memory_order_acquire);
+       left != 0; left = state->remaining.load(std::memory_order_acquire)) {
+    state->remaining.wait(left, std::memory_order_acquire);
+  }
+}
+
+}  // namespace mastermyr
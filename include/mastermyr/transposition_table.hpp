@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/code.hpp"
+
+namespace mastermyr {
+
+// 128-bit hash of a candidate set. Candidates are kept in code-index order,
+// so a set has a single representation whatever history produced it.
+struct PositionKey {
+  std::uint64_t lo = 0;
+  std::uint64_t hi = 0;
+
+  friend bool operator==(const PositionKey&, const PositionKey&) = default;
+};
+
+// `seed` separates tables shared by solvers of different boards or
+// strategies.
+PositionKey position_key(const CandidateSet& candidates, std::uint64_t seed);
+
+// Fixed-size concurrent cache from a candidate set to the guess a search
+// chose for it. Different histories often leave the same candidates, and
+// the best guess depends on nothing else.
+//
+// Lock-free: a bucket is one cache line holding two entries and a word of
+// replacement state. An entry is three words, the payload and the payload
+// XORed with each key half, written and read with relaxed atomics. A reader
+// that races a writer sees a torn entry whose check fails, and treats it as
+// a miss. Replacement is a per-bucket clock: hits mark an entry, and an
+// insert evicts the first unmarked entry from the bucket's hand, clearing
+// marks as it passes.
+class TranspositionTable {
+ public:
+  struct Entry {
+    Code guess;
+    float cost = 0;
+  };
+
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t stores = 0;
+  };
+
+  // Rounds `bytes` down to a power-of-two number of 64-byte buckets, at
+  // least one.
+  explicit TranspositionTable(std::size_t bytes);
+
+  std::optional<Entry> lookup(const PositionKey& key);
+  void store(const PositionKey& key, const Entry& entry);
+  void clear();
+
+  std::size_t capacity() const { return (mask_ + 1) * kWays; }
+  Stats stats() const;
+
+ private:
+  static constexpr unsigned kWays = 2;
+
+  struct Slot {
+    std::atomic<std::uint64_t> check_lo{0};
+    std::atomic<std::uint64_t> check_hi{0};
+    std::atomic<std::uint64_t> data{0};
+  };
+
+  // Bits 0-1 mark recently hit ways, bit 2 is the clock hand.
+  struct alignas(64) Bucket {
+    Slot slots[kWays];
+    std::atomic<std::uint64_t> clock{0};
+  };
+  static_assert(sizeof(Bucket) == 64);
+
+  struct alignas(64) Counter {
+    std::atomic<std::uint64_t> value{0};
+  };
+
+  Bucket& bucket(const PositionKey& key) { return buckets_[key.hi & mask_]; }
+
+  std::unique_ptr<Bucket[]> buckets_;
+  std::size_t mask_ = 0;
+  Counter hits_;
+  Counter misses_;
+  Counter stores_;
+};
+
+}  // namespace mastermyr
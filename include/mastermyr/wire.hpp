@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr::wire {
+
+// Binary format of game states and answers, shared by `mastermyr serve`, the
+// batch API and recorded game files. Everything is little-endian and packed;
+// a frame is a u32 body length followed by the body, and a stream or file is
+// frames back to back.
+//
+//   game state: u64 game id, u8 pegs, u8 colours, u8 move count,
+//               then per move u32 guess (Code::bits()) and u8 feedback (raw)
+//   answer:     u64 game id, u8 status, u32 guess (valid when status is kOk)
+//
+// An empty frame is a stats request: the reply, in the same order as the
+// answers, is a frame whose body is a text dump of "name value" lines.
+//
+// Views read fields straight out of the receive buffer or file they point
+// into, so decoding a state allocates nothing.
+inline constexpr std::size_t kLengthPrefix = 4;
+inline constexpr std::size_t kStateHeader = 11;
+inline constexpr std::size_t kMoveSize = 5;
+inline constexpr std::size_t kMaxMoves = 255;
+inline constexpr std::size_t kMaxStateBody =
+    kStateHeader + kMaxMoves * kMoveSize;
+inline constexpr std::size_t kAnswerBody = 13;
+inline constexpr std::size_t kAnswerFrame = kLengthPrefix + kAnswerBody;
+
+enum class Status : std::uint8_t {
+  kOk = 0,
+  kInconsistent = 1,  // no code fits the history
+  kUnsupported = 2,   // not the board being solved
+  kInvalid = 3,       // malformed codes or feedback, or a move off the tree
+  kFailed = 4,        // the solver failed; the request may be retried
+};
+
+// Thrown by GameStateReader for a malformed or truncated stream.
+class WireError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+
+template <typename T>
+T load(const std::byte* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+}  // namespace detail
+
+// A game state decoded in place; the bytes must outlive the view.
+class GameStateView {
+ public:
+  // nullopt unless `body` is exactly a header and its moves.
+  static std::optional<GameStateView> parse(std::span<const std::byte> body) {
+    if (body.size() < kStateHeader ||
+        body.size() != kStateHeader + kMoveSize * std::size_t{
+                           detail::load<std::uint8_t>(body.data() + 10)}) {
+      return std::nullopt;
+    }
+    return GameStateView(body.data());
+  }
+
+  std::uint64_t game() const { return detail::load<std::uint64_t>(data_); }
+  unsigned pegs() const { return detail::load<std::uint8_t>(data_ + 8); }
+  unsigned colours() const { return detail::load<std::uint8_t>(data_ + 9); }
+  std::size_t size() const { return detail::load<std::uint8_t>(data_ + 10); }
+  Move operator[](std::size_t i) const {
+    const std::byte* move = data_ + kStateHeader + i * kMoveSize;
+    return {Code(detail::load<std::uint32_t>(move)),
+            Feedback(detail::load<std::uint8_t>(move + 4))};
+  }
+
+  // Whether every guess is a code of the state's board and every feedback
+  // has at most pegs() pins.
+  bool valid_moves() const;
+
+ private:
+  explicit GameStateView(const std::byte* data) : data_(data) {}
+
+  const std::byte* data_;
+};
+
+class AnswerView {
+ public:
+  static std::optional<AnswerView> parse(std::span<const std::byte> body) {
+    if (body.size() != kAnswerBody) return std::nullopt;
+    return AnswerView(body.data());
+  }
+
+  std::uint64_t game() const { return detail::load<std::uint64_t>(data_); }
+  Status status() const {
+    return static_cast<Status>(detail::load<std::uint8_t>(data_ + 8));
+  }
+  Code guess() const { return Code(detail::load<std::uint32_t>(data_ + 9)); }
+
+ private:
+  explicit AnswerView(const std::byte* data) : data_(data) {}
+
+  const std::byte* data_;
+};
+
+// Appends a game-state frame; throws std::invalid_argument for more than
+// kMaxMoves moves.
+void append_game_state(std::vector<std::byte>& out, std::uint64_t game,
+                       unsigned pegs, unsigned colours,
+                       std::span<const Move> moves);
+
+// Writes an answer frame to out[0, kAnswerFrame).
+void write_answer(std::byte* out, std::uint64_t game, Status status,
+                  Code guess);
+void append_answer(std::vector<std::byte>& out, std::uint64_t game,
+                   Status status, Code guess);
+
+// Splits a buffer into frames in place.
+class FrameReader {
+ public:
+  enum class Result {
+    kFrame,     // `body` holds the next frame's body
+    kPartial,   // the rest of the buffer is an incomplete frame
+    kOversized  // the next frame claims more than max_body bytes
+  };
+
+  FrameReader(std::span<const std::byte> bytes, std::size_t max_body)
+      : bytes_(bytes), max_body_(max_body) {}
+
+  Result next(std::span<const std::byte>& body) {
+    const std::size_t left = bytes_.size() - consumed_;
+    if (left < kLengthPrefix) return Result::kPartial;
+    const std::size_t length =
+        detail::load<std::uint32_t>(bytes_.data() + consumed_);
+    if (length > max_body_) return Result::kOversized;
+    if (left - kLengthPrefix < length) return Result::kPartial;
+    body = bytes_.subspan(consumed_ + kLengthPrefix, length);
+    consumed_ += kLengthPrefix + length;
+    return Result::kFrame;
+  }
+
+  // Bytes taken by the frames returned so far.
+  std::size_t consumed() const { return consumed_; }
+
+ private:
+  std::span<const std::byte> bytes_;
+  std::size_t max_body_;
+  std::size_t consumed_ = 0;
+};
+
+// Reads game-state frames from a stream of any length through one fixed
+// buffer, so files of millions of recorded games are processed in constant
+// memory.
+class GameStateReader {
+ public:
+  static constexpr std::size_t kDefaultBuffer = std::size_t{1} << 20;
+
+  explicit GameStateReader(std::istream& in,
+                           std::size_t buffer = kDefaultBuffer);
+
+  // Up to `max_states` states in stream order, empty at the end of the
+  // stream. The views point into the reader's buffer and stay valid until
+  // the next call. Throws WireError for a frame that is not a game state and
+  // for a stream that ends inside a frame.
+  std::span<const GameStateView> next_batch(std::size_t max_states);
+
+  // States returned so far.
+  std::uint64_t count() const { return count_; }
+
+ private:
+  std::istream& in_;
+  std::vector<std::byte> buffer_;
+  std::size_t begin_ = 0;
+  std::size_t end_ = 0;
+  std::vector<GameStateView> batch_;
+  std::uint64_t count_ = 0;
+};
+
+}  // namespace mastermyr::wire
@@ -0,0 +1,64 @@
+#include "mastermyr/arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace mastermyr {
+namespace {
+
+// Chunks are aligned for the widest vector loads.
+constexpr std::size_t kChunkAlignment = 64;
+
+}  // namespace
+
+GameArena::GameArena(std::size_t first_chunk,
+                     std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {
+  const std::size_t size = std::max(first_chunk, kChunkAlignment);
+  chunks_.push_back({static_cast<std::byte*>(
+                         upstream_->allocate(size, kChunkAlignment)),
+                     size, kChunkAlignment});
+  reserved_ = size;
+}
+
+GameArena::~GameArena() {
+  for (const Chunk& chunk : chunks_) {
+    upstream_->deallocate(chunk.data, chunk.size, chunk.alignment);
+  }
+}
+
+void GameArena::release() {
+  current_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+void* GameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  while (true) {
+    const Chunk& chunk = chunks_[current_];
+    const auto base = reinterpret_cast<std::uintptr_t>(chunk.data);
+    const std::size_t start =
+        (base + offset_ + alignment - 1) / alignment * alignment - base;
+    if (start + bytes <= chunk.size) {
+      used_ += start + bytes - offset_;
+      peak_ = std::max(peak_, used_);
+      offset_ = start + bytes;
+      return chunk.data + start;
+    }
+    // Move on to the next chunk, growing the list geometrically when the
+    // retained ones run out.
+    used_ += chunk.size - offset_;
+    offset_ = 0;
+    if (++current_ == chunks_.size()) {
+      const std::size_t size =
+          std::max(chunks_.back().size * 2, bytes + alignment);
+      const std::size_t align = std::max(alignment, kChunkAlignment);
+      chunks_.push_back(
+          {static_cast<std::byte*>(upstream_->allocate(size, align)), size,
+           align});
+      reserved_ += size;
+    }
+  }
+}
+
+}  // namespace mastermyr
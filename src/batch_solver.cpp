@@ -0,0 +1,133 @@
+#include "mastermyr/batch_solver.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "mastermyr/hash.hpp"
+
+namespace mastermyr {
+namespace {
+
+struct KeyHash {
+  std::size_t operator()(const std::vector<std::uint64_t>& key) const {
+    return static_cast<std::size_t>(
+        hash_bytes(key.data(), key.size() * sizeof(key[0])));
+  }
+};
+
+// A position's moves in canonical order; `Game` is a History or a
+// wire::GameStateView.
+template <typename Game>
+std::vector<std::uint64_t> canonical_key(const Game& game) {
+  std::vector<std::uint64_t> key(game.size());
+  for (std::size_t i = 0; i < game.size(); ++i) {
+    const Move move = game[i];
+    key[i] = move.guess.bits() | std::uint64_t{move.feedback.raw()} << 32;
+  }
+  // Repeating a move, like reordering moves, leaves the position unchanged.
+  std::sort(key.begin(), key.end());
+  key.erase(std::unique(key.begin(), key.end()), key.end());
+  return key;
+}
+
+}  // namespace
+
+BatchSolver::BatchSolver(unsigned pegs, unsigned colours,
+                         SolverOptions options)
+    : pegs_(pegs), colours_(colours), options_(std::move(options)) {
+  if (!is_supported_board(pegs, colours)) {
+    throw std::invalid_argument("no solver for a " + std::to_string(pegs) +
+                                "x" + std::to_string(colours) + " board");
+  }
+  solvers_.resize(options_.pool ? options_.pool->concurrency() : 1);
+}
+
+std::optional<Code> BatchSolver::solve(GameSolver& solver, const Key& key) {
+  solver.reset();
+  for (const std::uint64_t move : key) {
+    solver.record(Code(static_cast<std::uint32_t>(move)),
+                  Feedback(static_cast<std::uint8_t>(move >> 32)));
+  }
+  try {
+    return solver.next_guess();
+  } catch (const InconsistentFeedback&) {
+    return std::nullopt;
+  }
+}
+
+template <typename Game>
+std::vector<std::optional<Code>> BatchSolver::solve_all(
+    std::span<const Game> games) {
+  std::unordered_map<Key, std::size_t, KeyHash> index;
+  std::vector<const Key*> unique;
+  std::vector<std::size_t> state_of(games.size());
+  for (std::size_t g = 0; g < games.size(); ++g) {
+    const auto [it, inserted] =
+        index.try_emplace(canonical_key(games[g]), unique.size());
+    if (inserted) unique.push_back(&it->first);
+    state_of[g] = it->second;
+  }
+
+  std::vector<std::optional<Code>> answers(unique.size());
+  auto body = [&](std::size_t begin, std::size_t end, unsigned participant) {
+    std::unique_ptr<GameSolver>& solver = solvers_[participant];
+    if (!solver) solver = make_solver(pegs_, colours_, options_);
+    for (std::size_t s = begin; s < end; ++s) {
+      answers[s] = solve(*solver, *unique[s]);
+    }
+  };
+  if (options_.pool != nullptr) {
+    options_.pool->parallel_for(unique.size(), 1, body);
+  } else {
+    body(0, unique.size(), 0);
+  }
+
+  std::vector<std::optional<Code>> guesses(games.size());
+  for (std::size_t g = 0; g < games.size(); ++g) {
+    guesses[g] = answers[state_of[g]];
+  }
+  stats_ = {games.size(), unique.size()};
+  return guesses;
+}
+
+std::vector<std::optional<Code>> BatchSolver::next_guesses(
+    std::span<const History> games) {
+  return solve_all(games);
+}
+
+std::vector<std::optional<Code>> BatchSolver::next_guesses(
+    std::span<const wire::GameStateView> games) {
+  return solve_all(games);
+}
+
+void BatchSolver::answer(std::span<const wire::GameStateView> states,
+                         std::vector<std::byte>& out) {
+  std::vector<wire::GameStateView> playable;
+  playable.reserve(states.size());
+  for (const wire::GameStateView& state : states) {
+    if (state.pegs() == pegs_ && state.colours() == colours_ &&
+        state.valid_moves()) {
+      playable.push_back(state);
+    }
+  }
+  const std::vector<std::optional<Code>> guesses = next_guesses(playable);
+  out.reserve(out.size() + states.size() * wire::kAnswerFrame);
+  std::size_t next = 0;
+  for (const wire::GameStateView& state : states) {
+    wire::Status status = wire::Status::kInvalid;
+    Code guess;
+    if (state.pegs() != pegs_ || state.colours() != colours_) {
+      status = wire::Status::kUnsupported;
+    } else if (state.valid_moves()) {
+      const std::optional<Code>& answer = guesses[next++];
+      status = answer ? wire::Status::kOk : wire::Status::kInconsistent;
+      if (answer) guess = *answer;
+    }
+    wire::append_answer(out, state.game(), status, guess);
+  }
+  stats_.games = states.size();
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,160 @@
+#include "mastermyr/candidate_generator.hpp"
+
+#include <bit>
+#include <utility>
+
+namespace mastermyr {
+
+namespace {
+
+Propagator propagate(unsigned pegs, unsigned colours,
+                     std::span<const Move> history) {
+  Propagator propagator(pegs, colours);
+  propagator.add(history);
+  return propagator;
+}
+
+}  // namespace
+
+CandidateGenerator::CandidateGenerator(unsigned pegs, unsigned colours,
+                                       std::span<const Move> history,
+                                       std::uint64_t seed)
+    : CandidateGenerator(propagate(pegs, colours, history), seed) {}
+
+CandidateGenerator::CandidateGenerator(const Propagator& propagator,
+                                       std::uint64_t seed)
+    : pegs_(propagator.pegs()),
+      colours_(propagator.colours()),
+      randomise_(seed != 0),
+      rng_(seed) {
+  const std::span<const Move> history = propagator.history();
+  constraints_.reserve(history.size());
+  for (const Move& move : history) {
+    Constraint c{move.guess,
+                 static_cast<std::uint8_t>(move.feedback.black()),
+                 static_cast<std::uint8_t>(move.feedback.black() +
+                                           move.feedback.white()),
+                 {}};
+    for (unsigned i = 0; i < pegs_; ++i) ++c.counts[move.guess.peg(i)];
+    constraints_.push_back(c);
+  }
+  blacks_.assign(constraints_.size(), 0);
+  totals_.assign(constraints_.size(), 0);
+  for (unsigned i = 0; i < pegs_; ++i) domains_[i] = propagator.domain(i);
+  for (unsigned c = 0; c < colours_; ++c) {
+    lo_[c] = static_cast<std::uint8_t>(propagator.min_count(c));
+    hi_[c] = static_cast<std::uint8_t>(propagator.max_count(c));
+    deficit_ += lo_[c];
+  }
+  exhausted_ = !propagator.consistent();
+  shuffle_level(0);
+}
+
+std::optional<Code> CandidateGenerator::next() {
+  if (exhausted_) return std::nullopt;
+  // Resuming after a code: undo its last peg and carry on from there.
+  if (depth_ == pegs_) {
+    --depth_;
+    pop(depth_, code_.peg(depth_));
+  }
+  while (true) {
+    if (cursor_[depth_] < sizes_[depth_]) {
+      const unsigned colour = order_[depth_][cursor_[depth_]++];
+      if (!push(depth_, colour)) continue;
+      code_ = code_.with_peg(depth_, colour);
+      if (++depth_ == pegs_) {
+        ++produced_;
+        return code_;
+      }
+      shuffle_level(depth_);
+      continue;
+    }
+    if (depth_ == 0) {
+      exhausted_ = true;
+      return std::nullopt;
+    }
+    --depth_;
+    pop(depth_, code_.peg(depth_));
+  }
+}
+
+std::optional<Code> CandidateGenerator::draw(std::mt19937_64& rng,
+                                             double& weight) {
+  weight = 0;
+  if (exhausted_) return std::nullopt;
+  Code code;
+  double product = 1;
+  unsigned depth = 0;
+  std::array<std::uint8_t, kMaxColours> open;
+  for (; depth < pegs_; ++depth) {
+    unsigned size = 0;
+    for (Propagator::Domain d = domains_[depth]; d != 0; d &= d - 1) {
+      const auto colour = static_cast<std::uint8_t>(std::countr_zero(d));
+      if (!push(depth, colour)) continue;
+      pop(depth, colour);
+      open[size++] = colour;
+    }
+    if (size == 0) break;
+    const unsigned colour = open[rng() % size];
+    push(depth, colour);
+    code = code.with_peg(depth, colour);
+    product *= size;
+  }
+  const bool complete = depth == pegs_;
+  while (depth-- > 0) pop(depth, code.peg(depth));
+  if (!complete) return std::nullopt;
+  weight = product;
+  return code;
+}
+
+bool CandidateGenerator::push(unsigned depth, unsigned colour) {
+  const unsigned left = pegs_ - depth - 1;
+  const bool owed = assigned_counts_[colour] < lo_[colour];
+  if (assigned_counts_[colour] >= hi_[colour] || deficit_ - owed > left) {
+    return false;
+  }
+  for (std::size_t m = 0; m < constraints_.size(); ++m) {
+    const Constraint& c = constraints_[m];
+    const unsigned blacks = blacks_[m] + (c.guess.peg(depth) == colour);
+    const unsigned total =
+        totals_[m] + (assigned_counts_[colour] < c.counts[colour]);
+    if (blacks > c.blacks || blacks + left < c.blacks || total > c.total ||
+        total + left < c.total) {
+      return false;
+    }
+  }
+  for (std::size_t m = 0; m < constraints_.size(); ++m) {
+    const Constraint& c = constraints_[m];
+    blacks_[m] += c.guess.peg(depth) == colour;
+    totals_[m] += assigned_counts_[colour] < c.counts[colour];
+  }
+  deficit_ -= owed;
+  ++assigned_counts_[colour];
+  return true;
+}
+
+void CandidateGenerator::pop(unsigned depth, unsigned colour) {
+  --assigned_counts_[colour];
+  deficit_ += assigned_counts_[colour] < lo_[colour];
+  for (std::size_t m = 0; m < constraints_.size(); ++m) {
+    const Constraint& c = constraints_[m];
+    blacks_[m] -= c.guess.peg(depth) == colour;
+    totals_[m] -= assigned_counts_[colour] < c.counts[colour];
+  }
+}
+
+void CandidateGenerator::shuffle_level(unsigned depth) {
+  cursor_[depth] = 0;
+  std::array<std::uint8_t, kMaxColours>& order = order_[depth];
+  unsigned size = 0;
+  for (Propagator::Domain d = domains_[depth]; d != 0; d &= d - 1) {
+    order[size++] = static_cast<std::uint8_t>(std::countr_zero(d));
+  }
+  sizes_[depth] = size;
+  if (!randomise_) return;
+  for (unsigned i = size; i-- > 1;) {
+    std::swap(order[i], order[rng_() % (i + 1)]);
+  }
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,119 @@
+#include "mastermyr/candidate_set.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "mastermyr/metrics.hpp"
+#include "mastermyr/score.hpp"
+
+namespace mastermyr {
+namespace {
+
+// Candidates scored per kernel call while filtering; the feedback block stays
+// in L1 between scoring and compaction.
+constexpr std::size_t kFilterBlock = 1024;
+
+}  // namespace
+
+template <typename T>
+CandidateSet::Buffer<T> CandidateSet::allocate(std::size_t n) {
+  // Round up so that vector kernels may read a whole register past the end.
+  const std::size_t bytes =
+      (n * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+  const std::size_t size = std::max(bytes, kAlignment);
+  void* p = resource_->allocate(size, kAlignment);
+  return Buffer<T>(static_cast<T*>(p), BufferDelete{resource_, size});
+}
+
+CandidateSet::CandidateSet(const CandidateSet& other) { *this = other; }
+
+CandidateSet& CandidateSet::operator=(const CandidateSet& other) {
+  if (this == &other) return *this;
+  size_ = 0;
+  reserve(other.size_);
+  std::copy_n(other.codes_.get(), other.size_, codes_.get());
+  std::copy_n(other.ids_.get(), other.size_, ids_.get());
+  size_ = other.size_;
+  return *this;
+}
+
+void CandidateSet::reserve(std::size_t capacity) {
+  if (capacity <= capacity_) return;
+  Buffer<Code> codes = allocate<Code>(capacity);
+  Buffer<std::uint32_t> ids = allocate<std::uint32_t>(capacity);
+  std::copy_n(codes_.get(), size_, codes.get());
+  std::copy_n(ids_.get(), size_, ids.get());
+  codes_ = std::move(codes);
+  ids_ = std::move(ids);
+  capacity_ = capacity;
+}
+
+void CandidateSet::assign_all(unsigned pegs, unsigned colours,
+                              DuplicateRule duplicates) {
+  const bool distinct = duplicates == DuplicateRule::kForbidden;
+  std::size_t n = 1;
+  std::size_t size = 1;
+  for (unsigned i = 0; i < pegs; ++i) {
+    n *= colours;
+    size *= distinct ? (colours > i ? colours - i : 0) : colours;
+  }
+  reserve(size);
+  std::array<unsigned, kMaxPegs> digits{};
+  Code code;
+  std::size_t id = 0;
+  for (std::size_t index = 0; index < n; ++index) {
+    if (!distinct || !has_repeated_colour(code, pegs)) {
+      codes_[id] = code;
+      ids_[id] = static_cast<std::uint32_t>(id);
+      ++id;
+    }
+    // Odometer increment over base-`colours` digits, peg 0 fastest.
+    for (unsigned i = 0; i < pegs; ++i) {
+      if (++digits[i] < colours) {
+        code = code.with_peg(i, digits[i]);
+        break;
+      }
+      digits[i] = 0;
+      code = code.with_peg(i, 0);
+    }
+  }
+  size_ = size;
+}
+
+void CandidateSet::filter(Code guess, Feedback feedback, unsigned pegs) {
+  const metrics::ScopedTimer timer(metrics::Phase::kFilter);
+  metrics::add(metrics::Counter::kCodesFiltered, size_);
+  std::array<Feedback, kFilterBlock> scores;
+  Code* codes = codes_.get();
+  std::uint32_t* ids = ids_.get();
+  std::size_t kept = 0;
+  for (std::size_t begin = 0; begin < size_; begin += kFilterBlock) {
+    const std::size_t n = std::min(kFilterBlock, size_ - begin);
+    score_batch(guess, codes + begin, n, scores.data(), pegs);
+    // Branchless stream compaction: every element is written to the current
+    // output slot, which only advances when the element is kept. The output
+    // never overtakes the input, so this is safe in place.
+    for (std::size_t i = 0; i < n; ++i) {
+      codes[kept] = codes[begin + i];
+      ids[kept] = ids[begin + i];
+      kept += scores[i] == feedback;
+    }
+  }
+  size_ = kept;
+}
+
+void CandidateSet::filter(std::span<const Feedback> row, Feedback feedback) {
+  const metrics::ScopedTimer timer(metrics::Phase::kFilter);
+  metrics::add(metrics::Counter::kCodesFiltered, size_);
+  Code* codes = codes_.get();
+  std::uint32_t* ids = ids_.get();
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < size_; ++i) {
+    codes[kept] = codes[i];
+    ids[kept] = ids[i];
+    kept += row[ids[i]] == feedback;
+  }
+  size_ = kept;
+}
+
+}  // namespace mastermyr
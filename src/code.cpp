@@ -0,0 +1,60 @@
+#include "mastermyr/code.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace mastermyr {
+
+Feedback score(Code guess, Code secret, unsigned pegs) {
+  std::array<unsigned, kMaxColours> guess_counts{};
+  std::array<unsigned, kMaxColours> secret_counts{};
+  unsigned black = 0;
+  for (unsigned i = 0; i < pegs; ++i) {
+    const unsigned g = guess.peg(i);
+    const unsigned s = secret.peg(i);
+    black += g == s;
+    ++guess_counts[g];
+    ++secret_counts[s];
+  }
+  unsigned total = 0;
+  for (unsigned c = 0; c < kMaxColours; ++c) {
+    total += std::min(guess_counts[c], secret_counts[c]);
+  }
+  return Feedback(black, total - black);
+}
+
+std::string to_string(Code code, unsigned pegs) {
+  static constexpr std::string_view kDigits = "0123456789abcdef";
+  std::string text(pegs, '0');
+  for (unsigned i = 0; i < pegs; ++i) text[i] = kDigits[code.peg(i)];
+  return text;
+}
+
+std::string to_string(Feedback feedback) {
+  return std::to_string(feedback.black()) + "b" +
+         std::to_string(feedback.white()) + "w";
+}
+
+std::optional<Code> parse_code(std::string_view text, unsigned pegs,
+                               unsigned colours) {
+  if (text.size() != pegs) return std::nullopt;
+  Code code;
+  for (unsigned i = 0; i < pegs; ++i) {
+    const char ch = text[i];
+    unsigned colour;
+    if (ch >= '0' && ch <= '9') {
+      colour = static_cast<unsigned>(ch - '0');
+    } else if (ch >= 'a' && ch <= 'f') {
+      colour = static_cast<unsigned>(ch - 'a') + 10;
+    } else if (ch >= 'A' && ch <= 'F') {
+      colour = static_cast<unsigned>(ch - 'A') + 10;
+    } else {
+      return std::nullopt;
+    }
+    if (colour >= colours) return std::nullopt;
+    code = code.with_peg(i, colour);
+  }
+  return code;
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,201 @@
+#include "mastermyr/compact_candidates.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include "mastermyr/score.hpp"
+
+namespace mastermyr {
+namespace {
+
+// Codes scored per kernel call while building feedback bitmaps.
+constexpr std::size_t kBuildBlock = 1024;
+
+// Position of the `n`-th set bit of `word`, which has more than n.
+unsigned select_in_word(std::uint64_t word, std::size_t n) {
+  for (; n > 0; --n) word &= word - 1;
+  return static_cast<unsigned>(std::countr_zero(word));
+}
+
+}  // namespace
+
+CompactCandidates::CompactCandidates(const CandidateSet& set,
+                                     std::size_t universe) {
+  assign(set, universe);
+}
+
+void CompactCandidates::assign(const CandidateSet& set,
+                               std::size_t universe) {
+  universe_ = universe;
+  size_ = set.size();
+  if (!dense_for(size_)) {
+    words_.clear();
+    directory_.clear();
+    ids_.assign(set.ids().begin(), set.ids().end());
+    return;
+  }
+  ids_.clear();
+  words_.assign(words_for(universe), 0);
+  for (const std::uint32_t id : set.ids()) {
+    words_[id >> 6] |= std::uint64_t{1} << (id & 63);
+  }
+  finish_bits();
+}
+
+CompactCandidates::CompactCandidates(std::span<const std::uint64_t> bits,
+                                     std::size_t universe)
+    : universe_(universe),
+      words_(bits.begin(), bits.begin() + words_for(universe)) {
+  finish_bits();
+}
+
+std::size_t CompactCandidates::bytes() const {
+  return words_.capacity() * sizeof(std::uint64_t) +
+         directory_.capacity() * sizeof(std::uint32_t) +
+         ids_.capacity() * sizeof(std::uint32_t);
+}
+
+bool CompactCandidates::contains(std::uint32_t id) const {
+  if (id >= universe_) return false;
+  if (dense()) return (words_[id >> 6] >> (id & 63)) & 1;
+  return std::binary_search(ids_.begin(), ids_.end(), id);
+}
+
+std::size_t CompactCandidates::rank(std::uint32_t id) const {
+  if (id >= universe_) return size_;
+  if (!dense()) {
+    return static_cast<std::size_t>(
+        std::lower_bound(ids_.begin(), ids_.end(), id) - ids_.begin());
+  }
+  const std::size_t word = id >> 6;
+  std::size_t count = directory_[word / kBlockWords];
+  for (std::size_t w = word / kBlockWords * kBlockWords; w < word; ++w) {
+    count += static_cast<std::size_t>(std::popcount(words_[w]));
+  }
+  const std::uint64_t below = (std::uint64_t{1} << (id & 63)) - 1;
+  return count + static_cast<std::size_t>(std::popcount(words_[word] & below));
+}
+
+std::uint32_t CompactCandidates::select(std::size_t i) const {
+  if (!dense()) return ids_[i];
+  // The last block with fewer than i + 1 candidates before it.
+  const std::size_t block =
+      static_cast<std::size_t>(
+          std::upper_bound(directory_.begin(), directory_.end(), i) -
+          directory_.begin()) -
+      1;
+  std::size_t count = directory_[block];
+  for (std::size_t w = block * kBlockWords;; ++w) {
+    const auto bits = static_cast<std::size_t>(std::popcount(words_[w]));
+    if (count + bits > i) {
+      return static_cast<std::uint32_t>(
+          w * 64 + select_in_word(words_[w], i - count));
+    }
+    count += bits;
+  }
+}
+
+void CompactCandidates::intersect(std::span<const std::uint64_t> mask) {
+  if (dense()) {
+    for (std::size_t w = 0; w < words_.size(); ++w) words_[w] &= mask[w];
+    finish_bits();
+    return;
+  }
+  std::erase_if(ids_, [&](std::uint32_t id) {
+    return ((mask[id >> 6] >> (id & 63)) & 1) == 0;
+  });
+  size_ = ids_.size();
+}
+
+void CompactCandidates::expand(CandidateSet& out, unsigned pegs,
+                               unsigned colours,
+                               const CandidateSet* all) const {
+  if (dense()) {
+    expand(words_, out, pegs, colours, all);
+    return;
+  }
+  out.clear();
+  out.reserve(size_);
+  for (const std::uint32_t id : ids_) {
+    out.push_back(all != nullptr ? (*all)[id] : code_at_index(id, pegs, colours),
+                  id);
+  }
+}
+
+void CompactCandidates::expand(std::span<const std::uint64_t> bits,
+                               CandidateSet& out, unsigned pegs,
+                               unsigned colours, const CandidateSet* all) {
+  std::size_t count = 0;
+  for (const std::uint64_t word : bits) {
+    count += static_cast<std::size_t>(std::popcount(word));
+  }
+  out.clear();
+  out.reserve(count);
+  for (std::size_t w = 0; w < bits.size(); ++w) {
+    for (std::uint64_t word = bits[w]; word != 0; word &= word - 1) {
+      const auto id =
+          static_cast<std::uint32_t>(w * 64 + std::countr_zero(word));
+      out.push_back(
+          all != nullptr ? (*all)[id] : code_at_index(id, pegs, colours), id);
+    }
+  }
+}
+
+void CompactCandidates::finish_bits() {
+  directory_.assign((words_.size() + kBlockWords - 1) / kBlockWords, 0);
+  std::size_t count = 0;
+  for (std::size_t w = 0; w < words_.size(); ++w) {
+    if (w % kBlockWords == 0) {
+      directory_[w / kBlockWords] = static_cast<std::uint32_t>(count);
+    }
+    count += static_cast<std::size_t>(std::popcount(words_[w]));
+  }
+  size_ = count;
+  if (dense_for(size_)) return;
+  ids_.clear();
+  ids_.reserve(size_);
+  for (std::size_t w = 0; w < words_.size(); ++w) {
+    for (std::uint64_t word = words_[w]; word != 0; word &= word - 1) {
+      ids_.push_back(
+          static_cast<std::uint32_t>(w * 64 + std::countr_zero(word)));
+    }
+  }
+  words_ = {};
+  directory_ = {};
+}
+
+FeedbackBitmaps::FeedbackBitmaps(Code guess, unsigned pegs, unsigned colours)
+    : guess_(guess), pegs_(pegs) {
+  universe_ = 1;
+  for (unsigned i = 0; i < pegs; ++i) universe_ *= colours;
+  build([&](std::size_t id) {
+    return code_at_index(static_cast<std::uint32_t>(id), pegs, colours);
+  });
+}
+
+FeedbackBitmaps::FeedbackBitmaps(Code guess, std::span<const Code> codes,
+                                 unsigned pegs)
+    : guess_(guess), pegs_(pegs), universe_(codes.size()) {
+  build([&](std::size_t id) { return codes[id]; });
+}
+
+template <typename CodeAt>
+void FeedbackBitmaps::build(CodeAt code_at) {
+  words_ = (universe_ + 63) / 64;
+  bits_.assign(feedback_ranks(pegs_) * words_, 0);
+  std::array<Code, kBuildBlock> codes;
+  std::array<Feedback, kBuildBlock> scores;
+  for (std::size_t begin = 0; begin < universe_; begin += kBuildBlock) {
+    const std::size_t n = std::min(kBuildBlock, universe_ - begin);
+    for (std::size_t j = 0; j < n; ++j) codes[j] = code_at(begin + j);
+    score_batch(guess_, codes.data(), n, scores.data(), pegs_);
+    for (std::size_t j = 0; j < n; ++j) {
+      const std::size_t id = begin + j;
+      bits_[feedback_rank(scores[j], pegs_) * words_ + id / 64] |=
+          std::uint64_t{1} << (id % 64);
+    }
+  }
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,163 @@
+#include "cuda_backend.hpp"
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "mastermyr/hash.hpp"
+
+// The scoring is the nibble formulation of score.cpp (see the comment
+// there), with one thread per candidate and __popc in place of the
+// multiply-gather. Each block rates one guess into a histogram in shared
+// memory and writes it out once, so global atomics are never needed.
+
+namespace mastermyr {
+namespace {
+
+constexpr unsigned kThreads = 256;
+constexpr std::uint32_t kLow3 = 0x77777777u;
+constexpr std::uint32_t kHigh = 0x88888888u;
+constexpr std::uint32_t kGather = 0x11111111u;
+
+void check(cudaError_t status, const char* what) {
+  if (status != cudaSuccess) {
+    throw std::runtime_error(std::string(what) + ": " +
+                             cudaGetErrorString(status));
+  }
+}
+
+__device__ unsigned zero_nibbles(std::uint32_t x, std::uint32_t high_mask) {
+  return __popc(~(((x & kLow3) + kLow3) | x) & high_mask);
+}
+
+__global__ void partition_kernel(const std::uint32_t* guesses,
+                                 const std::uint32_t* candidates,
+                                 unsigned count, unsigned pegs,
+                                 unsigned slots, std::uint32_t* counts) {
+  extern __shared__ std::uint32_t histogram[];
+  for (unsigned k = threadIdx.x; k < slots; k += blockDim.x) histogram[k] = 0;
+
+  const std::uint32_t guess = guesses[blockIdx.x];
+  const std::uint32_t high_mask =
+      (pegs >= 8 ? ~0u : (1u << (pegs * 4)) - 1) & kHigh;
+  std::uint32_t splat[8];
+  unsigned want[8];
+  unsigned distinct = 0;
+  for (unsigned i = 0; i < pegs; ++i) {
+    const std::uint32_t s = ((guess >> (i * 4)) & 0xF) * kGather;
+    unsigned k = 0;
+    while (k < distinct && splat[k] != s) ++k;
+    if (k == distinct) {
+      splat[distinct] = s;
+      want[distinct++] = 0;
+    }
+    ++want[k];
+  }
+  __syncthreads();
+
+  for (unsigned i = threadIdx.x; i < count; i += blockDim.x) {
+    const std::uint32_t c = candidates[i];
+    const unsigned black = zero_nibbles(guess ^ c, high_mask);
+    unsigned total = 0;
+    for (unsigned k = 0; k < distinct; ++k) {
+      total += min(zero_nibbles(c ^ splat[k], high_mask), want[k]);
+    }
+    atomicAdd(&histogram[black << 4 | (total - black)], 1u);
+  }
+  __syncthreads();
+
+  std::uint32_t* out = counts + std::size_t{blockIdx.x} * slots;
+  for (unsigned k = threadIdx.x; k < slots; k += blockDim.x) {
+    out[k] = histogram[k];
+  }
+}
+
+class DeviceBuffer {
+ public:
+  DeviceBuffer() = default;
+  ~DeviceBuffer() { cudaFree(data_); }
+  DeviceBuffer(const DeviceBuffer&) = delete;
+  DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+
+  void reserve(std::size_t bytes) {
+    if (bytes <= capacity_) return;
+    cudaFree(data_);
+    data_ = nullptr;
+    capacity_ = 0;
+    check(cudaMalloc(&data_, bytes), "cudaMalloc");
+    capacity_ = bytes;
+  }
+  template <typename T>
+  T* as() const {
+    return static_cast<T*>(data_);
+  }
+
+ private:
+  void* data_ = nullptr;
+  std::size_t capacity_ = 0;
+};
+
+// The candidates stay on the device between calls and are uploaded again
+// only when they change, so the several evaluations of one move (sample,
+// full rating) and repeated calls on one position share a single copy.
+class CudaBackend final : public PartitionBackend {
+ public:
+  const char* name() const override { return "cuda"; }
+
+  void partitions(std::span<const Code> guesses,
+                  std::span<const Code> candidates, unsigned pegs,
+                  std::span<std::uint32_t> counts) override {
+    if (guesses.empty()) return;
+    const unsigned slots = static_cast<unsigned>(feedback_slots(pegs));
+    std::lock_guard lock(mutex_);
+
+    const std::uint64_t key =
+        hash_bytes(candidates.data(), candidates.size_bytes());
+    if (key != candidates_key_ || candidates.size() != candidates_count_) {
+      candidates_.reserve(candidates.size_bytes());
+      check(cudaMemcpy(candidates_.as<void>(), candidates.data(),
+                       candidates.size_bytes(), cudaMemcpyHostToDevice),
+            "cudaMemcpy candidates");
+      candidates_key_ = key;
+      candidates_count_ = candidates.size();
+    }
+    guesses_.reserve(guesses.size_bytes());
+    check(cudaMemcpy(guesses_.as<void>(), guesses.data(), guesses.size_bytes(),
+                     cudaMemcpyHostToDevice),
+          "cudaMemcpy guesses");
+    counts_.reserve(counts.size_bytes());
+
+    partition_kernel<<<static_cast<unsigned>(guesses.size()), kThreads,
+                       slots * sizeof(std::uint32_t)>>>(
+        guesses_.as<std::uint32_t>(), candidates_.as<std::uint32_t>(),
+        static_cast<unsigned>(candidates.size()), pegs, slots,
+        counts_.as<std::uint32_t>());
+    check(cudaGetLastError(), "partition_kernel");
+    check(cudaMemcpy(counts.data(), counts_.as<void>(), counts.size_bytes(),
+                     cudaMemcpyDeviceToHost),
+          "cudaMemcpy counts");
+  }
+
+ private:
+  std::mutex mutex_;
+  DeviceBuffer candidates_;
+  DeviceBuffer guesses_;
+  DeviceBuffer counts_;
+  std::uint64_t candidates_key_ = 0;
+  std::size_t candidates_count_ = 0;
+};
+
+}  // namespace
+
+std::shared_ptr<PartitionBackend> make_cuda_backend() {
+  int devices = 0;
+  if (cudaGetDeviceCount(&devices) != cudaSuccess || devices == 0) {
+    return nullptr;
+  }
+  return std::make_shared<CudaBackend>();
+}
+
+}  // namespace mastermyr
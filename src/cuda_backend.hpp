@@ -0,0 +1,12 @@
+#pragma once
+
+#include <memory>
+
+#include "mastermyr/partition_backend.hpp"
+
+namespace mastermyr {
+
+// Null when no CUDA device is present.
+std::shared_ptr<PartitionBackend> make_cuda_backend();
+
+}  // namespace mastermyr
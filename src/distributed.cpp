@@ -0,0 +1,550 @@
+#include "mastermyr/distributed.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "mastermyr/hash.hpp"
+#include "mastermyr/wire.hpp"
+
+namespace mastermyr {
+namespace {
+
+using wire::detail::load;
+
+constexpr std::size_t kJobHeader = 17;
+constexpr std::size_t kResultHeader = 16;
+// Largest result accepted; a 6x10 subtree is a few megabytes.
+constexpr std::size_t kMaxResult = std::size_t{1} << 30;
+constexpr std::uint8_t kSearchOpening = 1;
+constexpr std::uint8_t kSymmetry = 2;
+constexpr std::uint8_t kPrune = 4;
+
+constexpr std::array<char, 8> kCheckpointMagic = {'M', 'M', 'Y', 'R',
+                                                  'J', 'O', 'B', 0};
+
+// Precedes a result body in a checkpoint file.
+struct CheckpointHeader {
+  std::array<char, 8> magic;
+  std::uint64_t plan;
+  std::uint64_t checksum;  // of the body
+};
+static_assert(sizeof(CheckpointHeader) == 24);
+
+[[noreturn]] void throw_errno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+template <typename T>
+std::byte* store(std::byte* p, T value) {
+  std::memcpy(p, &value, sizeof(value));
+  return p + sizeof(value);
+}
+
+// Compiles ignore time budgets: a deadline would make a subtree depend on
+// the speed of the machine that searched it.
+SolverOptions without_deadline(SolverOptions options) {
+  options.time_budget = {};
+  return options;
+}
+
+std::uint8_t search_flags(const SolverOptions& options) {
+  return static_cast<std::uint8_t>(
+      (options.search_opening ? kSearchOpening : 0) |
+      (options.symmetry ? kSymmetry : 0) | (options.prune ? kPrune : 0));
+}
+
+bool read_exact(int fd, void* data, std::size_t size) {
+  auto* p = static_cast<char*>(data);
+  while (size > 0) {
+    const ssize_t n = ::recv(fd, p, size, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+bool write_all(int fd, const void* data, std::size_t size) {
+  const auto* p = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// Reads one frame's body; false at the end of the stream, on an error or
+// for a frame over `max_body`.
+bool read_frame(int fd, std::vector<std::byte>& body, std::size_t max_body) {
+  std::uint32_t length = 0;
+  if (!read_exact(fd, &length, sizeof(length)) || length > max_body) {
+    return false;
+  }
+  body.resize(length);
+  return read_exact(fd, body.data(), length);
+}
+
+bool write_frame(int fd, std::span<const std::byte> body) {
+  const auto length = static_cast<std::uint32_t>(body.size());
+  return write_all(fd, &length, sizeof(length)) &&
+         write_all(fd, body.data(), body.size());
+}
+
+void encode_job(std::vector<std::byte>& out, std::uint32_t job,
+                const StrategyTree::Split& split,
+                const SolverOptions& options) {
+  const std::vector<Move>& moves = split.jobs[job];
+  out.resize(kJobHeader + moves.size() * wire::kMoveSize);
+  std::byte* p = out.data();
+  p = store(p, job);
+  p = store(p, static_cast<std::uint8_t>(split.key.pegs));
+  p = store(p, static_cast<std::uint8_t>(split.key.colours));
+  p = store(p, static_cast<std::uint8_t>(split.strategy));
+  p = store(p, search_flags(options));
+  p = store(p, static_cast<std::uint32_t>(options.max_guesses));
+  p = store(p, static_cast<std::uint32_t>(options.estimate_from));
+  p = store(p, static_cast<std::uint8_t>(moves.size()));
+  for (const Move& move : moves) {
+    p = store(p, move.guess.bits());
+    p = store(p, move.feedback.raw());
+  }
+}
+
+void encode_result(std::vector<std::byte>& out, std::uint32_t job,
+                   const StrategyTree::Subtree& subtree) {
+  const std::size_t node_bytes =
+      subtree.nodes.size() * sizeof(StrategyTree::Node);
+  const std::size_t slot_bytes =
+      subtree.children.size() * sizeof(StrategyTree::NodeIndex);
+  out.resize(kResultHeader + node_bytes + slot_bytes);
+  std::byte* p = out.data();
+  p = store(p, job);
+  p = store(p, static_cast<std::uint32_t>(subtree.depth));
+  p = store(p, static_cast<std::uint32_t>(subtree.nodes.size()));
+  p = store(p, static_cast<std::uint32_t>(subtree.children.size()));
+  std::memcpy(p, subtree.nodes.data(), node_bytes);
+  std::memcpy(p + node_bytes, subtree.children.data(), slot_bytes);
+}
+
+// The subtree in a result body for `job`, or nullopt unless the body is
+// well formed: sized to its counts, and every node's slots and every slot's
+// node inside the arrays, so that splicing it cannot go out of bounds.
+std::optional<StrategyTree::Subtree> decode_result(
+    std::span<const std::byte> body, std::uint32_t job, unsigned pegs) {
+  using Node = StrategyTree::Node;
+  using NodeIndex = StrategyTree::NodeIndex;
+  if (body.size() < kResultHeader || load<std::uint32_t>(body.data()) != job) {
+    return std::nullopt;
+  }
+  const std::uint32_t depth = load<std::uint32_t>(body.data() + 4);
+  const std::size_t node_count = load<std::uint32_t>(body.data() + 8);
+  const std::size_t slot_count = load<std::uint32_t>(body.data() + 12);
+  if (node_count == 0 || depth == 0 || depth > StrategyTree::kMaxDepth ||
+      body.size() != kResultHeader + node_count * sizeof(Node) +
+                         slot_count * sizeof(NodeIndex)) {
+    return std::nullopt;
+  }
+  StrategyTree::Subtree subtree;
+  subtree.depth = depth;
+  subtree.nodes.resize(node_count);
+  subtree.children.resize(slot_count);
+  const std::byte* p = body.data() + kResultHeader;
+  std::memcpy(subtree.nodes.data(), p, node_count * sizeof(Node));
+  std::memcpy(subtree.children.data(), p + node_count * sizeof(Node),
+              slot_count * sizeof(NodeIndex));
+  if (!StrategyTree::well_formed(subtree.nodes, subtree.children, pegs)) {
+    return std::nullopt;
+  }
+  return subtree;
+}
+
+std::uint64_t plan_hash(const StrategyTree::Split& split,
+                        const SolverOptions& options) {
+  std::vector<std::byte> bytes;
+  for (std::uint32_t job = 0; job < split.jobs.size(); ++job) {
+    std::vector<std::byte> frame;
+    encode_job(frame, job, split, options);
+    bytes.insert(bytes.end(), frame.begin(), frame.end());
+  }
+  std::uint64_t hash = hash_bytes(bytes.data(), bytes.size());
+  hash = hash_bytes(split.nodes.data(),
+                    split.nodes.size() * sizeof(StrategyTree::Node), hash);
+  return hash_bytes(split.children.data(),
+                    split.children.size() * sizeof(StrategyTree::NodeIndex),
+                    hash);
+}
+
+int listen_on(const CoordinatorOptions& options) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  if (::inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+    throw std::invalid_argument("not an IPv4 address: " + options.host);
+  }
+  const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw_errno("socket");
+  const int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (::bind(fd, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(fd, options.backlog) != 0) {
+    const int error = errno;
+    ::close(fd);
+    errno = error;
+    throw_errno("listen on " + options.host + ":" +
+                std::to_string(options.port));
+  }
+  return fd;
+}
+
+int connect_to(const std::string& host, std::uint16_t port) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* found = nullptr;
+  const std::string service = std::to_string(port);
+  if (const int error =
+          ::getaddrinfo(host.c_str(), service.c_str(), &hints, &found);
+      error != 0) {
+    throw std::system_error(std::make_error_code(std::errc::host_unreachable),
+                            host + ": " + ::gai_strerror(error));
+  }
+  int fd = -1;
+  for (addrinfo* a = found; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+    if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  ::freeaddrinfo(found);
+  if (fd < 0) throw_errno("connect to " + host + ":" + service);
+  const int on = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+// Compiles jobs from one connection until done or the end of the stream.
+std::size_t work(int fd, const SolverOptions& base) {
+  std::vector<std::byte> body;
+  std::vector<std::byte> out;
+  std::size_t jobs = 0;
+  while (read_frame(fd, body, kJobHeader + wire::kMaxMoves * wire::kMoveSize)) {
+    if (body.empty()) break;
+    if (body.size() < kJobHeader ||
+        body.size() !=
+            kJobHeader + wire::kMoveSize * std::size_t{load<std::uint8_t>(
+                                               body.data() + 16)} ||
+        !is_strategy(load<std::uint8_t>(body.data() + 6))) {
+      throw wire::WireError("malformed job frame");
+    }
+    const std::byte* p = body.data();
+    const std::uint32_t job = load<std::uint32_t>(p);
+    const unsigned pegs = load<std::uint8_t>(p + 4);
+    const unsigned colours = load<std::uint8_t>(p + 5);
+    const std::uint8_t flags = load<std::uint8_t>(p + 7);
+    SolverOptions options = without_deadline(base);
+    options.strategy = static_cast<Strategy>(load<std::uint8_t>(p + 6));
+    options.search_opening = (flags & kSearchOpening) != 0;
+    options.symmetry = (flags & kSymmetry) != 0;
+    options.prune = (flags & kPrune) != 0;
+    options.max_guesses = load<std::uint32_t>(p + 8);
+    options.estimate_from = load<std::uint32_t>(p + 12);
+    if (options.feedback_matrix &&
+        (options.feedback_matrix->key().pegs != pegs ||
+         options.feedback_matrix->key().colours != colours)) {
+      options.feedback_matrix.reset();
+    }
+    std::vector<Move> moves(load<std::uint8_t>(p + 16));
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      const std::byte* move = p + kJobHeader + i * wire::kMoveSize;
+      moves[i] = {Code(load<std::uint32_t>(move)),
+                  Feedback(load<std::uint8_t>(move + 4))};
+    }
+    const StrategyTree::Subtree subtree =
+        StrategyTree::compile_subtree(pegs, colours, options, moves);
+    encode_result(out, job, subtree);
+    if (!write_frame(fd, out)) break;
+    ++jobs;
+  }
+  return jobs;
+}
+
+}  // namespace
+
+Coordinator::Coordinator(CoordinatorOptions options, unsigned pegs,
+                         unsigned colours, const SolverOptions& solver_options)
+    : options_(std::move(options)),
+      solver_options_(without_deadline(solver_options)),
+      split_(StrategyTree::split(pegs, colours, solver_options_)),
+      plan_(plan_hash(split_, solver_options_)),
+      results_(split_.jobs.size()) {
+  load_checkpoints();
+  for (std::size_t job = 0; job < results_.size(); ++job) {
+    if (!results_[job]) queue_.push_back(job);
+  }
+  listen_fd_ = listen_on(options_);
+  wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd_ < 0) {
+    ::close(listen_fd_);
+    throw_errno("eventfd");
+  }
+  sockaddr_in bound{};
+  socklen_t length = sizeof(bound);
+  ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&bound), &length);
+  port_ = ntohs(bound.sin_port);
+}
+
+Coordinator::~Coordinator() {
+  stop();
+  sessions_.clear();
+  ::close(listen_fd_);
+  ::close(wake_fd_);
+}
+
+std::size_t Coordinator::completed() const {
+  std::lock_guard lock(mutex_);
+  return completed_;
+}
+
+std::optional<StrategyTree> Coordinator::run() {
+  accept_loop();
+  {
+    // Sessions still blocked on a worker only return once it is cut off.
+    std::lock_guard lock(mutex_);
+    if (completed_ < results_.size()) {
+      for (const int fd : sessions_fds_) ::shutdown(fd, SHUT_RDWR);
+    }
+  }
+  sessions_.clear();
+  std::lock_guard lock(mutex_);
+  if (completed_ < results_.size()) return std::nullopt;
+  std::vector<StrategyTree::Subtree> subtrees;
+  subtrees.reserve(results_.size());
+  for (std::optional<StrategyTree::Subtree>& result : results_) {
+    subtrees.push_back(std::move(*result));
+  }
+  return StrategyTree::assemble(split_, subtrees);
+}
+
+void Coordinator::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_.store(true, std::memory_order_relaxed);
+    for (const int fd : sessions_fds_) ::shutdown(fd, SHUT_RDWR);
+  }
+  changed_.notify_all();
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+}
+
+void Coordinator::accept_loop() {
+  std::array<pollfd, 2> fds{};
+  fds[0] = {listen_fd_, POLLIN, 0};
+  fds[1] = {wake_fd_, POLLIN, 0};
+  while (true) {
+    {
+      std::lock_guard lock(mutex_);
+      if (stopping_.load(std::memory_order_relaxed) ||
+          completed_ == results_.size()) {
+        return;
+      }
+    }
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("poll");
+    }
+    if ((fds[1].revents & POLLIN) != 0) {
+      std::uint64_t count = 0;
+      [[maybe_unused]] const ssize_t n =
+          ::read(wake_fd_, &count, sizeof(count));
+      continue;
+    }
+    if ((fds[0].revents & POLLIN) == 0) continue;
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) continue;
+    const int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    ::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+    std::lock_guard lock(mutex_);
+    sessions_fds_.push_back(fd);
+    sessions_.emplace_back([this, fd] { session(fd); });
+  }
+}
+
+void Coordinator::session(int fd) {
+  std::vector<std::byte> frame;
+  bool connected = true;
+  while (const std::optional<std::size_t> job = take()) {
+    encode_job(frame, static_cast<std::uint32_t>(*job), split_,
+               solver_options_);
+    std::optional<StrategyTree::Subtree> subtree;
+    if (write_frame(fd, frame) && read_frame(fd, frame, kMaxResult)) {
+      subtree = decode_result(frame, static_cast<std::uint32_t>(*job),
+                              split_.key.pegs);
+    }
+    if (!subtree) {
+      requeue(*job);
+      connected = false;
+      break;
+    }
+    complete(*job, std::move(*subtree));
+  }
+  if (connected && !stopping_.load(std::memory_order_relaxed)) {
+    write_frame(fd, {});
+  }
+  std::lock_guard lock(mutex_);
+  std::erase(sessions_fds_, fd);
+  ::close(fd);
+}
+
+std::optional<std::size_t> Coordinator::take() {
+  std::unique_lock lock(mutex_);
+  changed_.wait(lock, [&] {
+    return stopping_.load(std::memory_order_relaxed) || !queue_.empty() ||
+           completed_ == results_.size();
+  });
+  if (stopping_.load(std::memory_order_relaxed) || queue_.empty()) {
+    return std::nullopt;
+  }
+  const std::size_t job = queue_.front();
+  queue_.pop_front();
+  return job;
+}
+
+void Coordinator::complete(std::size_t job, StrategyTree::Subtree subtree) {
+  if (!options_.checkpoint_dir.empty()) {
+    std::vector<std::byte> body;
+    encode_result(body, static_cast<std::uint32_t>(job), subtree);
+    CheckpointHeader header{kCheckpointMagic, plan_,
+                            hash_bytes(body.data(), body.size())};
+    const std::filesystem::path file = checkpoint_path(job);
+    std::filesystem::path tmp = file;
+    tmp += ".tmp." + std::to_string(::getpid());
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(body.data()),
+              static_cast<std::streamsize>(body.size()));
+    out.close();
+    // A checkpoint that cannot be written only costs a rerun of the job.
+    std::error_code error;
+    if (out) {
+      std::filesystem::rename(tmp, file, error);
+    } else {
+      std::filesystem::remove(tmp, error);
+    }
+  }
+  bool finished = false;
+  {
+    std::lock_guard lock(mutex_);
+    if (!results_[job]) {
+      results_[job] = std::move(subtree);
+      ++completed_;
+    }
+    finished = completed_ == results_.size();
+  }
+  changed_.notify_all();
+  if (finished) {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+  }
+}
+
+void Coordinator::requeue(std::size_t job) {
+  {
+    std::lock_guard lock(mutex_);
+    queue_.push_front(job);
+  }
+  changed_.notify_one();
+}
+
+void Coordinator::load_checkpoints() {
+  if (options_.checkpoint_dir.empty()) return;
+  std::filesystem::create_directories(options_.checkpoint_dir);
+  for (std::size_t job = 0; job < results_.size(); ++job) {
+    std::ifstream in(checkpoint_path(job), std::ios::binary);
+    if (!in) continue;
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                                  std::istreambuf_iterator<char>());
+    CheckpointHeader header;
+    if (bytes.size() < sizeof(header)) continue;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    const std::span<const std::byte> body(
+        reinterpret_cast<const std::byte*>(bytes.data()) + sizeof(header),
+        bytes.size() - sizeof(header));
+    // Checkpoints of another split or torn by a crash are compiled again.
+    if (header.magic != kCheckpointMagic || header.plan != plan_ ||
+        header.checksum != hash_bytes(body.data(), body.size())) {
+      continue;
+    }
+    results_[job] = decode_result(body, static_cast<std::uint32_t>(job),
+                                  split_.key.pegs);
+    completed_ += results_[job].has_value();
+  }
+}
+
+std::filesystem::path Coordinator::checkpoint_path(std::size_t job) const {
+  return options_.checkpoint_dir / ("job-" + std::to_string(job) + ".bin");
+}
+
+std::size_t run_worker(const std::string& host, std::uint16_t port,
+                       const SolverOptions& options, unsigned connections) {
+  std::vector<int> fds;
+  try {
+    for (unsigned i = 0; i < std::max(connections, 1u); ++i) {
+      fds.push_back(connect_to(host, port));
+    }
+  } catch (...) {
+    for (const int fd : fds) ::close(fd);
+    throw;
+  }
+  std::vector<std::size_t> jobs(fds.size());
+  std::vector<std::exception_ptr> errors(fds.size());
+  {
+    std::vector<std::jthread> threads;
+    for (std::size_t i = 1; i < fds.size(); ++i) {
+      threads.emplace_back([&, i] {
+        try {
+          jobs[i] = work(fds[i], options);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      });
+    }
+    try {
+      jobs[0] = work(fds[0], options);
+    } catch (...) {
+      errors[0] = std::current_exception();
+    }
+  }
+  for (const int fd : fds) ::close(fd);
+  for (const std::exception_ptr& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  std::size_t total = 0;
+  for (const std::size_t n : jobs) total += n;
+  return total;
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,199 @@
+#include "mastermyr/feedback_matrix.hpp"
+
+#include <unistd.h>
+
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include "mastermyr/hash.hpp"
+#include "mastermyr/score.hpp"
+
+namespace mastermyr {
+namespace {
+
+static_assert(std::endian::native == std::endian::little,
+              "table files are written in host byte order");
+
+constexpr std::array<char, 8> kMagic = {'M', 'M', 'Y', 'R', 'F', 'B', 'M', 0};
+
+struct FileHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint8_t pegs;
+  std::uint8_t colours;
+  std::uint8_t duplicates;
+  std::uint8_t reserved0;
+  std::uint64_t code_count;
+  std::uint64_t payload_offset;
+  std::uint64_t payload_size;
+  std::uint64_t checksum;
+  std::array<std::uint8_t, 16> reserved1;
+};
+static_assert(sizeof(FileHeader) == 64);
+
+}  // namespace
+
+std::vector<Code> enumerate_codes(const BoardKey& key) {
+  std::size_t n = 1;
+  for (unsigned i = 0; i < key.pegs; ++i) n *= key.colours;
+  std::vector<Code> codes;
+  codes.reserve(n);
+  for (std::size_t index = 0; index < n; ++index) {
+    const Code code = code_at_index(static_cast<std::uint32_t>(index),
+                                    key.pegs, key.colours);
+    if (key.duplicates == DuplicateRule::kForbidden &&
+        has_repeated_colour(code, key.pegs)) {
+      continue;
+    }
+    codes.push_back(code);
+  }
+  return codes;
+}
+
+FeedbackMatrix FeedbackMatrix::build(const BoardKey& key) {
+  const std::vector<Code> codes = enumerate_codes(key);
+  FeedbackMatrix matrix;
+  matrix.key_ = key;
+  matrix.size_ = codes.size();
+  matrix.owned_.resize(codes.size() * codes.size());
+  for (std::size_t g = 0; g < codes.size(); ++g) {
+    score_batch(codes[g], codes.data(), codes.size(),
+                matrix.owned_.data() + g * codes.size(), key.pegs);
+  }
+  matrix.data_ = matrix.owned_.data();
+  return matrix;
+}
+
+FeedbackMatrix FeedbackMatrix::load(const std::filesystem::path& file,
+                                    const BoardKey& key) {
+  MappedFile mapping = MappedFile::open(file);
+  const std::span<const std::byte> bytes = mapping.bytes();
+  FileHeader header;
+  if (bytes.size() < sizeof(header)) {
+    throw CacheError(file.string() + ": truncated header");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kMagic) {
+    throw CacheError(file.string() + ": not a feedback table");
+  }
+  if (header.version != kFormatVersion) {
+    throw CacheError(file.string() + ": format version " +
+                     std::to_string(header.version) + ", expected " +
+                     std::to_string(kFormatVersion));
+  }
+  if (header.pegs != key.pegs || header.colours != key.colours ||
+      header.duplicates != static_cast<std::uint8_t>(key.duplicates)) {
+    throw CacheError(file.string() + ": table is for another board");
+  }
+  // The codes are not stored, so rows are only meaningful if the count is
+  // the board's; n is then small enough that n * n cannot overflow.
+  const std::uint64_t n = header.code_count;
+  if (n != enumerate_codes(key).size()) {
+    throw CacheError(file.string() + ": " + std::to_string(n) +
+                     " codes, not the board's");
+  }
+  if (header.payload_size != n * n ||
+      header.payload_offset < sizeof(header) ||
+      header.payload_size > bytes.size() ||
+      header.payload_offset > bytes.size() - header.payload_size) {
+    throw CacheError(file.string() + ": truncated payload");
+  }
+  const std::byte* payload = bytes.data() + header.payload_offset;
+  if (hash_bytes(payload, header.payload_size) != header.checksum) {
+    throw CacheError(file.string() + ": checksum mismatch");
+  }
+
+  FeedbackMatrix matrix;
+  matrix.key_ = key;
+  matrix.size_ = static_cast<std::size_t>(n);
+  matrix.data_ = reinterpret_cast<const Feedback*>(payload);
+  matrix.mapping_ = std::move(mapping);
+  return matrix;
+}
+
+FeedbackMatrix FeedbackMatrix::open(const BoardKey& key,
+                                    const std::filesystem::path& cache_dir) {
+  const std::filesystem::path file = cache_dir / feedback_cache_name(key);
+  try {
+    return load(file, key);
+  } catch (const CacheError&) {
+    // Stale or damaged; rebuilt and overwritten below.
+  } catch (const std::system_error&) {
+    // Not cached yet.
+  }
+  FeedbackMatrix built = build(key);
+  try {
+    std::filesystem::create_directories(cache_dir);
+    built.save(file);
+    return load(file, key);
+  } catch (const std::exception&) {
+    return built;
+  }
+}
+
+FeedbackMatrix FeedbackMatrix::copy_to_node(unsigned node) const {
+  FeedbackMatrix matrix;
+  matrix.key_ = key_;
+  matrix.size_ = size_;
+  matrix.replica_ = numa::NodeBuffer(size_ * size_, node);
+  std::memcpy(matrix.replica_.data(), data_, size_ * size_);
+  matrix.data_ = reinterpret_cast<const Feedback*>(matrix.replica_.data());
+  return matrix;
+}
+
+void FeedbackMatrix::save(const std::filesystem::path& file) const {
+  FileHeader header{};
+  header.magic = kMagic;
+  header.version = kFormatVersion;
+  header.pegs = static_cast<std::uint8_t>(key_.pegs);
+  header.colours = static_cast<std::uint8_t>(key_.colours);
+  header.duplicates = static_cast<std::uint8_t>(key_.duplicates);
+  header.code_count = size_;
+  header.payload_offset = sizeof(header);
+  header.payload_size = size_ * size_;
+  header.checksum = hash_bytes(data_, header.payload_size);
+
+  // Unique per process so that concurrent builders never share a temporary.
+  std::filesystem::path tmp = file;
+  tmp += ".tmp." + std::to_string(::getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data_),
+              static_cast<std::streamsize>(header.payload_size));
+    out.close();
+    if (!out) {
+      std::error_code ignored;
+      std::filesystem::remove(tmp, ignored);
+      throw CacheError("cannot write " + tmp.string());
+    }
+  }
+  std::filesystem::rename(tmp, file);
+}
+
+std::filesystem::path default_cache_dir() {
+  if (const char* dir = std::getenv("MASTERMYR_CACHE_DIR"); dir && *dir) {
+    return dir;
+  }
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::filesystem::path(xdg) / "mastermyr";
+  }
+  if (const char* home = std::getenv("HOME"); home && *home) {
+    return std::filesystem::path(home) / ".cache" / "mastermyr";
+  }
+  return ".mastermyr-cache";
+}
+
+std::string feedback_cache_name(const BoardKey& key) {
+  return "feedback-v" + std::to_string(FeedbackMatrix::kFormatVersion) + "-" +
+         std::to_string(key.pegs) + "x" + std::to_string(key.colours) +
+         (key.duplicates == DuplicateRule::kAllowed ? "-dup" : "-nodup") +
+         ".bin";
+}
+
+}  // namespace mastermyr
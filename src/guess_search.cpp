@@ -0,0 +1,27 @@
+#include "mastermyr/guess_search.hpp"
+
+namespace mastermyr {
+
+const char* strategy_name(Strategy strategy) {
+  switch (strategy) {
+    case Strategy::kMinimax:
+      return "minimax";
+    case Strategy::kMaxParts:
+      return "max-parts";
+    case Strategy::kExpectedSize:
+      return "expected-size";
+    case Strategy::kEntropy:
+      return "entropy";
+  }
+  return "unknown";
+}
+
+std::optional<Strategy> parse_strategy(std::string_view name) {
+  for (const Strategy s : {Strategy::kMinimax, Strategy::kMaxParts,
+                           Strategy::kExpectedSize, Strategy::kEntropy}) {
+    if (name == strategy_name(s)) return s;
+  }
+  return std::nullopt;
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,35 @@
+#include "mastermyr/hash.hpp"
+
+#include <cstring>
+
+namespace mastermyr {
+namespace {
+
+constexpr std::uint64_t kMul = 0x9e3779b97f4a7c15ull;
+
+constexpr std::uint64_t mix(std::uint64_t h) {
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ull;
+  h ^= h >> 32;
+  return h;
+}
+
+}  // namespace
+
+std::uint64_t hash_bytes(const void* data, std::size_t size,
+                         std::uint64_t seed) {
+  const auto* p = static_cast<const unsigned char*>(data);
+  std::uint64_t h = seed ^ (size * kMul);
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p + i, sizeof(word));
+    h = (h ^ mix(word)) * kMul;
+  }
+  std::uint64_t tail = 0;
+  std::memcpy(&tail, p + i, size - i);
+  h = (h ^ mix(tail)) * kMul;
+  return mix(h);
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,122 @@
+#include "mastermyr/metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace mastermyr::metrics {
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<detail::ThreadBlock*> live;
+  Snapshot retired;
+  // Taken at static initialisation to calibrate the timer.
+  std::uint64_t start_ticks = detail::ticks();
+  std::chrono::steady_clock::time_point start_time =
+      std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+  static Registry* r = new Registry;  // outlives every thread's exit
+  return *r;
+}
+
+[[maybe_unused]] const Registry& calibrate = registry();
+
+void accumulate(Snapshot& into, const detail::ThreadBlock& block) {
+  for (std::size_t i = 0; i < kCounters; ++i) {
+    into.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+  }
+  for (std::size_t i = 0; i < kPhases; ++i) {
+    into.calls[i] += block.calls[i].load(std::memory_order_relaxed);
+    into.ticks[i] += block.ticks[i].load(std::memory_order_relaxed);
+  }
+}
+
+// Folds the thread's counts into the retired totals when it exits.
+struct Registration {
+  detail::ThreadBlock block;
+
+  Registration() {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    r.live.push_back(&block);
+  }
+  ~Registration() {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    accumulate(r.retired, block);
+    r.live.erase(std::find(r.live.begin(), r.live.end(), &block));
+    detail::tls_block = nullptr;
+  }
+};
+
+constexpr const char* kCounterNames[kCounters] = {
+    "codes-scored", "codes-filtered", "searches",      "guesses-rated",
+    "guesses-pruned", "table-hits",   "table-misses",  "requests",
+    "book-hits",    "bytes-read",     "bytes-written"};
+constexpr const char* kPhaseNames[kPhases] = {"score", "filter", "search",
+                                              "table", "io"};
+
+}  // namespace
+
+namespace detail {
+
+ThreadBlock& attach() {
+  thread_local Registration registration;
+  tls_block = &registration.block;
+  return registration.block;
+}
+
+}  // namespace detail
+
+const char* counter_name(Counter counter) {
+  return kCounterNames[static_cast<std::size_t>(counter)];
+}
+
+const char* phase_name(Phase phase) {
+  return kPhaseNames[static_cast<std::size_t>(phase)];
+}
+
+Snapshot snapshot() {
+  Snapshot result;
+  if constexpr (!kEnabled) return result;
+  Registry& r = registry();
+  {
+    std::lock_guard lock(r.mutex);
+    result = r.retired;
+    for (const detail::ThreadBlock* block : r.live) accumulate(result, *block);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - r.start_time;
+  if (elapsed.count() > 0) {
+    result.ticks_per_second =
+        static_cast<double>(detail::ticks() - r.start_ticks) / elapsed.count();
+  }
+  return result;
+}
+
+void write(std::ostream& out, const Snapshot& snapshot) {
+  if constexpr (!kEnabled) {
+    out << "metrics compiled out (configure with -DMASTERMYR_METRICS=ON)\n";
+    return;
+  }
+  for (std::size_t i = 0; i < kCounters; ++i) {
+    out << kCounterNames[i] << ' ' << snapshot.counters[i] << '\n';
+  }
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  for (std::size_t i = 0; i < kPhases; ++i) {
+    out << "phase-" << kPhaseNames[i] << ' ' << snapshot.calls[i] << " calls "
+        << std::fixed << std::setprecision(6)
+        << snapshot.seconds(static_cast<Phase>(i)) << " s\n";
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+}  // namespace mastermyr::metrics
@@ -0,0 +1,144 @@
+#include "mastermyr/numa.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <new>
+#include <utility>
+
+#if defined(MASTERMYR_HAVE_NUMA)
+#include <numa.h>
+#endif
+
+namespace mastermyr::numa {
+namespace {
+
+constexpr std::align_val_t kAlignment{64};
+
+// The CPUs the process may run on.
+cpu_set_t allowed_cpus() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof(set), &set) != 0) CPU_SET(0, &set);
+  return set;
+}
+
+bool pin(const cpu_set_t& set) {
+  return CPU_COUNT(&set) > 0 &&
+         ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+}  // namespace
+
+bool available() {
+#if defined(MASTERMYR_HAVE_NUMA)
+  static const bool has_numa = ::numa_available() != -1;
+  return has_numa;
+#else
+  return false;
+#endif
+}
+
+unsigned nodes() {
+#if defined(MASTERMYR_HAVE_NUMA)
+  static const unsigned count =
+      available() ? static_cast<unsigned>(::numa_max_node() + 1) : 1;
+  return count;
+#else
+  return 1;
+#endif
+}
+
+std::vector<unsigned> cpus(unsigned node) {
+  const cpu_set_t allowed = allowed_cpus();
+  std::vector<unsigned> result;
+#if defined(MASTERMYR_HAVE_NUMA)
+  if (available()) {
+    bitmask* mask = ::numa_allocate_cpumask();
+    if (::numa_node_to_cpus(static_cast<int>(node), mask) == 0) {
+      for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (::numa_bitmask_isbitset(mask, cpu) && CPU_ISSET(cpu, &allowed)) {
+          result.push_back(cpu);
+        }
+      }
+    }
+    ::numa_free_cpumask(mask);
+    return result;
+  }
+#endif
+  if (node != 0) return result;
+  for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) result.push_back(cpu);
+  }
+  return result;
+}
+
+unsigned current_node() {
+#if defined(MASTERMYR_HAVE_NUMA)
+  if (nodes() > 1) {
+    const int cpu = ::sched_getcpu();
+    const int node = cpu < 0 ? -1 : ::numa_node_of_cpu(cpu);
+    if (node >= 0) return static_cast<unsigned>(node);
+  }
+#endif
+  return 0;
+}
+
+bool pin_to_cpu(unsigned cpu) {
+  if (cpu >= CPU_SETSIZE) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pin(set);
+}
+
+bool pin_to_node(unsigned node) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const unsigned cpu : cpus(node)) CPU_SET(cpu, &set);
+  return pin(set);
+}
+
+NodeBuffer::NodeBuffer(std::size_t bytes, unsigned node) : size_(bytes) {
+  if (bytes == 0) return;
+#if defined(MASTERMYR_HAVE_NUMA)
+  if (available()) {
+    data_ = static_cast<std::byte*>(
+        ::numa_alloc_onnode(bytes, static_cast<int>(node)));
+    if (data_ == nullptr) throw std::bad_alloc();
+    return;
+  }
+#endif
+  static_cast<void>(node);
+  data_ = static_cast<std::byte*>(::operator new(bytes, kAlignment));
+}
+
+NodeBuffer::~NodeBuffer() { free(); }
+
+NodeBuffer::NodeBuffer(NodeBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+NodeBuffer& NodeBuffer::operator=(NodeBuffer&& other) noexcept {
+  if (this != &other) {
+    free();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void NodeBuffer::free() {
+  if (data_ == nullptr) return;
+#if defined(MASTERMYR_HAVE_NUMA)
+  if (available()) {
+    ::numa_free(data_, size_);
+    data_ = nullptr;
+    return;
+  }
+#endif
+  ::operator delete(data_, kAlignment);
+  data_ = nullptr;
+}
+
+}  // namespace mastermyr::numa
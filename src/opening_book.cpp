@@ -0,0 +1,278 @@
+#include "mastermyr/opening_book.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace mastermyr {
+namespace {
+
+// States decoded per GameStateReader batch.
+constexpr std::size_t kIngestBatch = 4096;
+
+// A position waiting to be added to a book: its count and trie node, and
+// the book node and feedback rank of the slot it goes in.
+struct Pending {
+  std::uint64_t count;
+  HistoryCounts::NodeIndex position;
+  StrategyTree::NodeIndex parent;
+  std::uint32_t rank;
+
+  // Most frequent first, ties in the order the positions were counted, so
+  // the book does not depend on the queue's implementation.
+  friend bool operator<(const Pending& a, const Pending& b) {
+    return a.count != b.count ? a.count < b.count : a.position > b.position;
+  }
+};
+
+// Copies book node `index` and the nodes below it to `out` in depth-first
+// order, as compiled trees are laid out.
+StrategyTree::NodeIndex place(StrategyTree::NodeIndex index, unsigned level,
+                              std::size_t ranks,
+                              const StrategyTree::Subtree& in,
+                              StrategyTree::Subtree& out) {
+  using NodeIndex = StrategyTree::NodeIndex;
+  const auto at = static_cast<NodeIndex>(out.nodes.size());
+  out.nodes.push_back(in.nodes[index]);
+  out.depth = std::max(out.depth, level + 1);
+  const std::uint32_t first = in.nodes[index].children;
+  if (first == StrategyTree::kNone) return at;
+  const auto slots = static_cast<std::uint32_t>(out.children.size());
+  out.children.resize(slots + ranks, StrategyTree::kNone);
+  out.nodes[at].children = slots;
+  for (std::size_t r = 0; r < ranks; ++r) {
+    const NodeIndex child = in.children[first + r];
+    if (child == StrategyTree::kNone) continue;
+    const NodeIndex placed = place(child, level + 1, ranks, in, out);
+    out.children[slots + r] = placed;
+  }
+  return at;
+}
+
+}  // namespace
+
+std::size_t HistoryCounts::EdgeHash::operator()(const Edge& edge) const {
+  // Murmur3's finaliser over the packed fields.
+  std::uint64_t h = (std::uint64_t{edge.parent} << 32 | edge.guess) ^
+                    std::uint64_t{edge.feedback} * 0x9e3779b97f4a7c15ull;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h);
+}
+
+HistoryCounts::HistoryCounts(const BoardKey& key, unsigned max_depth,
+                             std::size_t max_states)
+    : key_(key),
+      max_depth_(max_depth),
+      max_states_(std::max<std::size_t>(max_states, 2)),
+      nodes_(1) {}
+
+void HistoryCounts::add(std::span<const Move> moves) {
+  ++games_;
+  ++nodes_[kRoot].count;
+  const Feedback solved = solved_feedback(key_.pegs);
+  const std::size_t depth = std::min<std::size_t>(moves.size(), max_depth_);
+  NodeIndex index = kRoot;
+  for (std::size_t i = 0; i < depth && moves[i].feedback != solved; ++i) {
+    index = child(index, moves[i]);
+    ++nodes_[index].count;
+  }
+  if (nodes_.size() > max_states_) prune();
+}
+
+bool HistoryCounts::add(const wire::GameStateView& game) {
+  if (game.pegs() != key_.pegs || game.colours() != key_.colours ||
+      !game.valid_moves()) {
+    ++skipped_;
+    return false;
+  }
+  std::array<Move, wire::kMaxMoves> moves;
+  for (std::size_t i = 0; i < game.size(); ++i) moves[i] = game[i];
+  add(std::span<const Move>(moves.data(), game.size()));
+  return true;
+}
+
+void HistoryCounts::ingest(std::istream& in) {
+  wire::GameStateReader reader(in);
+  while (true) {
+    const std::span<const wire::GameStateView> batch =
+        reader.next_batch(kIngestBatch);
+    if (batch.empty()) return;
+    for (const wire::GameStateView& game : batch) add(game);
+  }
+}
+
+HistoryCounts::NodeIndex HistoryCounts::find(
+    std::span<const Move> moves) const {
+  NodeIndex index = kRoot;
+  for (const Move& move : moves) {
+    const auto it = edges_.find(edge(index, move));
+    if (it == edges_.end()) return kNone;
+    index = it->second;
+  }
+  return index;
+}
+
+void HistoryCounts::history(NodeIndex index, std::vector<Move>& out) const {
+  out.clear();
+  for (; index != kRoot; index = nodes_[index].parent) {
+    out.push_back(nodes_[index].move);
+  }
+  std::reverse(out.begin(), out.end());
+}
+
+HistoryCounts::NodeIndex HistoryCounts::child(NodeIndex parent, Move move) {
+  const auto [it, added] = edges_.try_emplace(
+      edge(parent, move), static_cast<NodeIndex>(nodes_.size()));
+  if (added) {
+    Node node;
+    node.move = move;
+    node.parent = parent;
+    nodes_.push_back(node);
+    link(it->second);
+  }
+  return it->second;
+}
+
+void HistoryCounts::link(NodeIndex index) {
+  Node& node = nodes_[index];
+  node.next_sibling = nodes_[node.parent].first_child;
+  nodes_[node.parent].first_child = index;
+}
+
+void HistoryCounts::prune() {
+  // Keep the positions counted more often than the (max_states / 2)-th most
+  // frequent one, and the root.
+  const std::size_t keep = max_states_ / 2;
+  std::vector<std::uint64_t> counts(nodes_.size());
+  for (std::size_t i = 0; i < nodes_.size(); ++i) counts[i] = nodes_[i].count;
+  std::nth_element(counts.begin(), counts.begin() + keep, counts.end(),
+                   std::greater<>());
+  const std::uint64_t threshold = counts[keep];
+  error_ = std::max(error_, threshold);
+
+  std::vector<NodeIndex> renumbered(nodes_.size(), kNone);
+  std::vector<Node> kept;
+  kept.reserve(keep + 1);
+  for (std::size_t i = 0; i < nodes_.size(); ++i) {
+    if (i != kRoot && nodes_[i].count <= threshold) continue;
+    Node node = nodes_[i];
+    // A node's parent counts at least as often, so it was kept too.
+    node.parent = i == kRoot ? kNone : renumbered[node.parent];
+    node.first_child = kNone;
+    node.next_sibling = kNone;
+    renumbered[i] = static_cast<NodeIndex>(kept.size());
+    kept.push_back(node);
+  }
+  nodes_ = std::move(kept);
+  edges_.clear();
+  edges_.reserve(nodes_.size());
+  for (NodeIndex i = 1; i < nodes_.size(); ++i) {
+    edges_.emplace(edge(nodes_[i].parent, nodes_[i].move), i);
+    link(i);
+  }
+}
+
+StrategyTree build_opening_book(const HistoryCounts& counts,
+                                std::size_t states,
+                                const SolverOptions& options) {
+  using NodeIndex = StrategyTree::NodeIndex;
+  const BoardKey& key = counts.key();
+  const std::unique_ptr<GameSolver> solver =
+      make_solver(key.pegs, key.colours,
+                  key.duplicates == DuplicateRule::kForbidden
+                      ? Variant::kNoDuplicates
+                      : Variant::kMastermind,
+                  options);
+  const std::size_t ranks = feedback_ranks(key.pegs);
+
+  // Nodes in the order they are taken, relaid depth first at the end.
+  StrategyTree::Subtree taken;
+  std::priority_queue<Pending> queue;
+  queue.push(
+      {counts.node(HistoryCounts::kRoot).count, HistoryCounts::kRoot,
+       StrategyTree::kNone, 0});
+  std::vector<Move> moves;
+  while (!queue.empty() && taken.nodes.size() < states) {
+    const Pending next = queue.top();
+    queue.pop();
+    counts.history(next.position, moves);
+    solver->reset();
+    Code guess;
+    try {
+      for (const Move& move : moves) solver->record(move.guess, move.feedback);
+      guess = solver->next_guess();
+    } catch (const InconsistentFeedback&) {
+      continue;
+    }
+    const auto index = static_cast<NodeIndex>(taken.nodes.size());
+    taken.nodes.push_back({guess.bits(), StrategyTree::kNone,
+                           static_cast<std::uint32_t>(solver->remaining())});
+    if (next.parent != StrategyTree::kNone) {
+      StrategyTree::Node& parent = taken.nodes[next.parent];
+      if (parent.children == StrategyTree::kNone) {
+        parent.children = static_cast<std::uint32_t>(taken.children.size());
+        taken.children.resize(taken.children.size() + ranks,
+                              StrategyTree::kNone);
+      }
+      taken.children[parent.children + next.rank] = index;
+    }
+    for (HistoryCounts::NodeIndex c = counts.node(next.position).first_child;
+         c != HistoryCounts::kNone; c = counts.node(c).next_sibling) {
+      const HistoryCounts::Node& child = counts.node(c);
+      if (child.move.guess != guess) continue;
+      queue.push({child.count, c, index,
+                  static_cast<std::uint32_t>(
+                      feedback_rank(child.move.feedback, key.pegs))});
+    }
+  }
+  if (taken.nodes.empty()) {
+    throw std::invalid_argument("no consistent position to build a book of");
+  }
+  StrategyTree::Subtree book;
+  book.nodes.reserve(taken.nodes.size());
+  book.children.reserve(taken.children.size());
+  place(StrategyTree::kRoot, 0, ranks, taken, book);
+  return StrategyTree::partial(key, options.strategy, std::move(book));
+}
+
+double book_coverage(const StrategyTree& book, const HistoryCounts& counts) {
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    total += counts.node(static_cast<HistoryCounts::NodeIndex>(i)).count;
+  }
+  if (total == 0) return 0;
+  // Walks the trie along the book's guesses, the positions lookup() finds.
+  std::uint64_t covered = 0;
+  std::vector<std::pair<StrategyTree::NodeIndex, HistoryCounts::NodeIndex>>
+      stack = {{StrategyTree::kRoot, HistoryCounts::kRoot}};
+  while (!stack.empty()) {
+    const auto [node, position] = stack.back();
+    stack.pop_back();
+    covered += counts.node(position).count;
+    for (HistoryCounts::NodeIndex c = counts.node(position).first_child;
+         c != HistoryCounts::kNone; c = counts.node(c).next_sibling) {
+      const Move move = counts.node(c).move;
+      if (move.guess != book.guess(node)) continue;
+      const StrategyTree::NodeIndex next = book.child(node, move.feedback);
+      if (next != StrategyTree::kNone) stack.push_back({next, c});
+    }
+  }
+  return static_cast<double>(covered) / static_cast<double>(total);
+}
+
+std::string opening_book_name(const BoardKey& key, Strategy strategy) {
+  return "book-v" + std::to_string(StrategyTree::kFormatVersion) + "-" +
+         std::to_string(key.pegs) + "x" + std::to_string(key.colours) +
+         (key.duplicates == DuplicateRule::kAllowed ? "-dup-" : "-nodup-") +
+         strategy_name(strategy) + ".bin";
+}
+
+}  // namespace mastermyr
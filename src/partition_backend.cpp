@@ -0,0 +1,66 @@
+#include "mastermyr/partition_backend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "mastermyr/score.hpp"
+
+#if defined(MASTERMYR_HAVE_CUDA)
+#include "cuda_backend.hpp"
+#endif
+
+namespace mastermyr {
+namespace {
+
+class HostBackend final : public PartitionBackend {
+ public:
+  const char* name() const override { return "host"; }
+
+  void partitions(std::span<const Code> guesses,
+                  std::span<const Code> candidates, unsigned pegs,
+                  std::span<std::uint32_t> counts) override {
+    constexpr std::size_t kBlock = 1024;
+    const std::size_t slots = feedback_slots(pegs);
+    std::array<Feedback, kBlock> scores;
+    std::fill(counts.begin(), counts.end(), 0);
+    for (std::size_t g = 0; g < guesses.size(); ++g) {
+      std::uint32_t* histogram = counts.data() + g * slots;
+      for (std::size_t begin = 0; begin < candidates.size(); begin += kBlock) {
+        const std::size_t n = std::min(kBlock, candidates.size() - begin);
+        score_batch(guesses[g], candidates.data() + begin, n, scores.data(),
+                    pegs);
+        for (std::size_t j = 0; j < n; ++j) ++histogram[scores[j].raw()];
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::shared_ptr<PartitionBackend> detect_partition_backend() {
+#if defined(MASTERMYR_HAVE_CUDA)
+  return make_cuda_backend();
+#else
+  return nullptr;
+#endif
+}
+
+std::shared_ptr<PartitionBackend> make_host_backend() {
+  return std::make_shared<HostBackend>();
+}
+
+std::shared_ptr<PartitionBackend> make_partition_backend(
+    std::string_view name) {
+  if (name == "auto") return detect_partition_backend();
+  if (name == "cpu") return nullptr;
+  if (name == "host") return make_host_backend();
+  if (name == "cuda") {
+    if (auto backend = detect_partition_backend()) return backend;
+    throw std::invalid_argument("no CUDA device (or built without CUDA)");
+  }
+  throw std::invalid_argument("unknown backend '" + std::string(name) + "'");
+}
+
+}  // namespace mastermyr
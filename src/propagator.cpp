@@ -0,0 +1,234 @@
+#include "mastermyr/propagator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+#include "mastermyr/candidate_generator.hpp"
+
+namespace mastermyr {
+namespace {
+
+using Domain = Propagator::Domain;
+
+constexpr Domain colour_bit(unsigned colour) {
+  return static_cast<Domain>(1u << colour);
+}
+
+}  // namespace
+
+Propagator::Propagator(unsigned pegs, unsigned colours)
+    : pegs_(pegs), colours_(colours) {
+  if (pegs == 0 || pegs > kMaxPegs || colours < 2 || colours > kMaxColours) {
+    throw std::invalid_argument("no codes on a " + std::to_string(pegs) + "x" +
+                                std::to_string(colours) + " board");
+  }
+  reset();
+}
+
+void Propagator::reset() {
+  history_.clear();
+  const Domain all = static_cast<Domain>((1u << colours_) - 1);
+  domains_.fill(0);
+  std::fill_n(domains_.begin(), pegs_, all);
+  lo_.fill(0);
+  hi_.fill(0);
+  std::fill_n(hi_.begin(), colours_, static_cast<std::uint8_t>(pegs_));
+  consistent_ = true;
+}
+
+bool Propagator::add(Move move) {
+  if (!consistent_) return false;
+  history_.push_back(move);
+  if (move.feedback.black() + move.feedback.white() > pegs_) {
+    consistent_ = false;
+    return false;
+  }
+  consistent_ = propagate();
+  return consistent_;
+}
+
+bool Propagator::add(std::span<const Move> moves) {
+  for (const Move& move : moves) {
+    if (!add(move)) return false;
+  }
+  return consistent_;
+}
+
+bool Propagator::admits(Code code) const {
+  if ((code.bits() & ~peg_mask(pegs_)) != 0) return false;
+  std::array<std::uint8_t, kMaxColours> counts{};
+  for (unsigned i = 0; i < pegs_; ++i) {
+    const unsigned colour = code.peg(i);
+    if ((domains_[i] & colour_bit(colour)) == 0) return false;
+    ++counts[colour];
+  }
+  for (unsigned c = 0; c < colours_; ++c) {
+    if (counts[c] < lo_[c] || counts[c] > hi_[c]) return false;
+  }
+  return true;
+}
+
+bool Propagator::possible(Code secret) const {
+  if (!consistent_ || !admits(secret)) return false;
+  return std::all_of(history_.begin(), history_.end(), [&](const Move& move) {
+    return score(move.guess, secret, pegs_) == move.feedback;
+  });
+}
+
+bool Propagator::satisfiable() const {
+  if (!consistent_) return false;
+  CandidateGenerator generator(*this);
+  return generator.next().has_value();
+}
+
+double Propagator::space_size() const {
+  double size = 1;
+  for (unsigned i = 0; i < pegs_; ++i) size *= std::popcount(domains_[i]);
+  return size;
+}
+
+bool Propagator::propagate() {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const Move& move : history_) {
+      if (!propagate_blacks(move, changed) ||
+          !propagate_matches(move, changed)) {
+        return false;
+      }
+    }
+    if (!propagate_counts(changed)) return false;
+  }
+  return true;
+}
+
+bool Propagator::propagate_blacks(const Move& move, bool& changed) {
+  unsigned fixed = 0;
+  unsigned possible = 0;
+  for (unsigned i = 0; i < pegs_; ++i) {
+    const Domain bit = colour_bit(move.guess.peg(i));
+    possible += (domains_[i] & bit) != 0;
+    fixed += domains_[i] == bit;
+  }
+  const unsigned blacks = move.feedback.black();
+  if (blacks < fixed || blacks > possible) return false;
+  if (blacks == fixed && fixed < possible) {
+    // Every black is accounted for: no other peg matches the guess.
+    for (unsigned i = 0; i < pegs_; ++i) {
+      const Domain bit = colour_bit(move.guess.peg(i));
+      if (domains_[i] != bit &&
+          !restrict(i, static_cast<Domain>(~bit), changed)) {
+        return false;
+      }
+    }
+  } else if (blacks == possible && fixed < possible) {
+    // Every peg that can match the guess must.
+    for (unsigned i = 0; i < pegs_; ++i) {
+      const Domain bit = colour_bit(move.guess.peg(i));
+      if ((domains_[i] & bit) != 0 && !restrict(i, bit, changed)) return false;
+    }
+  }
+  return true;
+}
+
+bool Propagator::propagate_matches(const Move& move, bool& changed) {
+  std::array<unsigned, kMaxColours> counts{};
+  for (unsigned i = 0; i < pegs_; ++i) ++counts[move.guess.peg(i)];
+  // Matches that the colour bounds allow at most and force at least.
+  int most = 0;
+  int least = 0;
+  for (unsigned c = 0; c < colours_; ++c) {
+    most += static_cast<int>(std::min<unsigned>(counts[c], hi_[c]));
+    least += static_cast<int>(std::min<unsigned>(counts[c], lo_[c]));
+  }
+  const int total =
+      static_cast<int>(move.feedback.black() + move.feedback.white());
+  if (total > most || total < least) return false;
+  // Bounds tightened below leave `most` and `least` loose, never wrong.
+  for (unsigned c = 0; c < colours_; ++c) {
+    const int guessed = static_cast<int>(counts[c]);
+    if (guessed == 0) continue;
+    const int need =
+        total - (most - std::min(guessed, static_cast<int>(hi_[c])));
+    const int cap =
+        total - (least - std::min(guessed, static_cast<int>(lo_[c])));
+    if (need > guessed || cap < 0) return false;
+    if (need > lo_[c]) {
+      lo_[c] = static_cast<std::uint8_t>(need);
+      changed = true;
+    }
+    if (cap < guessed && cap < hi_[c]) {
+      hi_[c] = static_cast<std::uint8_t>(cap);
+      changed = true;
+    }
+    if (lo_[c] > hi_[c]) return false;
+  }
+  return true;
+}
+
+bool Propagator::propagate_counts(bool& changed) {
+  std::array<unsigned, kMaxColours> available{};
+  std::array<unsigned, kMaxColours> fixed{};
+  for (unsigned i = 0; i < pegs_; ++i) {
+    for (Domain d = domains_[i]; d != 0; d &= d - 1) {
+      ++available[std::countr_zero(d)];
+    }
+    if (std::has_single_bit(domains_[i])) {
+      ++fixed[std::countr_zero(domains_[i])];
+    }
+  }
+  unsigned sum_lo = 0;
+  for (unsigned c = 0; c < colours_; ++c) {
+    if (fixed[c] > lo_[c]) {
+      lo_[c] = static_cast<std::uint8_t>(fixed[c]);
+      changed = true;
+    }
+    if (available[c] < hi_[c]) {
+      hi_[c] = static_cast<std::uint8_t>(available[c]);
+      changed = true;
+    }
+    if (lo_[c] > hi_[c]) return false;
+    sum_lo += lo_[c];
+  }
+  if (sum_lo > pegs_) return false;
+  unsigned sum_hi = 0;
+  for (unsigned c = 0; c < colours_; ++c) {
+    // The other colours' minimums take their pegs first.
+    const unsigned cap = pegs_ - (sum_lo - lo_[c]);
+    if (cap < hi_[c]) {
+      hi_[c] = static_cast<std::uint8_t>(cap);
+      changed = true;
+    }
+    sum_hi += hi_[c];
+  }
+  if (sum_hi < pegs_) return false;
+  for (unsigned c = 0; c < colours_; ++c) {
+    const Domain bit = colour_bit(c);
+    if (hi_[c] == 0 && available[c] > 0) {
+      for (unsigned i = 0; i < pegs_; ++i) {
+        if (!restrict(i, static_cast<Domain>(~bit), changed)) return false;
+      }
+    } else if (lo_[c] == available[c] && fixed[c] < available[c]) {
+      // The colour needs every peg that can hold it.
+      for (unsigned i = 0; i < pegs_; ++i) {
+        if ((domains_[i] & bit) != 0 && !restrict(i, bit, changed)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool Propagator::restrict(unsigned peg, Domain domain, bool& changed) {
+  const Domain narrowed = domains_[peg] & domain;
+  if (narrowed == domains_[peg]) return true;
+  if (narrowed == 0) return false;
+  domains_[peg] = narrowed;
+  changed = true;
+  return true;
+}
+
+}  // namespace mastermyr
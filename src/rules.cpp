@@ -0,0 +1,26 @@
+#include "mastermyr/rules.hpp"
+
+namespace mastermyr {
+
+const char* variant_name(Variant variant) {
+  switch (variant) {
+    case Variant::kMastermind:
+      return "mastermind";
+    case Variant::kNoDuplicates:
+      return "no-duplicates";
+    case Variant::kStatic:
+      return "static";
+  }
+  return "unknown";
+}
+
+std::optional<Variant> parse_variant(std::string_view name) {
+  if (name == "bulls-and-cows") return Variant::kNoDuplicates;
+  for (const Variant v :
+       {Variant::kMastermind, Variant::kNoDuplicates, Variant::kStatic}) {
+    if (name == variant_name(v)) return v;
+  }
+  return std::nullopt;
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "mastermyr/candidate_generator.hpp"
+#include "mastermyr/hash.hpp"
+#include "mastermyr/propagator.hpp"
+#include "mastermyr/score.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr {
+namespace {
+
+// Descents drawn to tell a consistent set far past the sample budget, by
+// kPilotMargin times or more, from one that may fit it.
+constexpr std::size_t kPilotDraws = 1024;
+constexpr double kPilotMargin = 4;
+
+class SampledSolver final : public GameSolver {
+ public:
+  using Histogram = std::array<std::uint32_t, feedback_slots(kMaxPegs)>;
+
+  SampledSolver(unsigned pegs, unsigned colours, SolverOptions options)
+      : pegs_(pegs),
+        colours_(colours),
+        options_(std::move(options)),
+        solved_feedback_(solved_feedback(pegs)),
+        propagator_(check_board(pegs, colours), colours) {
+    options_.reservoir = std::max<std::size_t>(options_.reservoir, 1);
+    options_.sample_budget =
+        std::max(options_.sample_budget, options_.reservoir);
+    reservoir_.reserve(options_.reservoir);
+    reset();
+  }
+
+  unsigned pegs() const override { return pegs_; }
+  unsigned colours() const override { return colours_; }
+
+  void reset() override {
+    propagator_.reset();
+    reservoir_.clear();
+    remaining_ = code_count(pegs_, colours_);
+    sampled_ = false;
+  }
+
+  Code next_guess() override {
+    last_search_ = {};
+    if (propagator_.history().empty() && !options_.search_opening) {
+      return opening_guess();
+    }
+    if (!sampled_) sample();
+    if (reservoir_.empty()) throw InconsistentFeedback();
+    if (remaining_ <= 2) return reservoir_.front();
+    return best_guess();
+  }
+
+  void record(Code guess, Feedback feedback) override {
+    if (!propagator_.add({guess, feedback})) {
+      // Proven inconsistent: nothing to sample.
+      reservoir_.clear();
+      remaining_ = 0;
+      sampled_ = true;
+      return;
+    }
+    if (feedback == solved_feedback_) {
+      remaining_ = 1;
+      return;
+    }
+    sample();
+  }
+
+  bool solved() const override {
+    const std::span<const Move> history = propagator_.history();
+    return !history.empty() && history.back().feedback == solved_feedback_;
+  }
+  std::size_t remaining() const override { return remaining_; }
+  // Nothing per game comes from an arena; the reservoir is reused.
+  ArenaStats arena_stats() const override { return {}; }
+  SearchStats last_search() const override { return last_search_; }
+
+ private:
+  static unsigned check_board(unsigned pegs, unsigned colours) {
+    if (!is_valid_board(pegs, colours)) {
+      throw std::invalid_argument("no solver for a " + std::to_string(pegs) +
+                                  "x" + std::to_string(colours) + " board");
+    }
+    return pegs;
+  }
+
+  Code opening_guess() const {
+    Code code;
+    for (unsigned i = 0; i < pegs_; ++i) {
+      code = code.with_peg(i, (i / 2) % colours_);
+    }
+    return code;
+  }
+
+  // A consistent set of at most sample_budget codes is enumerated, with
+  // reservoir sampling (Algorithm R) over it, and counted exactly. A larger
+  // one is sampled by sample_budget / pegs random descents instead, and so
+  // is one that a pilot run of descents estimates at several times the
+  // budget, without the enumeration that would overflow anyway.
+  void sample() {
+    packed_.clear();
+    for (const Move& move : propagator_.history()) {
+      packed_.push_back(move.guess.bits() |
+                        std::uint64_t{move.feedback.raw()} << 32);
+    }
+    const std::uint64_t seed =
+        hash_bytes(packed_.data(), packed_.size() * sizeof(packed_[0])) | 1;
+    std::mt19937_64 rng(seed);
+    reservoir_.clear();
+    sampled_ = true;
+    CandidateGenerator descent(propagator_);
+    double pilot = 0;
+    for (std::size_t i = 0; i < kPilotDraws; ++i) {
+      double weight;
+      descent.draw(rng, weight);
+      pilot += weight;
+    }
+    if (pilot / kPilotDraws >=
+        kPilotMargin * static_cast<double>(options_.sample_budget)) {
+      draw_sample(descent, rng, 1);
+      return;
+    }
+
+    CandidateGenerator generator(propagator_, seed);
+    std::size_t seen = 0;
+    std::optional<Code> code;
+    while ((code = generator.next()) && seen < options_.sample_budget) {
+      ++seen;
+      if (reservoir_.size() < options_.reservoir) {
+        reservoir_.push_back(*code);
+      } else if (const std::size_t j = rng() % seen; j < reservoir_.size()) {
+        reservoir_[j] = *code;
+      }
+    }
+    if (!code) {
+      remaining_ = seen;
+      return;
+    }
+    draw_sample(descent, rng, options_.sample_budget + 1);
+  }
+
+  // Weighted reservoir sampling (Efraimidis-Spirakis) over random descents:
+  // each drawn code is kept with a key u^(1/weight), which undoes the
+  // descent's bias towards sparse subtrees, and a code drawn twice is kept
+  // once. remaining_ becomes the descents' estimate of the set's size,
+  // clamped to what is known: the set has at least `at_least` codes, and no
+  // move grows it.
+  void draw_sample(CandidateGenerator& descent, std::mt19937_64& rng,
+                   std::size_t at_least) {
+    std::uniform_real_distribution<double> uniform;
+    // Smallest key on top.
+    using Keyed = std::pair<double, std::uint32_t>;
+    std::priority_queue<Keyed, std::vector<Keyed>, std::greater<>> kept;
+    std::unordered_set<std::uint32_t> members;
+    double total = 0;
+    // A descent tries every colour of every peg, so it takes about as long
+    // as enumerating `pegs` codes.
+    const std::size_t draws =
+        std::max<std::size_t>(options_.sample_budget / pegs_, 1);
+    for (std::size_t i = 0; i < draws; ++i) {
+      double weight;
+      const std::optional<Code> code = descent.draw(rng, weight);
+      if (!code) continue;
+      total += weight;
+      // log(u) / weight orders the codes as u^(1/weight) does.
+      const double key = std::log(1 - uniform(rng)) / weight;
+      if (kept.size() == options_.reservoir && key <= kept.top().first) {
+        continue;
+      }
+      if (!members.insert(code->bits()).second) continue;
+      if (kept.size() == options_.reservoir) {
+        members.erase(kept.top().second);
+        kept.pop();
+      }
+      kept.push({key, code->bits()});
+    }
+    // Every descent ending in a dead end is all but impossible on a set
+    // this large; an enumerated sample, if any, stands in for one.
+    if (!kept.empty()) reservoir_.clear();
+    for (; !kept.empty(); kept.pop()) reservoir_.emplace_back(kept.top().second);
+    // Key order follows the weights; best_guess() wants a random order.
+    std::shuffle(reservoir_.begin(), reservoir_.end(), rng);
+    const auto estimate = static_cast<std::size_t>(
+        total / static_cast<double>(draws));
+    remaining_ = std::min(
+        remaining_, std::max({estimate, at_least, reservoir_.size()}));
+  }
+
+  // Rates the first max_guesses sampled codes by how they split the sample.
+  // The reservoir is in random order, so with a time budget the guesses
+  // rated before it runs out are a uniform sample of those.
+  Code best_guess() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    const bool anytime = options_.time_budget.count() != 0;
+    const Clock::time_point deadline = start + options_.time_budget;
+    const std::size_t n = reservoir_.size();
+    const std::size_t guesses = std::min(n, options_.max_guesses);
+    ThreadPool* pool = options_.pool.get();
+    const unsigned participants = pool ? pool->concurrency() : 1;
+    std::vector<GuessChoice> best(participants);
+    std::vector<std::size_t> visited(participants);
+    std::atomic<bool> expired{false};
+    std::vector<std::vector<Feedback>> scores(participants,
+                                              std::vector<Feedback>(n));
+    auto body = [&](std::size_t begin, std::size_t end, unsigned participant) {
+      std::vector<Feedback>& out = scores[participant];
+      for (std::size_t i = begin; i < end; ++i) {
+        // The first guess is always rated.
+        if (anytime && i != 0 &&
+            (expired.load(std::memory_order_relaxed) ||
+             Clock::now() >= deadline)) {
+          expired.store(true, std::memory_order_relaxed);
+          return;
+        }
+        ++visited[participant];
+        score_batch(reservoir_[i], reservoir_.data(), n, out.data(), pegs_);
+        Histogram histogram{};
+        for (const Feedback f : out) ++histogram[f.raw()];
+        GuessChoice choice;
+        choice.guess = reservoir_[i];
+        choice.cost = partition_cost(options_.strategy, histogram, n);
+        choice.is_candidate = true;
+        choice.index = i;
+        if (better_choice(choice, best[participant])) best[participant] = choice;
+      }
+    };
+    if (pool != nullptr) {
+      pool->parallel_for(guesses, 8, body);
+    } else {
+      body(0, guesses, 0);
+    }
+    GuessChoice result;
+    for (unsigned p = 0; p < participants; ++p) {
+      if (better_choice(best[p], result)) result = best[p];
+      last_search_.visited += visited[p];
+    }
+    last_search_.space = guesses;
+    last_search_.cost = result.cost;
+    last_search_.bound =
+        partition_cost_bound(options_.strategy, n, feedback_ranks(pegs_) - 1);
+    last_search_.elapsed = Clock::now() - start;
+    return result.guess;
+  }
+
+  unsigned pegs_;
+  unsigned colours_;
+  SolverOptions options_;
+  Feedback solved_feedback_;
+  Propagator propagator_;  // the history and its propagated domains
+  std::vector<std::uint64_t> packed_;  // the history, hashed for the seed
+  std::vector<Code> reservoir_;
+  std::size_t remaining_ = 0;
+  bool sampled_ = false;
+  SearchStats last_search_;
+};
+
+}  // namespace
+
+std::unique_ptr<GameSolver> make_sampled_solver(unsigned pegs,
+                                                unsigned colours,
+                                                SolverOptions options) {
+  return std::make_unique<SampledSolver>(pegs, colours, std::move(options));
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,186 @@
+#include "mastermyr/score.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#include "mastermyr/metrics.hpp"
+#include "score_kernels.hpp"
+
+#if defined(MASTERMYR_HAVE_NEON)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+// All kernels use the same word-parallel formulation. A peg matches when the
+// nibble of (a ^ b) is zero, and the nibble-zero test is done for all pegs at
+// once with the usual carry trick: bit 3 of ((x & 0x7..7) + 0x7..7) | x is set
+// iff the nibble is non-zero. Summing the resulting flags is a multiply by
+// 0x11111111 that gathers every nibble into the top one.
+//
+//   black = #zero nibbles of guess ^ candidate
+//   total = sum over distinct guess colours k of
+//           min(count of k in guess, #zero nibbles of candidate ^ kkkk...)
+//
+// The guess colours and counts are hoisted out of the candidate loop, so the
+// per-candidate cost is a handful of ALU ops per distinct guess colour with no
+// table lookups, and the vector versions (score_avx2.cpp, score_avx512.cpp,
+// score_neon.cpp) are the same expressions on 8, 16 or 4 lanes.
+
+namespace mastermyr {
+namespace kernels {
+namespace {
+
+inline std::uint32_t zero_nibbles(std::uint32_t x, std::uint32_t high_mask) {
+  const std::uint32_t flags = ~(((x & kLow3) + kLow3) | x) & high_mask;
+  return ((flags >> 3) * kGather) >> 28;
+}
+
+inline std::uint8_t score_one(const GuessProfile& p, std::uint32_t c) {
+  const std::uint32_t black = zero_nibbles(p.bits ^ c, p.high_mask);
+  std::uint32_t total = 0;
+  for (unsigned k = 0; k < p.distinct; ++k) {
+    total += std::min(zero_nibbles(c ^ p.splat[k], p.high_mask), p.count[k]);
+  }
+  return static_cast<std::uint8_t>(black << 4 | (total - black));
+}
+
+}  // namespace
+
+GuessProfile profile_guess(Code guess, unsigned pegs) {
+  GuessProfile p{};
+  p.bits = guess.bits();
+  p.high_mask = peg_mask(pegs) & kHigh;
+  std::array<std::uint32_t, kMaxColours> counts{};
+  for (unsigned i = 0; i < pegs; ++i) ++counts[guess.peg(i)];
+  for (unsigned c = 0; c < kMaxColours; ++c) {
+    if (counts[c] == 0) continue;
+    p.splat[p.distinct] = c * kGather;
+    p.count[p.distinct] = counts[c];
+    ++p.distinct;
+  }
+  return p;
+}
+
+void score_tail(const GuessProfile& p, const Code* candidates,
+                std::size_t count, Feedback* out) {
+  for (std::size_t i = 0; i < count; ++i) {
+    out[i] = Feedback(score_one(p, candidates[i].bits()));
+  }
+}
+
+void score_batch_scalar(Code guess, const Code* candidates, std::size_t count,
+                        Feedback* out, unsigned pegs) {
+  score_tail(profile_guess(guess, pegs), candidates, count, out);
+}
+
+}  // namespace kernels
+
+namespace {
+
+using Kernel = void (*)(Code, const Code*, std::size_t, Feedback*, unsigned);
+
+// Widest first.
+constexpr std::array kIsas = {Isa::kAvx512, Isa::kAvx2, Isa::kNeon,
+                              Isa::kScalar};
+
+Kernel kernel_for(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return kernels::score_batch_scalar;
+    case Isa::kAvx2:
+#if defined(MASTERMYR_HAVE_AVX2)
+      return kernels::score_batch_avx2;
+#else
+      break;
+#endif
+    case Isa::kAvx512:
+#if defined(MASTERMYR_HAVE_AVX512)
+      return kernels::score_batch_avx512;
+#else
+      break;
+#endif
+    case Isa::kNeon:
+#if defined(MASTERMYR_HAVE_NEON)
+      return kernels::score_batch_neon;
+#else
+      break;
+#endif
+  }
+  return nullptr;
+}
+
+struct Dispatch {
+  Isa isa;
+  Kernel kernel;
+};
+
+Dispatch select_kernel() {
+  if (const char* name = std::getenv("MASTERMYR_ISA"); name && *name) {
+    for (const Isa isa : kIsas) {
+      if (std::string_view(name) == isa_name(isa) && isa_supported(isa)) {
+        return {isa, kernel_for(isa)};
+      }
+    }
+  }
+  for (const Isa isa : kIsas) {
+    if (isa_supported(isa)) return {isa, kernel_for(isa)};
+  }
+  return {Isa::kScalar, kernels::score_batch_scalar};
+}
+
+const Dispatch& dispatch() {
+  static const Dispatch selected = select_kernel();
+  return selected;
+}
+
+}  // namespace
+
+const char* isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return "scalar";
+    case Isa::kAvx2:
+      return "avx2";
+    case Isa::kAvx512:
+      return "avx512";
+    case Isa::kNeon:
+      return "neon";
+  }
+  return "unknown";
+}
+
+bool isa_supported(Isa isa) {
+  if (kernel_for(isa) == nullptr) return false;
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+#if defined(MASTERMYR_HAVE_AVX2) || defined(MASTERMYR_HAVE_AVX512)
+    case Isa::kAvx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    case Isa::kAvx512:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f");
+#endif
+#if defined(MASTERMYR_HAVE_NEON)
+    case Isa::kNeon:
+      return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#endif
+    default:
+      return false;
+  }
+}
+
+Isa active_isa() { return dispatch().isa; }
+
+void score_batch(Code guess, const Code* candidates, std::size_t count,
+                 Feedback* out, unsigned pegs) {
+  const metrics::ScopedTimer timer(metrics::Phase::kScore);
+  metrics::add(metrics::Counter::kCodesScored, count);
+  dispatch().kernel(guess, candidates, count, out, pegs);
+}
+
+}  // namespace mastermyr
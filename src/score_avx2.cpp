@@ -0,0 +1,78 @@
+// Compiled with -mavx2; see score_kernels.hpp for what may be shared with
+// the rest of the library.
+#include <immintrin.h>
+
+#include "score_kernels.hpp"
+
+namespace mastermyr::kernels {
+namespace {
+
+struct Avx2Profile {
+  __m256i guess, high_mask, low3, gather;
+  unsigned distinct;
+  __m256i splat[kMaxPegs], count[kMaxPegs];
+
+  explicit Avx2Profile(const GuessProfile& p)
+      : guess(_mm256_set1_epi32(static_cast<int>(p.bits))),
+        high_mask(_mm256_set1_epi32(static_cast<int>(p.high_mask))),
+        low3(_mm256_set1_epi32(static_cast<int>(kLow3))),
+        gather(_mm256_set1_epi32(static_cast<int>(kGather))),
+        distinct(p.distinct) {
+    for (unsigned k = 0; k < distinct; ++k) {
+      splat[k] = _mm256_set1_epi32(static_cast<int>(p.splat[k]));
+      count[k] = _mm256_set1_epi32(static_cast<int>(p.count[k]));
+    }
+  }
+
+  __m256i zero_nibbles(__m256i x) const {
+    const __m256i t =
+        _mm256_or_si256(_mm256_add_epi32(_mm256_and_si256(x, low3), low3), x);
+    const __m256i flags = _mm256_andnot_si256(t, high_mask);
+    return _mm256_srli_epi32(
+        _mm256_mullo_epi32(_mm256_srli_epi32(flags, 3), gather), 28);
+  }
+
+  __m256i score(__m256i c) const {
+    const __m256i black = zero_nibbles(_mm256_xor_si256(c, guess));
+    __m256i total = _mm256_setzero_si256();
+    for (unsigned k = 0; k < distinct; ++k) {
+      const __m256i n = zero_nibbles(_mm256_xor_si256(c, splat[k]));
+      total = _mm256_add_epi32(total, _mm256_min_epu32(n, count[k]));
+    }
+    return _mm256_or_si256(_mm256_slli_epi32(black, 4),
+                           _mm256_sub_epi32(total, black));
+  }
+};
+
+}  // namespace
+
+// 32 candidates per iteration: four 8-lane score vectors narrowed to bytes.
+void score_batch_avx2(Code guess, const Code* candidates, std::size_t count,
+                      Feedback* out, unsigned pegs) {
+  const GuessProfile p = profile_guess(guess, pegs);
+  const Avx2Profile v(p);
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  std::size_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    const auto* src = reinterpret_cast<const __m256i*>(candidates + i);
+    const __m256i a = v.score(_mm256_loadu_si256(src + 0));
+    const __m256i b = v.score(_mm256_loadu_si256(src + 1));
+    const __m256i c = v.score(_mm256_loadu_si256(src + 2));
+    const __m256i d = v.score(_mm256_loadu_si256(src + 3));
+    const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(a, b),
+                                              _mm256_packus_epi32(c, d));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_permutevar8x32_epi32(bytes, order));
+  }
+  for (; i + 8 <= count; i += 8) {
+    const __m256i s = v.score(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(candidates + i)));
+    const __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(s),
+                                           _mm256_extracti128_si256(s, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi16(words, words));
+  }
+  score_tail(p, candidates + i, count - i, out + i);
+}
+
+}  // namespace mastermyr::kernels
@@ -0,0 +1,74 @@
+// Compiled with -mavx512f; see score_kernels.hpp for what may be shared with
+// the rest of the library.
+
+// GCC 12 flags the _mm*_undefined_* placeholders inside the AVX-512
+// narrowing intrinsics as maybe-uninitialized.
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+
+#include "score_kernels.hpp"
+
+namespace mastermyr::kernels {
+namespace {
+
+struct Avx512Profile {
+  __m512i guess, high_mask, low3, gather;
+  unsigned distinct;
+  __m512i splat[kMaxPegs], count[kMaxPegs];
+
+  explicit Avx512Profile(const GuessProfile& p)
+      : guess(_mm512_set1_epi32(static_cast<int>(p.bits))),
+        high_mask(_mm512_set1_epi32(static_cast<int>(p.high_mask))),
+        low3(_mm512_set1_epi32(static_cast<int>(kLow3))),
+        gather(_mm512_set1_epi32(static_cast<int>(kGather))),
+        distinct(p.distinct) {
+    for (unsigned k = 0; k < distinct; ++k) {
+      splat[k] = _mm512_set1_epi32(static_cast<int>(p.splat[k]));
+      count[k] = _mm512_set1_epi32(static_cast<int>(p.count[k]));
+    }
+  }
+
+  __m512i zero_nibbles(__m512i x) const {
+    const __m512i t =
+        _mm512_or_si512(_mm512_add_epi32(_mm512_and_si512(x, low3), low3), x);
+    const __m512i flags = _mm512_andnot_si512(t, high_mask);
+    return _mm512_srli_epi32(
+        _mm512_mullo_epi32(_mm512_srli_epi32(flags, 3), gather), 28);
+  }
+
+  __m512i score(__m512i c) const {
+    const __m512i black = zero_nibbles(_mm512_xor_si512(c, guess));
+    __m512i total = _mm512_setzero_si512();
+    for (unsigned k = 0; k < distinct; ++k) {
+      const __m512i n = zero_nibbles(_mm512_xor_si512(c, splat[k]));
+      total = _mm512_add_epi32(total, _mm512_min_epu32(n, count[k]));
+    }
+    return _mm512_or_si512(_mm512_slli_epi32(black, 4),
+                           _mm512_sub_epi32(total, black));
+  }
+};
+
+}  // namespace
+
+// 64 candidates per iteration: four 16-lane score vectors narrowed to bytes.
+void score_batch_avx512(Code guess, const Code* candidates, std::size_t count,
+                        Feedback* out, unsigned pegs) {
+  const GuessProfile p = profile_guess(guess, pegs);
+  const Avx512Profile v(p);
+  std::size_t i = 0;
+  for (; i + 64 <= count; i += 64) {
+    for (std::size_t j = 0; j < 64; j += 16) {
+      const __m512i s = v.score(_mm512_loadu_si512(candidates + i + j));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + j),
+                       _mm512_cvtepi32_epi8(s));
+    }
+  }
+  for (; i + 16 <= count; i += 16) {
+    const __m512i s = v.score(_mm512_loadu_si512(candidates + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm512_cvtepi32_epi8(s));
+  }
+  score_tail(p, candidates + i, count - i, out + i);
+}
+
+}  // namespace mastermyr::kernels
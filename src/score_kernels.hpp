@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mastermyr/score.hpp"
+
+// Shared by the per-ISA kernel files, which are compiled with their own
+// -m flags. Everything they share is declared here and defined in score.cpp
+// at the baseline ISA: an inline function instantiated in an AVX-512 file
+// could otherwise be the copy the linker keeps for every caller.
+
+namespace mastermyr::kernels {
+
+inline constexpr std::uint32_t kLow3 = 0x77777777u;
+inline constexpr std::uint32_t kHigh = 0x88888888u;
+inline constexpr std::uint32_t kGather = 0x11111111u;
+
+struct GuessProfile {
+  std::uint32_t bits;
+  std::uint32_t high_mask;
+  unsigned distinct;
+  // Plain arrays, not std::array: its members would be such inline functions.
+  std::uint32_t splat[kMaxPegs];
+  std::uint32_t count[kMaxPegs];
+};
+
+GuessProfile profile_guess(Code guess, unsigned pegs);
+
+// Scalar scoring of the candidates a vector loop leaves over.
+void score_tail(const GuessProfile& p, const Code* candidates,
+                std::size_t count, Feedback* out);
+
+}  // namespace mastermyr::kernels
@@ -0,0 +1,69 @@
+// Advanced SIMD is part of the AArch64 baseline, so this file needs no flags
+// of its own; it is only built for that architecture.
+#include <arm_neon.h>
+
+#include "score_kernels.hpp"
+
+namespace mastermyr::kernels {
+namespace {
+
+struct NeonProfile {
+  uint32x4_t guess, high_mask, low3, gather;
+  unsigned distinct;
+  uint32x4_t splat[kMaxPegs], count[kMaxPegs];
+
+  explicit NeonProfile(const GuessProfile& p)
+      : guess(vdupq_n_u32(p.bits)),
+        high_mask(vdupq_n_u32(p.high_mask)),
+        low3(vdupq_n_u32(kLow3)),
+        gather(vdupq_n_u32(kGather)),
+        distinct(p.distinct) {
+    for (unsigned k = 0; k < distinct; ++k) {
+      splat[k] = vdupq_n_u32(p.splat[k]);
+      count[k] = vdupq_n_u32(p.count[k]);
+    }
+  }
+
+  uint32x4_t zero_nibbles(uint32x4_t x) const {
+    const uint32x4_t t = vorrq_u32(vaddq_u32(vandq_u32(x, low3), low3), x);
+    const uint32x4_t flags = vbicq_u32(high_mask, t);
+    return vshrq_n_u32(vmulq_u32(vshrq_n_u32(flags, 3), gather), 28);
+  }
+
+  uint32x4_t score(uint32x4_t c) const {
+    const uint32x4_t black = zero_nibbles(veorq_u32(c, guess));
+    uint32x4_t total = vdupq_n_u32(0);
+    for (unsigned k = 0; k < distinct; ++k) {
+      const uint32x4_t n = zero_nibbles(veorq_u32(c, splat[k]));
+      total = vaddq_u32(total, vminq_u32(n, count[k]));
+    }
+    return vorrq_u32(vshlq_n_u32(black, 4), vsubq_u32(total, black));
+  }
+
+  // Scores four vectors and narrows them to 16 feedback bytes.
+  uint8x16_t score16(const Code* candidates) const {
+    const auto* src = reinterpret_cast<const std::uint32_t*>(candidates);
+    const uint16x8_t lo = vcombine_u16(vmovn_u32(score(vld1q_u32(src))),
+                                       vmovn_u32(score(vld1q_u32(src + 4))));
+    const uint16x8_t hi = vcombine_u16(vmovn_u32(score(vld1q_u32(src + 8))),
+                                       vmovn_u32(score(vld1q_u32(src + 12))));
+    return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+  }
+};
+
+}  // namespace
+
+// 16 candidates per iteration: four 4-lane score vectors narrowed to bytes.
+void score_batch_neon(Code guess, const Code* candidates, std::size_t count,
+                      Feedback* out, unsigned pegs) {
+  const GuessProfile p = profile_guess(guess, pegs);
+  const NeonProfile v(p);
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    vst1q_u8(reinterpret_cast<std::uint8_t*>(out + i),
+             v.score16(candidates + i));
+  }
+  score_tail(p, candidates + i, count - i, out + i);
+}
+
+}  // namespace mastermyr::kernels
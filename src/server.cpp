@@ -0,0 +1,573 @@
+#include "mastermyr/server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "mastermyr/metrics.hpp"
+#include "mastermyr/numa.hpp"
+#include "mastermyr/propagator.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr std::size_t kReadChunk = std::size_t{64} << 10;
+// Unsent output at which a connection stops being read.
+constexpr std::size_t kMaxOutput = std::size_t{1} << 20;
+constexpr int kMaxEvents = 256;
+
+using AnswerFrame = std::array<std::byte, wire::kAnswerFrame>;
+
+[[noreturn]] void throw_errno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+int listen_on(const ServerOptions& options, std::uint16_t port) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  if (::inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+    throw std::invalid_argument("not an IPv4 address: " + options.host);
+  }
+  const int fd =
+      ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw_errno("socket");
+  const int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0 ||
+      ::bind(fd, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(fd, options.backlog) != 0) {
+    const int error = errno;
+    ::close(fd);
+    errno = error;
+    throw_errno("listen on " + options.host + ":" + std::to_string(port));
+  }
+  return fd;
+}
+
+// False when propagation proves that no code fits the state's moves.
+bool history_consistent(const wire::GameStateView& state) {
+  Propagator propagator(state.pegs(), state.colours());
+  for (std::size_t i = 0; i < state.size(); ++i) {
+    if (!propagator.add(state[i])) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+// One event loop: a listener, an eventfd for completions and stop requests,
+// and the connections it accepted. Connection state is only touched on the
+// loop's own thread; pool tasks hand results over through post().
+class Server::Loop {
+ public:
+  static constexpr unsigned kAnyNode = ~0u;
+
+  Loop(Server& server, int listen_fd, unsigned node)
+      : server_(server), listen_fd_(listen_fd), node_(node) {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) throw_errno("epoll/eventfd");
+    watch(listen_fd_, EPOLLIN, &listen_fd_);
+    watch(wake_fd_, EPOLLIN, &wake_fd_);
+  }
+
+  ~Loop() {
+    for (auto& [fd, connection] : connections_) ::close(fd);
+    ::close(listen_fd_);
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+  }
+
+  void run() {
+    if (node_ != kAnyNode) numa::pin_to_node(node_);
+    std::array<epoll_event, kMaxEvents> events;
+    while (!stopping_.load(std::memory_order_acquire)) {
+      const int n = ::epoll_wait(epoll_fd_, events.data(), kMaxEvents, -1);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        throw_errno("epoll_wait");
+      }
+      for (int i = 0; i < n; ++i) {
+        void* tag = events[i].data.ptr;
+        if (tag == &listen_fd_) {
+          accept_all();
+        } else if (tag == &wake_fd_) {
+          drain_completions();
+        } else {
+          on_ready(*static_cast<Connection*>(tag), events[i].events);
+        }
+      }
+      flush_dirty();
+    }
+  }
+
+  void stop() {
+    stopping_.store(true, std::memory_order_release);
+    wake();
+  }
+
+ private:
+  struct Pending {
+    bool ready = false;
+    AnswerFrame frame;
+    // The body of a stats reply, sent instead of `frame` when not empty.
+    std::string stats;
+  };
+
+  struct Connection {
+    int fd = -1;
+    std::vector<std::byte> in;
+    std::size_t in_size = 0;
+    std::vector<std::byte> out;
+    std::size_t out_sent = 0;
+    // Responses not yet written, in request order; front() is base_seq.
+    std::deque<Pending> pending;
+    std::uint64_t base_seq = 0;
+    std::uint64_t next_seq = 0;
+    bool dirty = false;
+    // Reading stopped until the backlog of responses drains.
+    bool throttled = false;
+    // The peer shut down its side; closed once every response is out.
+    bool eof = false;
+  };
+
+  struct Completion {
+    std::shared_ptr<Connection> connection;
+    std::uint64_t seq;
+    AnswerFrame frame;
+  };
+
+ public:
+  // Called from pool threads.
+  void post(Completion completion) {
+    bool was_empty;
+    {
+      std::lock_guard lock(completions_mutex_);
+      was_empty = completions_.empty();
+      completions_.push_back(std::move(completion));
+    }
+    if (was_empty) wake();
+  }
+
+ private:
+  void watch(int fd, std::uint32_t events, void* tag) {
+    epoll_event event{};
+    event.events = events;
+    event.data.ptr = tag;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      throw_errno("epoll_ctl");
+    }
+  }
+
+  void wake() {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto n = ::write(wake_fd_, &one, sizeof(one));
+  }
+
+  void accept_all() {
+    while (true) {
+      const int fd =
+          ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) return;  // EAGAIN, or an aborted connection
+      const int on = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      auto connection = std::make_shared<Connection>();
+      connection->fd = fd;
+      connection->in.resize(kReadChunk);
+      watch(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, connection.get());
+      connections_.emplace(fd, std::move(connection));
+    }
+  }
+
+  void on_ready(Connection& connection, std::uint32_t events) {
+    // Closing drops the map's reference, which may be the last one.
+    const std::shared_ptr<Connection> keep = connections_.at(connection.fd);
+    if (events & (EPOLLERR | EPOLLHUP)) {
+      close(connection);
+      return;
+    }
+    if (events & EPOLLIN) read_all(connection);
+    if (connection.fd >= 0 && (events & EPOLLOUT)) write_out(connection);
+  }
+
+  // True while the connection has more responses outstanding than it may
+  // have; it is not read until they drain.
+  bool backlogged(const Connection& connection) const {
+    return connection.pending.size() >=
+               std::max<std::size_t>(server_.options_.max_pipelined, 1) ||
+           connection.out.size() - connection.out_sent >= kMaxOutput;
+  }
+
+  void read_all(Connection& connection) {
+    while (connection.fd >= 0 && !connection.eof) {
+      if (backlogged(connection)) {
+        connection.throttled = true;
+        return;
+      }
+      std::vector<std::byte>& in = connection.in;
+      if (in.size() - connection.in_size < kReadChunk / 2) {
+        in.resize(in.size() * 2);
+      }
+      ssize_t n;
+      {
+        const metrics::ScopedTimer timer(metrics::Phase::kIo);
+        n = ::read(connection.fd, in.data() + connection.in_size,
+                   in.size() - connection.in_size);
+      }
+      if (n == 0) {
+        end_input(connection);
+        return;
+      }
+      if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        close(connection);
+        return;
+      }
+      if (n < 0) {
+        if (errno == EAGAIN) break;
+        continue;
+      }
+      metrics::add(metrics::Counter::kBytesRead, static_cast<std::size_t>(n));
+      connection.in_size += static_cast<std::size_t>(n);
+      parse(connection);
+    }
+  }
+
+  // Dispatches the complete frames in the input buffer, up to the backlog
+  // limit; the rest wait there for resume().
+  void parse(Connection& connection) {
+    wire::FrameReader frames({connection.in.data(), connection.in_size},
+                             wire::kMaxStateBody);
+    std::span<const std::byte> body;
+    wire::FrameReader::Result result = wire::FrameReader::Result::kFrame;
+    while (!backlogged(connection) &&
+           (result = frames.next(body)) == wire::FrameReader::Result::kFrame) {
+      dispatch(connection, body);
+    }
+    if (result == wire::FrameReader::Result::kOversized) {
+      close(connection);
+      return;
+    }
+    std::memmove(connection.in.data(), connection.in.data() + frames.consumed(),
+                 connection.in_size - frames.consumed());
+    connection.in_size -= frames.consumed();
+  }
+
+  void dispatch(Connection& connection, std::span<const std::byte> body) {
+    const std::uint64_t seq = connection.next_seq++;
+    Pending& pending = connection.pending.emplace_back();
+    if (body.empty()) {
+      // A stats request, answered in line without the pool.
+      pending.ready = true;
+      pending.stats = server_.stats();
+      mark_dirty(connections_.at(connection.fd));
+      return;
+    }
+    std::shared_ptr<Connection> shared = connections_.at(connection.fd);
+    server_.inflight_.fetch_add(1, std::memory_order_relaxed);
+    auto task = [this, shared = std::move(shared), seq,
+                 request = std::vector<std::byte>(body.begin(), body.end())] {
+      Completion completion{shared, seq, {}};
+      server_.solve(request, completion.frame.data());
+      post(std::move(completion));
+      if (server_.inflight_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        server_.inflight_.notify_all();
+      }
+    };
+    if (node_ == kAnyNode) {
+      server_.pool_->submit(std::move(task));
+    } else {
+      server_.pool_->submit(std::move(task), node_);
+    }
+  }
+
+  void drain_completions() {
+    std::uint64_t count;
+    [[maybe_unused]] const auto n = ::read(wake_fd_, &count, sizeof(count));
+    {
+      std::lock_guard lock(completions_mutex_);
+      std::swap(completions_, draining_);
+    }
+    for (Completion& completion : draining_) {
+      Connection& connection = *completion.connection;
+      if (connection.fd < 0) continue;
+      Pending& pending = connection.pending[completion.seq - connection.base_seq];
+      pending.ready = true;
+      pending.frame = completion.frame;
+      mark_dirty(std::move(completion.connection));
+    }
+    draining_.clear();
+  }
+
+  void mark_dirty(std::shared_ptr<Connection> connection) {
+    if (!connection->dirty) {
+      connection->dirty = true;
+      dirty_.push_back(std::move(connection));
+    }
+  }
+
+  // The peer half-closed: stop reading, and close once the responses to
+  // what it sent are out.
+  void end_input(Connection& connection) {
+    connection.eof = true;
+    epoll_event event{};
+    event.events = EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = &connection;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+    if (connection.pending.empty() && connection.out.empty()) {
+      close(connection);
+    }
+  }
+
+  // Called once the output buffer is written out: reads on where the
+  // backlog limit stopped, or closes a connection whose peer is done.
+  void resume(Connection& connection) {
+    if (connection.throttled && !backlogged(connection)) {
+      connection.throttled = false;
+      parse(connection);
+      read_all(connection);
+    }
+    if (connection.fd >= 0 && connection.eof && !connection.throttled &&
+        connection.pending.empty() && connection.out.empty()) {
+      close(connection);
+    }
+  }
+
+  // Moves every response whose predecessors are done to the output buffer
+  // and writes them out, one write per connection per loop iteration.
+  // Resuming a connection can dispatch stats requests, which dirty it again.
+  void flush_dirty() {
+    while (!dirty_.empty()) {
+      std::swap(dirty_, flushing_);
+      flush(flushing_);
+      flushing_.clear();
+    }
+  }
+
+  void flush(const std::vector<std::shared_ptr<Connection>>& dirty) {
+    for (const std::shared_ptr<Connection>& connection : dirty) {
+      connection->dirty = false;
+      if (connection->fd < 0) continue;
+      while (!connection->pending.empty() && connection->pending.front().ready) {
+        const Pending& pending = connection->pending.front();
+        std::vector<std::byte>& out = connection->out;
+        if (pending.stats.empty()) {
+          out.insert(out.end(), pending.frame.begin(), pending.frame.end());
+        } else {
+          const auto length = static_cast<std::uint32_t>(pending.stats.size());
+          const auto* prefix = reinterpret_cast<const std::byte*>(&length);
+          const auto* text =
+              reinterpret_cast<const std::byte*>(pending.stats.data());
+          out.insert(out.end(), prefix, prefix + sizeof(length));
+          out.insert(out.end(), text, text + pending.stats.size());
+        }
+        connection->pending.pop_front();
+        ++connection->base_seq;
+      }
+      write_out(*connection);
+    }
+  }
+
+  void write_out(Connection& connection) {
+    while (connection.out_sent < connection.out.size()) {
+      ssize_t n;
+      {
+        const metrics::ScopedTimer timer(metrics::Phase::kIo);
+        n = ::send(connection.fd, connection.out.data() + connection.out_sent,
+                   connection.out.size() - connection.out_sent, MSG_NOSIGNAL);
+      }
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) close(connection);
+        return;  // EPOLLOUT resumes the write
+      }
+      metrics::add(metrics::Counter::kBytesWritten,
+                   static_cast<std::size_t>(n));
+      connection.out_sent += static_cast<std::size_t>(n);
+    }
+    connection.out.clear();
+    connection.out_sent = 0;
+    resume(connection);
+  }
+
+  // Tasks still running for the connection keep it alive and find fd < 0.
+  void close(Connection& connection) {
+    const int fd = connection.fd;
+    if (fd < 0) return;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connection.fd = -1;
+    connections_.erase(fd);
+  }
+
+  Server& server_;
+  int listen_fd_;
+  unsigned node_;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::atomic<bool> stopping_{false};
+  std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+  std::vector<std::shared_ptr<Connection>> dirty_;
+  std::vector<std::shared_ptr<Connection>> flushing_;
+  std::mutex completions_mutex_;
+  std::vector<Completion> completions_;
+  std::vector<Completion> draining_;
+};
+
+Server::Server(ServerOptions options, unsigned pegs, unsigned colours,
+               SolverFactory factory, std::shared_ptr<ThreadPool> pool)
+    : options_(std::move(options)),
+      pegs_(pegs),
+      colours_(colours),
+      factory_(std::move(factory)),
+      pool_(std::move(pool)),
+      idle_(numa::nodes()) {
+  if (!pool_) throw std::invalid_argument("the server needs a thread pool");
+  const unsigned loops = std::max(options_.io_threads, 1u);
+  port_ = options_.port;
+  for (unsigned i = 0; i < loops; ++i) {
+    const int fd = listen_on(options_, port_);
+    if (port_ == 0) {
+      // Later listeners join the port the first one was given.
+      sockaddr_in bound{};
+      socklen_t length = sizeof(bound);
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &length);
+      port_ = ntohs(bound.sin_port);
+    }
+    const unsigned node =
+        options_.numa ? i % numa::nodes() : Loop::kAnyNode;
+    loops_.push_back(std::make_unique<Loop>(*this, fd, node));
+  }
+}
+
+Server::~Server() {
+  stop();
+  // Pool tasks post to the loops, so the loops outlive them.
+  for (std::uint64_t n = inflight_.load(std::memory_order_acquire); n != 0;
+       n = inflight_.load(std::memory_order_acquire)) {
+    inflight_.wait(n, std::memory_order_acquire);
+  }
+}
+
+void Server::run() {
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < loops_.size(); ++i) {
+    threads.emplace_back([loop = loops_[i].get()] { loop->run(); });
+  }
+  loops_[0]->run();
+  for (std::thread& thread : threads) thread.join();
+}
+
+void Server::stop() {
+  for (const auto& loop : loops_) loop->stop();
+}
+
+std::string Server::stats() const {
+  std::ostringstream out;
+  // The metrics carry their own request counter.
+  if (!metrics::kEnabled) {
+    out << "requests " << requests() << '\n'
+        << "book-hits " << book_hits() << '\n';
+  }
+  metrics::write(out, metrics::snapshot());
+  return out.str();
+}
+
+void Server::set_book(std::shared_ptr<const StrategyTree> book) {
+  if (book != nullptr &&
+      (book->key().pegs != pegs_ || book->key().colours != colours_)) {
+    throw std::invalid_argument("book is for another board");
+  }
+  book_.store(std::move(book), std::memory_order_release);
+}
+
+std::unique_ptr<GameSolver> Server::acquire_solver() {
+  {
+    std::lock_guard lock(idle_mutex_);
+    auto& idle = idle_[numa::current_node() % idle_.size()];
+    if (!idle.empty()) {
+      std::unique_ptr<GameSolver> solver = std::move(idle.back());
+      idle.pop_back();
+      return solver;
+    }
+  }
+  return factory_();
+}
+
+void Server::release_solver(std::unique_ptr<GameSolver> solver) {
+  std::lock_guard lock(idle_mutex_);
+  idle_[numa::current_node() % idle_.size()].push_back(std::move(solver));
+}
+
+void Server::solve(std::span<const std::byte> request, std::byte* response) {
+  using wire::Status;
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  metrics::add(metrics::Counter::kRequests);
+  const std::optional<wire::GameStateView> state =
+      wire::GameStateView::parse(request);
+  if (!state) {
+    const std::uint64_t game =
+        request.size() >= 8 ? wire::detail::load<std::uint64_t>(request.data())
+                            : 0;
+    wire::write_answer(response, game, Status::kInvalid, Code());
+    return;
+  }
+  Status status = Status::kInvalid;
+  Code guess;
+  std::optional<Code> book_guess;
+  if (state->pegs() != pegs_ || state->colours() != colours_) {
+    status = Status::kUnsupported;
+  } else if (!state->valid_moves()) {
+    status = Status::kInvalid;
+  } else if (const std::shared_ptr<const StrategyTree> book = this->book();
+             book != nullptr && (book_guess = book->lookup(*state))) {
+    // Book positions come from games that reached them, so are consistent.
+    guess = *book_guess;
+    status = Status::kOk;
+    book_hits_.fetch_add(1, std::memory_order_relaxed);
+    metrics::add(metrics::Counter::kBookHits);
+  } else if (!history_consistent(*state)) {
+    // Propagation settles most contradictory histories without a solver.
+    status = Status::kInconsistent;
+  } else {
+    std::unique_ptr<GameSolver> solver;
+    try {
+      solver = acquire_solver();
+      solver->reset();
+      for (std::size_t i = 0; i < state->size(); ++i) {
+        const Move move = (*state)[i];
+        solver->record(move.guess, move.feedback);
+      }
+      guess = solver->next_guess();
+      status = Status::kOk;
+    } catch (const InconsistentFeedback&) {
+      status = Status::kInconsistent;
+    } catch (const std::invalid_argument&) {
+      status = Status::kInvalid;
+    } catch (const std::exception&) {
+      // An exception escaping a pool task would terminate the server.
+      status = Status::kFailed;
+    }
+    if (solver != nullptr) release_solver(std::move(solver));
+  }
+  wire::write_answer(response, state->game(), status, guess);
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,145 @@
+#include "mastermyr/session.hpp"
+
+#include <utility>
+
+namespace mastermyr {
+namespace {
+
+// The frame's resource sits in front of it, padded to keep the frame
+// aligned for anything.
+constexpr std::size_t kFrameHeader = alignof(std::max_align_t);
+static_assert(kFrameHeader >= sizeof(std::pmr::memory_resource*));
+
+// co_await Self{} hands a coroutine body its own promise without
+// suspending.
+struct Self {
+  GameSession::promise_type* promise = nullptr;
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(GameSession::Handle handle) noexcept {
+    promise = &handle.promise();
+    return false;
+  }
+  GameSession::promise_type& await_resume() const noexcept { return *promise; }
+};
+
+}  // namespace
+
+GameSession::GameSession(GameSession&& other) noexcept
+    : handle_(std::exchange(other.handle_, nullptr)) {}
+
+GameSession& GameSession::operator=(GameSession&& other) noexcept {
+  if (this != &other) {
+    if (handle_) handle_.destroy();
+    handle_ = std::exchange(other.handle_, nullptr);
+  }
+  return *this;
+}
+
+GameSession::~GameSession() {
+  if (handle_) handle_.destroy();
+}
+
+SessionState GameSession::state() const { return handle_.promise().state; }
+
+Code GameSession::guess() const { return handle_.promise().guess; }
+
+void GameSession::feedback(Feedback feedback) {
+  promise_type& promise = handle_.promise();
+  promise.answer = feedback;
+  handle_.resume();
+  if (promise.error) {
+    promise.state = SessionState::kFailed;
+    std::rethrow_exception(std::exchange(promise.error, nullptr));
+  }
+}
+
+std::span<const Move> GameSession::history() const {
+  return handle_.promise().history;
+}
+
+ArenaStats GameSession::arena_stats() const {
+  return handle_.promise().arena.stats();
+}
+
+GameSession::promise_type::promise_type(SessionHost& host)
+    : host(host),
+      id(host.next_id_++),
+      arena(SessionHost::kSessionChunk, &host.frames_),
+      history(&arena) {
+  // Most games end within this many moves.
+  history.reserve(8);
+  ++host.live_;
+}
+
+GameSession::promise_type::~promise_type() { --host.live_; }
+
+void* GameSession::promise_type::operator new(std::size_t size,
+                                              SessionHost& host) {
+  std::pmr::memory_resource* resource = &host.frames_;
+  auto* block = static_cast<std::byte*>(resource->allocate(
+      size + kFrameHeader, alignof(std::max_align_t)));
+  *reinterpret_cast<std::pmr::memory_resource**>(block) = resource;
+  return block + kFrameHeader;
+}
+
+void GameSession::promise_type::operator delete(void* frame,
+                                                std::size_t size) {
+  std::byte* block = static_cast<std::byte*>(frame) - kFrameHeader;
+  std::pmr::memory_resource* resource =
+      *reinterpret_cast<std::pmr::memory_resource**>(block);
+  resource->deallocate(block, size + kFrameHeader, alignof(std::max_align_t));
+}
+
+SessionHost::SessionHost(std::unique_ptr<GameSolver> solver)
+    : solver_(std::move(solver)) {}
+
+GameSession SessionHost::start() {
+  GameSession session = play(*this);
+  if (const std::exception_ptr error = session.handle_.promise().error) {
+    std::rethrow_exception(error);
+  }
+  return session;
+}
+
+GameSession SessionHost::play(SessionHost& host) {
+  GameSession::promise_type& game = co_await Self{};
+  const Feedback solved = solved_feedback(host.pegs());
+  while (true) {
+    Code guess;
+    try {
+      guess = host.advance(game);
+    } catch (const InconsistentFeedback&) {
+      game.state = SessionState::kInconsistent;
+      break;
+    }
+    const Feedback feedback = co_await game.ask(guess);
+    game.history.push_back({guess, feedback});
+    if (feedback == solved) {
+      game.state = SessionState::kSolved;
+      break;
+    }
+  }
+}
+
+Code SessionHost::advance(const GameSession::promise_type& game) {
+  const std::span<const Move> moves = game.history;
+  std::size_t recorded = 0;
+  if (owner_ == game.id && owner_moves_ <= moves.size()) {
+    recorded = owner_moves_;
+  } else {
+    // A solver of the game's own would only have to take the newest move.
+    solver_->reset();
+    replayed_ += moves.empty() ? 0 : moves.size() - 1;
+  }
+  // Owned by no game while a record() that may throw is under way.
+  owner_ = kNoOwner;
+  for (std::size_t i = recorded; i < moves.size(); ++i) {
+    solver_->record(moves[i].guess, moves[i].feedback);
+  }
+  owner_ = game.id;
+  owner_moves_ = moves.size();
+  return solver_->next_guess();
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,87 @@
+#include "mastermyr/solver.hpp"
+
+#include <string>
+
+namespace mastermyr {
+
+#define MASTERMYR_INSTANTIATE_SOLVER(P, C) template class Solver<P, C>;
+MASTERMYR_FOR_EACH_BOARD(MASTERMYR_INSTANTIATE_SOLVER)
+#undef MASTERMYR_INSTANTIATE_SOLVER
+#define MASTERMYR_INSTANTIATE_VARIANT_SOLVER(P, C, R) \
+  template class Solver<P, C, R>;
+MASTERMYR_FOR_EACH_VARIANT_BOARD(MASTERMYR_INSTANTIATE_VARIANT_SOLVER)
+#undef MASTERMYR_INSTANTIATE_VARIANT_SOLVER
+
+namespace {
+
+template <unsigned Pegs, unsigned Colours, typename GameRules = Mastermind>
+class GameSolverImpl final : public GameSolver {
+ public:
+  explicit GameSolverImpl(SolverOptions options) : solver_(options) {}
+
+  unsigned pegs() const override { return Pegs; }
+  unsigned colours() const override { return Colours; }
+  void reset() override { solver_.reset(); }
+  Code next_guess() override { return solver_.next_guess(); }
+  void record(Code guess, Feedback feedback) override {
+    solver_.record(guess, feedback);
+  }
+  bool solved() const override { return solver_.solved(); }
+  std::size_t remaining() const override { return solver_.remaining(); }
+  ArenaStats arena_stats() const override { return solver_.arena_stats(); }
+  SearchStats last_search() const override { return solver_.last_search(); }
+
+ private:
+  Solver<Pegs, Colours, GameRules> solver_;
+};
+
+}  // namespace
+
+bool is_supported_board(unsigned pegs, unsigned colours) {
+#define MASTERMYR_MATCH_BOARD(P, C) \
+  if (pegs == P && colours == C) return true;
+  MASTERMYR_FOR_EACH_BOARD(MASTERMYR_MATCH_BOARD)
+#undef MASTERMYR_MATCH_BOARD
+  return false;
+}
+
+bool is_supported_board(unsigned pegs, unsigned colours, Variant variant) {
+  if (variant == Variant::kMastermind) return is_valid_board(pegs, colours);
+#define MASTERMYR_MATCH_VARIANT_BOARD(P, C, R) \
+  if (pegs == P && colours == C && variant == variant_of<R>()) return true;
+  MASTERMYR_FOR_EACH_VARIANT_BOARD(MASTERMYR_MATCH_VARIANT_BOARD)
+#undef MASTERMYR_MATCH_VARIANT_BOARD
+  return false;
+}
+
+std::unique_ptr<GameSolver> make_solver(unsigned pegs, unsigned colours,
+                                        SolverOptions options) {
+#define MASTERMYR_MAKE_SOLVER(P, C) \
+  if (pegs == P && colours == C)    \
+    return std::make_unique<GameSolverImpl<P, C>>(options);
+  MASTERMYR_FOR_EACH_BOARD(MASTERMYR_MAKE_SOLVER)
+#undef MASTERMYR_MAKE_SOLVER
+  if (is_valid_board(pegs, colours)) {
+    return make_sampled_solver(pegs, colours, std::move(options));
+  }
+  throw std::invalid_argument("no solver for a " + std::to_string(pegs) + "x" +
+                              std::to_string(colours) + " board");
+}
+
+std::unique_ptr<GameSolver> make_solver(unsigned pegs, unsigned colours,
+                                        Variant variant,
+                                        SolverOptions options) {
+  if (variant == Variant::kMastermind) {
+    return make_solver(pegs, colours, std::move(options));
+  }
+#define MASTERMYR_MAKE_VARIANT_SOLVER(P, C, R)                   \
+  if (pegs == P && colours == C && variant == variant_of<R>()) \
+    return std::make_unique<GameSolverImpl<P, C, R>>(options);
+  MASTERMYR_FOR_EACH_VARIANT_BOARD(MASTERMYR_MAKE_VARIANT_SOLVER)
+#undef MASTERMYR_MAKE_VARIANT_SOLVER
+  throw std::invalid_argument(std::string("no ") + variant_name(variant) +
+                              " solver for a " + std::to_string(pegs) + "x" +
+                              std::to_string(colours) + " board");
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,573 @@
+#include "mastermyr/strategy_tree.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "mastermyr/boards.hpp"
+#include "mastermyr/hash.hpp"
+
+namespace mastermyr {
+namespace {
+
+static_assert(std::endian::native == std::endian::little,
+              "tree files are written in host byte order");
+
+constexpr std::array<char, 8> kMagic = {'M', 'M', 'Y', 'R', 'S', 'T', 'R', 0};
+
+struct FileHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint8_t pegs;
+  std::uint8_t colours;
+  std::uint8_t duplicates;
+  std::uint8_t strategy;
+  std::uint64_t node_count;
+  std::uint64_t slot_count;
+  std::uint64_t payload_offset;
+  std::uint64_t payload_size;
+  std::uint64_t checksum;
+  std::uint32_t depth;
+  std::uint32_t flags;
+};
+static_assert(sizeof(FileHeader) == 64);
+
+// Header flags. Files written before there were any have none set.
+constexpr std::uint32_t kPartialFlag = 1;
+
+std::uint64_t checksum(std::span<const StrategyTree::Node> nodes,
+                       std::span<const StrategyTree::NodeIndex> children) {
+  return hash_bytes(children.data(), children.size_bytes(),
+                    hash_bytes(nodes.data(), nodes.size_bytes()));
+}
+
+// Copies top node `index` and everything below it to `nodes` and `children`
+// in depth-first order, relocating the jobs' subtrees, which already are.
+StrategyTree::NodeIndex splice(StrategyTree::NodeIndex index,
+                               const StrategyTree::Split& split,
+                               std::span<const StrategyTree::Subtree> subtrees,
+                               std::size_t ranks,
+                               std::vector<StrategyTree::Node>& nodes,
+                               std::vector<StrategyTree::NodeIndex>& children) {
+  using NodeIndex = StrategyTree::NodeIndex;
+  const auto at = static_cast<NodeIndex>(nodes.size());
+  nodes.push_back(split.nodes[index]);
+  const std::uint32_t first = split.nodes[index].children;
+  if (first == StrategyTree::kNone) return at;
+  const auto slots = static_cast<std::uint32_t>(children.size());
+  children.resize(slots + ranks, StrategyTree::kNone);
+  nodes[at].children = slots;
+  for (std::size_t r = 0; r < ranks; ++r) {
+    const NodeIndex child = split.children[first + r];
+    if (child == StrategyTree::kNone) continue;
+    NodeIndex placed;
+    if (child & StrategyTree::Split::kJob) {
+      const StrategyTree::Subtree& subtree =
+          subtrees[child & ~StrategyTree::Split::kJob];
+      placed = static_cast<NodeIndex>(nodes.size());
+      const auto slot_base = static_cast<std::uint32_t>(children.size());
+      for (StrategyTree::Node node : subtree.nodes) {
+        if (node.children != StrategyTree::kNone) node.children += slot_base;
+        nodes.push_back(node);
+      }
+      for (const NodeIndex grandchild : subtree.children) {
+        children.push_back(grandchild == StrategyTree::kNone
+                               ? grandchild
+                               : grandchild + placed);
+      }
+    } else {
+      placed = splice(child, split, subtrees, ranks, nodes, children);
+    }
+    children[slots + r] = placed;
+  }
+  return at;
+}
+
+}  // namespace
+
+// Walks the solver depth first, saving the position at every level so that
+// each feedback branch restarts from its parent without replaying moves.
+//
+// With a pool, the levels above kSplitLevel are expanded serially and every
+// position at kSplitLevel becomes a job; the jobs are compiled in parallel,
+// one compiler per participant, and their subtrees are spliced back in
+// place, so the result is the same array as a serial compile. A
+// distributed compile runs the same split, sending each job's moves to a
+// worker that replays them.
+template <unsigned Pegs, unsigned Colours>
+class TreeCompiler {
+ public:
+  using Node = StrategyTree::Node;
+  using NodeIndex = StrategyTree::NodeIndex;
+  using Position = typename Solver<Pegs, Colours>::Position;
+
+  static constexpr std::size_t kRanks = feedback_ranks(Pegs);
+  static constexpr Feedback kSolved = solved_feedback(Pegs);
+  static constexpr unsigned kSplitLevel = 2;
+
+  explicit TreeCompiler(const SolverOptions& options) : solver_(options) {}
+
+  StrategyTree run() {
+    ThreadPool* pool = solver_.options().pool.get();
+    if (pool != nullptr && pool->workers() > 0) return compile_parallel(*pool);
+    StrategyTree tree;
+    tree.key_ = Solver<Pegs, Colours>::kBoardKey;
+    tree.strategy_ = solver_.options().strategy;
+    levels_.resize(1);
+    solver_.save(levels_[0]);
+    expand(0, tree.owned_nodes_, tree.owned_children_, tree.depth_, nullptr,
+           nullptr);
+    tree.nodes_ = tree.owned_nodes_;
+    tree.children_ = tree.owned_children_;
+    return tree;
+  }
+
+  // The top levels; with `positions`, also each job's saved position.
+  StrategyTree::Split split(std::vector<Position>* positions) {
+    StrategyTree::Split split;
+    split.key = Solver<Pegs, Colours>::kBoardKey;
+    split.strategy = solver_.options().strategy;
+    levels_.resize(1);
+    solver_.save(levels_[0]);
+    expand(0, split.nodes, split.children, split.depth, &split.jobs,
+           positions);
+    return split;
+  }
+
+  StrategyTree::Subtree compile_subtree(std::span<const Move> moves) {
+    for (const Move& move : moves) solver_.record(move.guess, move.feedback);
+    levels_.resize(1);
+    solver_.save(levels_[0]);
+    StrategyTree::Subtree subtree;
+    expand(0, subtree.nodes, subtree.children, subtree.depth, nullptr,
+           nullptr);
+    return subtree;
+  }
+
+ private:
+  StrategyTree compile_parallel(ThreadPool& pool) {
+    std::vector<Position> positions;
+    const StrategyTree::Split top = split(&positions);
+    std::vector<StrategyTree::Subtree> subtrees(positions.size());
+    std::vector<std::unique_ptr<TreeCompiler>> compilers(pool.concurrency());
+    pool.parallel_for(positions.size(), 1,
+                      [&](std::size_t begin, std::size_t end,
+                          unsigned participant) {
+                        auto& compiler = compilers[participant];
+                        if (!compiler) {
+                          compiler = std::make_unique<TreeCompiler>(
+                              solver_.options());
+                        }
+                        for (std::size_t j = begin; j < end; ++j) {
+                          subtrees[j] = compiler->compile_at(positions[j]);
+                        }
+                      });
+    return StrategyTree::assemble(top, subtrees);
+  }
+
+  StrategyTree::Subtree compile_at(Position& position) {
+    levels_.resize(1);
+    levels_[0] = std::move(position);
+    solver_.restore(levels_[0]);
+    StrategyTree::Subtree subtree;
+    expand(0, subtree.nodes, subtree.children, subtree.depth, nullptr,
+           nullptr);
+    return subtree;
+  }
+
+  // Adds the node for the solver's current position, which is levels_[level],
+  // and the subtrees below it; positions at kSplitLevel go to `jobs` (and
+  // their saved state to `positions`) instead when it is given.
+  NodeIndex expand(unsigned level, std::vector<Node>& nodes,
+                   std::vector<NodeIndex>& children, unsigned& depth,
+                   std::vector<std::vector<Move>>* jobs,
+                   std::vector<Position>* positions) {
+    const Code guess = solver_.next_guess();
+    const auto index = static_cast<NodeIndex>(nodes.size());
+    nodes.push_back({guess.bits(), StrategyTree::kNone,
+                     static_cast<std::uint32_t>(solver_.remaining())});
+    depth = std::max(depth, level + 1);
+
+    std::array<bool, feedback_slots(Pegs)> seen{};
+    unsigned classes = 0;
+    for (const Code code : solver_.candidates().codes()) {
+      bool& slot = seen[Solver<Pegs, Colours>::score(guess, code).raw()];
+      classes += !slot;
+      slot = true;
+    }
+    if (classes == 1 && seen[kSolved.raw()]) return index;
+    if (classes == 1) {
+      throw std::runtime_error("strategy repeats a position at guess " +
+                               to_string(guess, Pegs));
+    }
+
+    const auto first = static_cast<std::uint32_t>(children.size());
+    children.resize(first + kRanks, StrategyTree::kNone);
+    nodes[index].children = first;
+    if (levels_.size() < level + 2) levels_.resize(level + 2);
+    for (unsigned raw = 0; raw < seen.size(); ++raw) {
+      const Feedback feedback(static_cast<std::uint8_t>(raw));
+      if (!seen[raw] || feedback == kSolved) continue;
+      solver_.restore(levels_[level]);
+      solver_.record(guess, feedback);
+      NodeIndex child;
+      if (jobs != nullptr && level + 1 == kSplitLevel) {
+        child = StrategyTree::Split::kJob |
+                static_cast<NodeIndex>(jobs->size());
+        const std::span<const Move> history = solver_.history();
+        jobs->emplace_back(history.begin(), history.end());
+        if (positions != nullptr) solver_.save(positions->emplace_back());
+      } else {
+        solver_.save(levels_[level + 1]);
+        child = expand(level + 1, nodes, children, depth, jobs, positions);
+      }
+      children[first + feedback_rank(feedback, Pegs)] = child;
+    }
+    return index;
+  }
+
+  Solver<Pegs, Colours> solver_;
+  std::vector<Position> levels_;
+};
+
+StrategyTree StrategyTree::compile(unsigned pegs, unsigned colours,
+                                   const SolverOptions& options) {
+#define MASTERMYR_COMPILE_TREE(P, C) \
+  if (pegs == P && colours == C) return TreeCompiler<P, C>(options).run();
+  MASTERMYR_FOR_EACH_BOARD(MASTERMYR_COMPILE_TREE)
+#undef MASTERMYR_COMPILE_TREE
+  throw std::invalid_argument("no solver for a " + std::to_string(pegs) + "x" +
+                              std::to_string(colours) + " board");
+}
+
+StrategyTree::Split StrategyTree::split(unsigned pegs, unsigned colours,
+                                        const SolverOptions& options) {
+#define MASTERMYR_SPLIT_TREE(P, C) \
+  if (pegs == P && colours == C) {  \
+    return TreeCompiler<P, C>(options).split(nullptr); \
+  }
+  MASTERMYR_FOR_EACH_BOARD(MASTERMYR_SPLIT_TREE)
+#undef MASTERMYR_SPLIT_TREE
+  throw std::invalid_argument("no solver for a " + std::to_string(pegs) + "x" +
+                              std::to_string(colours) + " board");
+}
+
+StrategyTree::Subtree StrategyTree::compile_subtree(
+    unsigned pegs, unsigned colours, const SolverOptions& options,
+    std::span<const Move> moves) {
+#define MASTERMYR_COMPILE_SUBTREE(P, C) \
+  if (pegs == P && colours == C) {       \
+    return TreeCompiler<P, C>(options).compile_subtree(moves); \
+  }
+  MASTERMYR_FOR_EACH_BOARD(MASTERMYR_COMPILE_SUBTREE)
+#undef MASTERMYR_COMPILE_SUBTREE
+  throw std::invalid_argument("no solver for a " + std::to_string(pegs) + "x" +
+                              std::to_string(colours) + " board");
+}
+
+StrategyTree StrategyTree::assemble(const Split& split,
+                                    std::span<const Subtree> subtrees) {
+  if (subtrees.size() != split.jobs.size()) {
+    throw std::invalid_argument(
+        std::to_string(subtrees.size()) + " subtrees for " +
+        std::to_string(split.jobs.size()) + " jobs");
+  }
+  StrategyTree tree;
+  tree.key_ = split.key;
+  tree.strategy_ = split.strategy;
+  tree.depth_ = split.depth;
+  std::size_t nodes = split.nodes.size();
+  std::size_t slots = split.children.size();
+  for (std::size_t j = 0; j < subtrees.size(); ++j) {
+    nodes += subtrees[j].nodes.size();
+    slots += subtrees[j].children.size();
+    // Every job sits at the split level, the moves leading to it deep.
+    tree.depth_ = std::max<unsigned>(
+        tree.depth_,
+        static_cast<unsigned>(split.jobs[j].size()) + subtrees[j].depth);
+  }
+  tree.owned_nodes_.reserve(nodes);
+  tree.owned_children_.reserve(slots);
+  splice(kRoot, split, subtrees, feedback_ranks(split.key.pegs),
+         tree.owned_nodes_, tree.owned_children_);
+  tree.nodes_ = tree.owned_nodes_;
+  tree.children_ = tree.owned_children_;
+  return tree;
+}
+
+StrategyTree StrategyTree::partial(const BoardKey& key, Strategy strategy,
+                                   Subtree subtree) {
+  if (subtree.nodes.empty()) {
+    throw std::invalid_argument("a tree needs a root");
+  }
+  StrategyTree tree;
+  tree.key_ = key;
+  tree.strategy_ = strategy;
+  tree.depth_ = subtree.depth;
+  tree.complete_ = false;
+  tree.owned_nodes_ = std::move(subtree.nodes);
+  tree.owned_children_ = std::move(subtree.children);
+  tree.nodes_ = tree.owned_nodes_;
+  tree.children_ = tree.owned_children_;
+  return tree;
+}
+
+StrategyTree StrategyTree::load(const std::filesystem::path& file,
+                                const BoardKey& key) {
+  MappedFile mapping = MappedFile::open(file);
+  const std::span<const std::byte> bytes = mapping.bytes();
+  FileHeader header;
+  if (bytes.size() < sizeof(header)) {
+    throw CacheError(file.string() + ": truncated header");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kMagic) {
+    throw CacheError(file.string() + ": not a strategy tree");
+  }
+  if (header.version != kFormatVersion) {
+    throw CacheError(file.string() + ": format version " +
+                     std::to_string(header.version) + ", expected " +
+                     std::to_string(kFormatVersion));
+  }
+  if (header.pegs != key.pegs || header.colours != key.colours ||
+      header.duplicates != static_cast<std::uint8_t>(key.duplicates)) {
+    throw CacheError(file.string() + ": tree is for another board");
+  }
+  const std::uint64_t node_bytes = header.node_count * sizeof(Node);
+  const std::uint64_t slot_bytes = header.slot_count * sizeof(NodeIndex);
+  if (header.node_count == 0 ||
+      header.payload_size != node_bytes + slot_bytes ||
+      header.payload_offset < sizeof(header) ||
+      header.payload_offset % alignof(Node) != 0 ||
+      bytes.size() < header.payload_offset + header.payload_size) {
+    throw CacheError(file.string() + ": truncated payload");
+  }
+  const std::byte* payload = bytes.data() + header.payload_offset;
+  const std::span<const Node> nodes(reinterpret_cast<const Node*>(payload),
+                                    header.node_count);
+  const std::span<const NodeIndex> children(
+      reinterpret_cast<const NodeIndex*>(payload + node_bytes),
+      header.slot_count);
+  if (checksum(nodes, children) != header.checksum) {
+    throw CacheError(file.string() + ": checksum mismatch");
+  }
+  if (!is_strategy(header.strategy) || header.depth == 0 ||
+      header.depth > kMaxDepth || !well_formed(nodes, children, key.pegs)) {
+    throw CacheError(file.string() + ": malformed tree");
+  }
+
+  StrategyTree tree;
+  tree.key_ = key;
+  tree.strategy_ = static_cast<Strategy>(header.strategy);
+  tree.depth_ = header.depth;
+  tree.complete_ = (header.flags & kPartialFlag) == 0;
+  tree.nodes_ = nodes;
+  tree.children_ = children;
+  tree.mapping_ = std::move(mapping);
+  return tree;
+}
+
+bool StrategyTree::well_formed(std::span<const Node> nodes,
+                               std::span<const NodeIndex> children,
+                               unsigned pegs) {
+  const std::size_t ranks = feedback_ranks(pegs);
+  for (const Node& node : nodes) {
+    if (node.children != kNone && (node.children > children.size() ||
+                                   children.size() - node.children < ranks)) {
+      return false;
+    }
+  }
+  for (const NodeIndex child : children) {
+    if (child != kNone && child >= nodes.size()) return false;
+  }
+  return true;
+}
+
+StrategyTree StrategyTree::copy_to_node(unsigned node) const {
+  StrategyTree tree;
+  tree.key_ = key_;
+  tree.strategy_ = strategy_;
+  tree.depth_ = depth_;
+  tree.complete_ = complete_;
+  const std::size_t node_bytes = nodes_.size_bytes();
+  tree.replica_ =
+      numa::NodeBuffer(node_bytes + children_.size_bytes(), node);
+  std::byte* data = tree.replica_.data();
+  std::memcpy(data, nodes_.data(), node_bytes);
+  std::memcpy(data + node_bytes, children_.data(), children_.size_bytes());
+  tree.nodes_ = {reinterpret_cast<const Node*>(data), nodes_.size()};
+  tree.children_ = {reinterpret_cast<const NodeIndex*>(data + node_bytes),
+                    children_.size()};
+  return tree;
+}
+
+void StrategyTree::save(const std::filesystem::path& file) const {
+  FileHeader header{};
+  header.magic = kMagic;
+  header.version = kFormatVersion;
+  header.pegs = static_cast<std::uint8_t>(key_.pegs);
+  header.colours = static_cast<std::uint8_t>(key_.colours);
+  header.duplicates = static_cast<std::uint8_t>(key_.duplicates);
+  header.strategy = static_cast<std::uint8_t>(strategy_);
+  header.node_count = nodes_.size();
+  header.slot_count = children_.size();
+  header.payload_offset = sizeof(header);
+  header.payload_size = nodes_.size_bytes() + children_.size_bytes();
+  header.checksum = checksum(nodes_, children_);
+  header.depth = depth_;
+  header.flags = complete_ ? 0 : kPartialFlag;
+
+  // Unique per process so that concurrent writers never share a temporary.
+  std::filesystem::path tmp = file;
+  tmp += ".tmp." + std::to_string(::getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(nodes_.data()),
+              static_cast<std::streamsize>(nodes_.size_bytes()));
+    out.write(reinterpret_cast<const char*>(children_.data()),
+              static_cast<std::streamsize>(children_.size_bytes()));
+    out.close();
+    if (!out) {
+      std::error_code ignored;
+      std::filesystem::remove(tmp, ignored);
+      throw CacheError("cannot write " + tmp.string());
+    }
+  }
+  std::filesystem::rename(tmp, file);
+}
+
+std::uint64_t TreeEvaluation::secrets() const {
+  std::uint64_t total = failures;
+  for (const std::uint64_t n : games) total += n;
+  return total;
+}
+
+double TreeEvaluation::average() const {
+  std::uint64_t solved = 0;
+  std::uint64_t guesses = 0;
+  for (std::size_t n = 0; n < games.size(); ++n) {
+    solved += games[n];
+    guesses += n * games[n];
+  }
+  return solved == 0 ? 0 : static_cast<double>(guesses) / solved;
+}
+
+unsigned TreeEvaluation::worst() const {
+  for (std::size_t n = games.size(); n-- > 0;) {
+    if (games[n] != 0) return static_cast<unsigned>(n);
+  }
+  return 0;
+}
+
+TreeEvaluation evaluate(const StrategyTree& tree, ThreadPool* pool) {
+  const unsigned pegs = tree.key().pegs;
+  const unsigned colours = tree.key().colours;
+  const Feedback solved = solved_feedback(pegs);
+  const unsigned participants = pool ? pool->concurrency() : 1;
+  // Per participant: guess counts up to the depth, then failures.
+  std::vector<std::vector<std::uint64_t>> counts(
+      participants, std::vector<std::uint64_t>(tree.depth() + 2));
+  auto body = [&](std::size_t begin, std::size_t end, unsigned participant) {
+    std::vector<std::uint64_t>& local = counts[participant];
+    for (std::size_t i = begin; i < end; ++i) {
+      const Code secret =
+          code_at_index(static_cast<std::uint32_t>(i), pegs, colours);
+      StrategyTree::NodeIndex node = StrategyTree::kRoot;
+      unsigned guesses = 1;
+      while (true) {
+        const Feedback feedback = score(tree.guess(node), secret, pegs);
+        if (feedback == solved) break;
+        node = tree.child(node, feedback);
+        if (node == StrategyTree::kNone || ++guesses > tree.depth()) {
+          guesses = tree.depth() + 1;
+          break;
+        }
+      }
+      ++local[guesses];
+    }
+  };
+  const std::size_t secrets = code_count(pegs, colours);
+  if (pool != nullptr) {
+    pool->parallel_for(secrets, 4096, body);
+  } else {
+    body(0, secrets, 0);
+  }
+
+  TreeEvaluation result;
+  result.games.assign(tree.depth() + 1, 0);
+  for (const std::vector<std::uint64_t>& local : counts) {
+    for (unsigned n = 0; n <= tree.depth(); ++n) result.games[n] += local[n];
+    result.failures += local[tree.depth() + 1];
+  }
+  return result;
+}
+
+namespace {
+
+class TreeSolver final : public GameSolver {
+ public:
+  explicit TreeSolver(std::shared_ptr<const StrategyTree> tree)
+      : tree_(std::move(tree)) {}
+
+  unsigned pegs() const override { return tree_->key().pegs; }
+  unsigned colours() const override { return tree_->key().colours; }
+  void reset() override {
+    node_ = StrategyTree::kRoot;
+    solved_ = false;
+  }
+  Code next_guess() override {
+    if (node_ == StrategyTree::kNone) throw InconsistentFeedback();
+    return tree_->guess(node_);
+  }
+  void record(Code guess, Feedback feedback) override {
+    if (node_ == StrategyTree::kNone || guess != tree_->guess(node_)) {
+      throw std::invalid_argument("guess " + to_string(guess, pegs()) +
+                                  " is not the strategy's move");
+    }
+    if (feedback == solved_feedback(pegs())) {
+      solved_ = true;
+      return;
+    }
+    node_ = tree_->child(node_, feedback);
+  }
+  bool solved() const override { return solved_; }
+  std::size_t remaining() const override {
+    if (solved_) return 1;
+    return node_ == StrategyTree::kNone ? 0 : tree_->candidates(node_);
+  }
+  // Serving from the tree allocates nothing.
+  ArenaStats arena_stats() const override { return {}; }
+  // Moves are looked up, never searched.
+  SearchStats last_search() const override { return {}; }
+
+ private:
+  std::shared_ptr<const StrategyTree> tree_;
+  StrategyTree::NodeIndex node_ = StrategyTree::kRoot;
+  bool solved_ = false;
+};
+
+}  // namespace
+
+std::unique_ptr<GameSolver> make_tree_solver(
+    std::shared_ptr<const StrategyTree> tree) {
+  if (!tree->complete()) {
+    throw std::invalid_argument("a partial tree cannot play every game");
+  }
+  return std::make_unique<TreeSolver>(std::move(tree));
+}
+
+std::string strategy_tree_name(const BoardKey& key, Strategy strategy) {
+  return "strategy-v" + std::to_string(StrategyTree::kFormatVersion) + "-" +
+         std::to_string(key.pegs) + "x" + std::to_string(key.colours) +
+         (key.duplicates == DuplicateRule::kAllowed ? "-dup-" : "-nodup-") +
+         strategy_name(strategy) + ".bin";
+}
+
+}  // namespace mastermyr
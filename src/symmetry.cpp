@@ -0,0 +1,114 @@
+#include "mastermyr/symmetry.hpp"
+
+#include <bit>
+#include <functional>
+
+namespace mastermyr {
+namespace {
+
+// Insertion sort; the arrays hold at most kMaxPegs elements.
+template <typename T, typename Less>
+void sort_small(T* first, unsigned n, Less less) {
+  for (unsigned i = 1; i < n; ++i) {
+    const T value = first[i];
+    unsigned j = i;
+    for (; j > 0 && less(value, first[j - 1]); --j) first[j] = first[j - 1];
+    first[j] = value;
+  }
+}
+
+}  // namespace
+
+Symmetry::Symmetry(unsigned pegs, unsigned colours)
+    : pegs_(pegs), colours_(colours) {
+  reset();
+}
+
+void Symmetry::reset() {
+  free_colours_ = (std::uint32_t{1} << colours_) - 1;
+  classes_ = pegs_ > 0 ? 1 : 0;
+  class_of_.fill(0);
+  update_trivial();
+}
+
+void Symmetry::record(Code guess) {
+  for (unsigned i = 0; i < pegs_; ++i) {
+    free_colours_ &= ~(std::uint32_t{1} << guess.peg(i));
+  }
+  // Split each class by the colour the guess gives it: positions stay
+  // together only if they stayed together before and agree now.
+  std::array<std::uint8_t, kMaxPegs> next{};
+  std::array<std::uint8_t, kMaxPegs> first{};  // a position of each new class
+  unsigned count = 0;
+  for (unsigned i = 0; i < pegs_; ++i) {
+    unsigned k = 0;
+    while (k < count && !(class_of_[first[k]] == class_of_[i] &&
+                          guess.peg(first[k]) == guess.peg(i))) {
+      ++k;
+    }
+    if (k == count) first[count++] = static_cast<std::uint8_t>(i);
+    next[i] = static_cast<std::uint8_t>(k);
+  }
+  class_of_ = next;
+  classes_ = count;
+  update_trivial();
+}
+
+void Symmetry::update_trivial() {
+  trivial_ = classes_ == pegs_ && std::popcount(free_colours_) <= 1;
+}
+
+Code Symmetry::canonical(Code code) const {
+  if (trivial_) return code;
+
+  // Signature of each colour: its count in every position class, one nibble
+  // per class with class 0 most significant. Relabelling free colours only
+  // permutes the signatures of free colours, and permuting positions within
+  // a class changes none, so ranking the free colours by signature names
+  // them independently of the orbit member we started from.
+  std::array<std::uint32_t, kMaxColours> signature{};
+  for (unsigned i = 0; i < pegs_; ++i) {
+    signature[code.peg(i)] +=
+        std::uint32_t{1} << (kBitsPerPeg * (kMaxPegs - 1 - class_of_[i]));
+  }
+
+  std::array<std::uint8_t, kMaxColours> rename;
+  for (unsigned c = 0; c < colours_; ++c) {
+    rename[c] = static_cast<std::uint8_t>(c);
+  }
+  std::array<std::uint8_t, kMaxPegs> used{};
+  unsigned n_used = 0;
+  for (std::uint32_t rest = free_colours_; rest != 0; rest &= rest - 1) {
+    const auto c = static_cast<unsigned>(std::countr_zero(rest));
+    if (signature[c] != 0) used[n_used++] = static_cast<std::uint8_t>(c);
+  }
+  // Largest signature gets the lowest free colour; equal signatures are
+  // interchangeable, so their relative order does not matter.
+  sort_small(used.data(), n_used, [&](std::uint8_t a, std::uint8_t b) {
+    return signature[a] > signature[b];
+  });
+  std::uint32_t targets = free_colours_;
+  for (unsigned k = 0; k < n_used; ++k) {
+    rename[used[k]] = static_cast<std::uint8_t>(std::countr_zero(targets));
+    targets &= targets - 1;
+  }
+
+  // Within each position class, lay the renamed colours out in ascending
+  // order.
+  Code result;
+  for (unsigned k = 0; k < classes_; ++k) {
+    std::array<std::uint8_t, kMaxPegs> colours;
+    unsigned n = 0;
+    for (unsigned i = 0; i < pegs_; ++i) {
+      if (class_of_[i] == k) colours[n++] = rename[code.peg(i)];
+    }
+    sort_small(colours.data(), n, std::less<>());
+    unsigned j = 0;
+    for (unsigned i = 0; i < pegs_; ++i) {
+      if (class_of_[i] == k) result = result.with_peg(i, colours[j++]);
+    }
+  }
+  return result;
+}
+
+}  // namespace mastermyr
@@ -0,0 +1,236 @@
+#include "mastermyr/thread_pool.hpp"
+
+#include <limits>
+#include <utility>
+
+#include "mastermyr/numa.hpp"
+
+namespace mastermyr {
+namespace {
+
+// Index of the pool worker running on this thread, or -1 off the pool.
+thread_local int tls_worker = -1;
+thread_local const ThreadPool* tls_pool = nullptr;
+
+}  // namespace
+
+unsigned ThreadPool::default_threads() {
+  const unsigned hw = std::thread::hardware_concurrency();
+  return hw > 1 ? hw - 1 : 0;
+}
+
+ThreadPool::ThreadPool(unsigned threads, Placement placement)
+    : worker_node_(threads, 0), worker_cpu_(threads, -1) {
+  std::vector<std::pair<unsigned, unsigned>> slots;  // node, cpu
+  const unsigned nodes = placement == Placement::kPinned ? numa::nodes() : 1;
+  if (placement == Placement::kPinned) {
+    for (unsigned node = 0; node < nodes; ++node) {
+      for (const unsigned cpu : numa::cpus(node)) slots.emplace_back(node, cpu);
+    }
+  }
+  node_workers_.resize(slots.empty() ? 1 : nodes);
+  for (unsigned i = 0; i < threads; ++i) {
+    if (!slots.empty()) {
+      // Even spread: with more workers than CPUs each CPU gets several.
+      const auto& [node, cpu] =
+          slots[std::size_t{i} * slots.size() / threads % slots.size()];
+      worker_node_[i] = node;
+      worker_cpu_[i] = static_cast<int>(cpu);
+    }
+    node_workers_[worker_node_[i]].push_back(i);
+  }
+  for (std::size_t node = 0; node < node_workers_.size(); ++node) {
+    sleepers_.push_back(std::make_unique<Sleepers>());
+  }
+  queues_.reserve(threads);
+  for (unsigned i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  threads_.reserve(threads);
+  for (unsigned i = 0; i < threads; ++i) {
+    threads_.emplace_back([this, i] { worker_loop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(sleep_mutex_);
+    stopping_ = true;
+  }
+  for (const auto& sleepers : sleepers_) sleepers->wake.notify_all();
+  for (std::thread& thread : threads_) thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  if (queues_.empty()) {
+    task();
+    return;
+  }
+  const unsigned target =
+      tls_pool == this ? static_cast<unsigned>(tls_worker)
+                       : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                             static_cast<unsigned>(queues_.size());
+  push(target, std::move(task));
+}
+
+void ThreadPool::submit(std::function<void()> task, unsigned node) {
+  node %= nodes();
+  const std::vector<unsigned>& local = node_workers_[node];
+  if (local.empty()) {
+    submit(std::move(task));
+    return;
+  }
+  const unsigned target =
+      tls_pool == this && worker_node_[tls_worker] == node
+          ? static_cast<unsigned>(tls_worker)
+          : local[next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                  local.size()];
+  push(target, std::move(task));
+}
+
+void ThreadPool::push(unsigned queue, std::function<void()> task) {
+  {
+    std::lock_guard lock(queues_[queue]->mutex);
+    queues_[queue]->tasks.push_back(std::move(task));
+  }
+  pending_.fetch_add(1, std::memory_order_release);
+  // Taken so that a worker between its empty check and its wait cannot
+  // miss the notification. Another node's worker is woken only when the
+  // queue's own node has none asleep.
+  unsigned node = worker_node_[queue];
+  {
+    std::lock_guard lock(sleep_mutex_);
+    for (unsigned k = 0; k < sleepers_.size(); ++k) {
+      const unsigned candidate = (worker_node_[queue] + k) % nodes();
+      if (sleepers_[candidate]->count > 0) {
+        node = candidate;
+        break;
+      }
+    }
+  }
+  sleepers_[node]->wake.notify_one();
+}
+
+bool ThreadPool::try_pop(unsigned self, std::function<void()>& task) {
+  {
+    Queue& own = *queues_[self];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  // The own node's queues first, then the others'.
+  const auto count = static_cast<unsigned>(queues_.size());
+  const unsigned node = worker_node_[self];
+  const int passes = nodes() > 1 ? 2 : 1;
+  for (int pass = 0; pass < passes; ++pass) {
+    for (unsigned k = 1; k < count; ++k) {
+      const unsigned victim = (self + k) % count;
+      if ((worker_node_[victim] == node) == (pass == 0) &&
+          try_steal(victim, task)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::try_steal(unsigned victim, std::function<void()>& task) {
+  Queue& queue = *queues_[victim];
+  std::lock_guard lock(queue.mutex);
+  if (queue.tasks.empty()) return false;
+  task = std::move(queue.tasks.front());
+  queue.tasks.pop_front();
+  return true;
+}
+
+void ThreadPool::worker_loop(unsigned index) {
+  tls_worker = static_cast<int>(index);
+  tls_pool = this;
+  if (worker_cpu_[index] >= 0) {
+    numa::pin_to_cpu(static_cast<unsigned>(worker_cpu_[index]));
+  }
+  Sleepers& sleepers = *sleepers_[worker_node_[index]];
+  std::function<void()> task;
+  while (true) {
+    if (try_pop(index, task)) {
+      pending_.fetch_sub(1, std::memory_order_relaxed);
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock lock(sleep_mutex_);
+    ++sleepers.count;
+    sleepers.wake.wait(lock, [this] {
+      return stopping_ || pending_.load(std::memory_order_acquire) != 0;
+    });
+    --sleepers.count;
+    if (stopping_ && pending_.load(std::memory_order_acquire) == 0) return;
+  }
+}
+
+void ThreadPool::run_for(ForState& state) {
+  std::size_t chunks = (state.n + state.grain - 1) / state.grain;
+  constexpr std::size_t kMaxChunks = std::numeric_limits<std::uint32_t>::max();
+  if (chunks > kMaxChunks) {
+    state.grain = (state.n + kMaxChunks - 1) / kMaxChunks;
+    chunks = (state.n + state.grain - 1) / state.grain;
+  }
+  const std::size_t participants = state.ranges.size();
+  for (std::size_t p = 0; p < participants; ++p) {
+    const auto lo = static_cast<std::uint32_t>(chunks * p / participants);
+    const auto hi = static_cast<std::uint32_t>(chunks * (p + 1) / participants);
+    state.ranges[p].bounds.store(pack(lo, hi), std::memory_order_relaxed);
+  }
+  state.remaining.store(chunks, std::memory_order_release);
+}
+
+void ThreadPool::run_participant(ForState& state, unsigned participant) {
+  std::atomic<std::uint64_t>& own = state.ranges[participant].bounds;
+  const auto participants = static_cast<unsigned>(state.ranges.size());
+  while (true) {
+    // Drain our own run from the front.
+    std::uint64_t bounds = own.load(std::memory_order_acquire);
+    while (true) {
+      const auto lo = static_cast<std::uint32_t>(bounds);
+      const auto hi = static_cast<std::uint32_t>(bounds >> 32);
+      if (lo >= hi) break;
+      if (!own.compare_exchange_weak(bounds, pack(lo + 1, hi),
+                                     std::memory_order_acq_rel)) {
+        continue;
+      }
+      const std::size_t begin = std::size_t{lo} * state.grain;
+      const std::size_t end = std::min(state.n, begin + state.grain);
+      state.invoke(state.body, begin, end, participant);
+      if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        state.remaining.notify_all();
+      }
+      bounds = own.load(std::memory_order_acquire);
+    }
+
+    // Steal the back half of some other participant's run.
+    bool stole = false;
+    for (unsigned k = 1; k < participants && !stole; ++k) {
+      std::atomic<std::uint64_t>& victim =
+          state.ranges[(participant + k) % participants].bounds;
+      std::uint64_t v = victim.load(std::memory_order_acquire);
+      while (true) {
+        const auto lo = static_cast<std::uint32_t>(v);
+        const auto hi = static_cast<std::uint32_t>(v >> 32);
+        if (lo >= hi) break;
+        const std::uint32_t take = (hi - lo + 1) / 2;
+        if (victim.compare_exchange_weak(v, pack(lo, hi - take),
+                                         std::memory_order_acq_rel)) {
+          own.store(pack(hi - take, hi), std::memory_order_release);
+          stole = true;
+          break;
+        }
+      }
+    }
+    if (!stole) return;
+  }
+}
+
+}  // namespace mastermyr
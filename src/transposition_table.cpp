@@ -0,0 +1,120 @@
+#include "mastermyr/transposition_table.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "mastermyr/hash.hpp"
+#include "mastermyr/metrics.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr std::uint64_t kHiSeed = 0xc2b2ae3d27d4eb4full;
+
+std::uint64_t pack(const TranspositionTable::Entry& entry) {
+  std::uint32_t cost;
+  std::memcpy(&cost, &entry.cost, sizeof(cost));
+  return entry.guess.bits() | std::uint64_t{cost} << 32;
+}
+
+TranspositionTable::Entry unpack(std::uint64_t data) {
+  TranspositionTable::Entry entry;
+  entry.guess = Code(static_cast<std::uint32_t>(data));
+  const auto cost = static_cast<std::uint32_t>(data >> 32);
+  std::memcpy(&entry.cost, &cost, sizeof(cost));
+  return entry;
+}
+
+}  // namespace
+
+PositionKey position_key(const CandidateSet& candidates, std::uint64_t seed) {
+  const metrics::ScopedTimer timer(metrics::Phase::kTable);
+  const auto ids = candidates.ids();
+  return {hash_bytes(ids.data(), ids.size_bytes(), seed),
+          hash_bytes(ids.data(), ids.size_bytes(), seed ^ kHiSeed)};
+}
+
+TranspositionTable::TranspositionTable(std::size_t bytes) {
+  const std::size_t buckets = std::bit_floor(
+      std::max<std::size_t>(bytes / sizeof(Bucket), 1));
+  buckets_ = std::make_unique<Bucket[]>(buckets);
+  mask_ = buckets - 1;
+}
+
+std::optional<TranspositionTable::Entry> TranspositionTable::lookup(
+    const PositionKey& key) {
+  const metrics::ScopedTimer timer(metrics::Phase::kTable);
+  Bucket& b = bucket(key);
+  for (unsigned way = 0; way < kWays; ++way) {
+    const Slot& slot = b.slots[way];
+    const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check_lo.load(std::memory_order_relaxed) ^ data) == key.lo &&
+        (slot.check_hi.load(std::memory_order_relaxed) ^ data) == key.hi) {
+      const std::uint64_t mark = std::uint64_t{1} << way;
+      if (!(b.clock.load(std::memory_order_relaxed) & mark)) {
+        b.clock.fetch_or(mark, std::memory_order_relaxed);
+      }
+      hits_.value.fetch_add(1, std::memory_order_relaxed);
+      metrics::add(metrics::Counter::kTableHits);
+      return unpack(data);
+    }
+  }
+  misses_.value.fetch_add(1, std::memory_order_relaxed);
+  metrics::add(metrics::Counter::kTableMisses);
+  return std::nullopt;
+}
+
+void TranspositionTable::store(const PositionKey& key, const Entry& entry) {
+  const metrics::ScopedTimer timer(metrics::Phase::kTable);
+  Bucket& b = bucket(key);
+  const std::uint64_t data = pack(entry);
+  // Overwrite the entry for the same key if there is one, else pick a victim
+  // by the clock. Concurrent inserts may pick the same victim; one of them
+  // wins, which is all a cache needs.
+  unsigned victim = kWays;
+  for (unsigned way = 0; way < kWays && victim == kWays; ++way) {
+    const Slot& slot = b.slots[way];
+    const std::uint64_t old = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check_lo.load(std::memory_order_relaxed) ^ old) == key.lo &&
+        (slot.check_hi.load(std::memory_order_relaxed) ^ old) == key.hi) {
+      victim = way;
+    }
+  }
+  std::uint64_t clock = b.clock.load(std::memory_order_relaxed);
+  if (victim == kWays) {
+    unsigned hand = (clock >> kWays) & 1;
+    while (clock & (std::uint64_t{1} << hand)) {
+      clock &= ~(std::uint64_t{1} << hand);
+      hand = (hand + 1) % kWays;
+    }
+    victim = hand;
+    clock = (clock & ((1u << kWays) - 1)) |
+            std::uint64_t{(hand + 1) % kWays} << kWays;
+    b.clock.store(clock, std::memory_order_relaxed);
+  }
+  Slot& slot = b.slots[victim];
+  slot.data.store(data, std::memory_order_relaxed);
+  slot.check_lo.store(key.lo ^ data, std::memory_order_relaxed);
+  slot.check_hi.store(key.hi ^ data, std::memory_order_relaxed);
+  stores_.value.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    for (Slot& slot : buckets_[i].slots) {
+      slot.data.store(0, std::memory_order_relaxed);
+      slot.check_lo.store(0, std::memory_order_relaxed);
+      slot.check_hi.store(0, std::memory_order_relaxed);
+    }
+    buckets_[i].clock.store(0, std::memory_order_relaxed);
+  }
+}
+
+TranspositionTable::Stats TranspositionTable::stats() const {
+  return {hits_.value.load(std::memory_order_relaxed),
+          misses_.value.load(std::memory_order_relaxed),
+          stores_.value.load(std::memory_order_relaxed)};
+}
+
+}  // namespace mastermyr
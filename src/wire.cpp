@@ -0,0 +1,114 @@
+#include "mastermyr/wire.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <istream>
+#include <string>
+
+namespace mastermyr::wire {
+namespace {
+
+static_assert(std::endian::native == std::endian::little,
+              "frames are read and written in host byte order");
+
+template <typename T>
+std::byte* store(std::byte* p, T value) {
+  std::memcpy(p, &value, sizeof(value));
+  return p + sizeof(value);
+}
+
+}  // namespace
+
+bool GameStateView::valid_moves() const {
+  const unsigned n = pegs();
+  if (n == 0 || n > kMaxPegs || colours() > kMaxColours) return false;
+  for (std::size_t i = 0; i < size(); ++i) {
+    const Move move = (*this)[i];
+    if ((move.guess.bits() & ~peg_mask(n)) != 0 ||
+        move.feedback.black() + move.feedback.white() > n) {
+      return false;
+    }
+    for (unsigned p = 0; p < n; ++p) {
+      if (move.guess.peg(p) >= colours()) return false;
+    }
+  }
+  return true;
+}
+
+void append_game_state(std::vector<std::byte>& out, std::uint64_t game,
+                       unsigned pegs, unsigned colours,
+                       std::span<const Move> moves) {
+  if (moves.size() > kMaxMoves) {
+    throw std::invalid_argument("a game state holds at most " +
+                                std::to_string(kMaxMoves) + " moves");
+  }
+  const std::size_t body = kStateHeader + moves.size() * kMoveSize;
+  const std::size_t at = out.size();
+  out.resize(at + kLengthPrefix + body);
+  std::byte* p = out.data() + at;
+  p = store(p, static_cast<std::uint32_t>(body));
+  p = store(p, game);
+  p = store(p, static_cast<std::uint8_t>(pegs));
+  p = store(p, static_cast<std::uint8_t>(colours));
+  p = store(p, static_cast<std::uint8_t>(moves.size()));
+  for (const Move& move : moves) {
+    p = store(p, move.guess.bits());
+    p = store(p, move.feedback.raw());
+  }
+}
+
+void write_answer(std::byte* out, std::uint64_t game, Status status,
+                  Code guess) {
+  out = store(out, static_cast<std::uint32_t>(kAnswerBody));
+  out = store(out, game);
+  out = store(out, static_cast<std::uint8_t>(status));
+  store(out, guess.bits());
+}
+
+void append_answer(std::vector<std::byte>& out, std::uint64_t game,
+                   Status status, Code guess) {
+  out.resize(out.size() + kAnswerFrame);
+  write_answer(out.data() + out.size() - kAnswerFrame, game, status, guess);
+}
+
+GameStateReader::GameStateReader(std::istream& in, std::size_t buffer)
+    : in_(in),
+      buffer_(std::max(buffer, kLengthPrefix + kMaxStateBody)) {}
+
+std::span<const GameStateView> GameStateReader::next_batch(
+    std::size_t max_states) {
+  batch_.clear();
+  // Keep the incomplete frame left by the last batch and top the buffer up.
+  std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+  end_ -= begin_;
+  begin_ = 0;
+  if (in_ && end_ < buffer_.size()) {
+    in_.read(reinterpret_cast<char*>(buffer_.data() + end_),
+             static_cast<std::streamsize>(buffer_.size() - end_));
+    end_ += static_cast<std::size_t>(in_.gcount());
+  }
+
+  FrameReader frames({buffer_.data(), end_}, kMaxStateBody);
+  std::span<const std::byte> body;
+  while (batch_.size() < max_states) {
+    const FrameReader::Result result = frames.next(body);
+    if (result == FrameReader::Result::kPartial) break;
+    const auto state = result == FrameReader::Result::kFrame
+                           ? GameStateView::parse(body)
+                           : std::nullopt;
+    if (!state) {
+      throw WireError("malformed game state after " +
+                      std::to_string(count_ + batch_.size()) + " states");
+    }
+    batch_.push_back(*state);
+  }
+  begin_ = frames.consumed();
+  if (batch_.empty() && end_ != 0 && !in_) {
+    throw WireError("stream ends inside a frame after " +
+                    std::to_string(count_) + " states");
+  }
+  count_ += batch_.size();
+  return batch_;
+}
+
+}  // namespace mastermyr::wire
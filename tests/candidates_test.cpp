@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mastermyr/candidate_generator.hpp"
+#include "mastermyr/candidate_set.hpp"
+#include "mastermyr/compact_candidates.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/propagator.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+using testing::Board;
+
+// Random histories: mostly true feedback for a hidden secret, and every
+// third one with made-up feedback that is usually contradictory.
+std::vector<Move> random_history(std::mt19937_64& rng, unsigned pegs,
+                                 unsigned colours, int round) {
+  const Code secret = testing::random_code(rng, pegs, colours);
+  std::vector<Move> history(rng() % 7);
+  for (Move& move : history) {
+    move.guess = testing::random_code(rng, pegs, colours);
+    move.feedback = score(move.guess, secret, pegs);
+    if (round % 3 == 0) {
+      const unsigned black = rng() % (pegs + 1);
+      const unsigned white = rng() % (pegs + 1 - black);
+      move.feedback = Feedback(black, white);
+    }
+  }
+  return history;
+}
+
+std::vector<Code> consistent_codes(const std::vector<Code>& codes,
+                                   const std::vector<Move>& history,
+                                   unsigned pegs) {
+  std::vector<Code> out;
+  for (const Code code : codes) {
+    if (std::all_of(history.begin(), history.end(), [&](const Move& m) {
+          return score(m.guess, code, pegs) == m.feedback;
+        })) {
+      out.push_back(code);
+    }
+  }
+  return out;
+}
+
+class Candidates : public ::testing::TestWithParam<Board> {};
+
+TEST_P(Candidates, FilterKeepsExactlyTheConsistentCodes) {
+  const auto [pegs, colours] = GetParam();
+  const std::vector<Code> codes = testing::all_codes(pegs, colours);
+  std::mt19937_64 rng(pegs * 31 + colours);
+  for (int round = 0; round < 60; ++round) {
+    const std::vector<Move> history =
+        random_history(rng, pegs, colours, round);
+    CandidateSet set;
+    set.assign_all(pegs, colours);
+    for (const Move& move : history) set.filter(move.guess, move.feedback, pegs);
+    const std::vector<Code> want = consistent_codes(codes, history, pegs);
+    ASSERT_TRUE(std::equal(set.codes().begin(), set.codes().end(),
+                           want.begin(), want.end()));
+    for (std::size_t i = 0; i < set.size(); ++i) {
+      ASSERT_EQ(set.codes()[i], codes[set.ids()[i]]);
+    }
+  }
+}
+
+TEST_P(Candidates, FilterByMatrixRowMatchesFilterByScore) {
+  const auto [pegs, colours] = GetParam();
+  const FeedbackMatrix matrix =
+      FeedbackMatrix::build({pegs, colours, DuplicateRule::kAllowed});
+  std::mt19937_64 rng(pegs * 37 + colours);
+  for (int round = 0; round < 60; ++round) {
+    CandidateSet by_score;
+    CandidateSet by_row;
+    by_score.assign_all(pegs, colours);
+    by_row.assign_all(pegs, colours);
+    for (const Move& move : random_history(rng, pegs, colours, round)) {
+      by_score.filter(move.guess, move.feedback, pegs);
+      by_row.filter(matrix.row(code_index(move.guess, pegs, colours)),
+                    move.feedback);
+    }
+    ASSERT_TRUE(std::equal(by_score.ids().begin(), by_score.ids().end(),
+                           by_row.ids().begin(), by_row.ids().end()));
+  }
+}
+
+// Compact sets, dense or sparse, hold the filtered ids and answer rank and
+// select over them; intersecting with feedback bitmaps filters like score.
+TEST_P(Candidates, CompactSetsMatchTheFilteredSet) {
+  const auto [pegs, colours] = GetParam();
+  const std::vector<Code> codes = testing::all_codes(pegs, colours);
+  CandidateSet all;
+  all.assign_all(pegs, colours);
+  std::mt19937_64 rng(pegs * 41 + colours);
+  bool saw_dense = false;
+  bool saw_sparse = false;
+  for (int round = 0; round < 60; ++round) {
+    CandidateSet set = all;
+    CompactCandidates compact(all, codes.size());
+    for (const Move& move : random_history(rng, pegs, colours, round)) {
+      set.filter(move.guess, move.feedback, pegs);
+      compact.intersect(
+          FeedbackBitmaps(move.guess, pegs, colours).of(move.feedback));
+    }
+    ASSERT_EQ(compact.size(), set.size());
+    saw_dense |= compact.dense() && compact.size() > 0;
+    saw_sparse |= !compact.dense() && compact.size() > 0;
+    for (std::size_t i = 0; i < set.size(); ++i) {
+      ASSERT_EQ(compact.select(i), set.ids()[i]);
+      ASSERT_EQ(compact.rank(set.ids()[i]), i);
+    }
+    for (std::uint32_t id = 0; id < codes.size(); ++id) {
+      ASSERT_EQ(compact.contains(id),
+                std::binary_search(set.ids().begin(), set.ids().end(), id));
+    }
+    ASSERT_EQ(compact.rank(static_cast<std::uint32_t>(codes.size())),
+              set.size());
+
+    const CompactCandidates saved(set, codes.size());
+    EXPECT_EQ(saved.dense(), compact.dense());
+    const CandidateSet* const sources[] = {&all, nullptr};
+    for (const CandidateSet* source : sources) {
+      CandidateSet expanded;
+      saved.expand(expanded, pegs, colours, source);
+      ASSERT_TRUE(std::equal(expanded.ids().begin(), expanded.ids().end(),
+                             set.ids().begin(), set.ids().end()));
+      ASSERT_TRUE(std::equal(expanded.codes().begin(), expanded.codes().end(),
+                             set.codes().begin(), set.codes().end()));
+    }
+  }
+  EXPECT_TRUE(saw_dense);
+  // Any code is one in 32 of the smallest boards.
+  if (codes.size() > 4 * CompactCandidates::kDenseRatio) {
+    EXPECT_TRUE(saw_sparse);
+  }
+}
+
+// The generator yields each consistent code once, in any seed's order.
+TEST_P(Candidates, GeneratorYieldsTheConsistentSet) {
+  const auto [pegs, colours] = GetParam();
+  const std::vector<Code> codes = testing::all_codes(pegs, colours);
+  std::mt19937_64 rng(pegs * 41 + colours);
+  for (int round = 0; round < 60; ++round) {
+    const std::vector<Move> history =
+        random_history(rng, pegs, colours, round);
+    const std::vector<Code> want = consistent_codes(codes, history, pegs);
+    for (const std::uint64_t seed : {0, 77, 1234567}) {
+      CandidateGenerator generator(pegs, colours, history, seed);
+      std::vector<Code> got;
+      while (const std::optional<Code> code = generator.next()) {
+        got.push_back(*code);
+      }
+      ASSERT_TRUE(generator.exhausted());
+      ASSERT_EQ(generator.produced(), got.size());
+      std::sort(got.begin(), got.end(), [&](Code a, Code b) {
+        return code_index(a, pegs, colours) < code_index(b, pegs, colours);
+      });
+      ASSERT_EQ(got, want) << "seed " << seed;
+    }
+  }
+}
+
+// Random descents only reach consistent codes, reach every first colour
+// the set has, and their weights average to the size of the set.
+TEST(CandidateGenerator, DrawsSampleTheWholeSetAndEstimateItsSize) {
+  constexpr unsigned kPegs = 6;
+  constexpr unsigned kColours = 8;
+  const std::vector<Code> codes = testing::all_codes(kPegs, kColours);
+  std::mt19937_64 rng(19);
+  const Code secret = testing::random_code(rng, kPegs, kColours);
+  std::vector<Move> history;
+  for (const char* guess : {"001122", "334455"}) {
+    const Code code = *parse_code(guess, kPegs, kColours);
+    history.push_back({code, score(code, secret, kPegs)});
+  }
+  const std::vector<Code> want = consistent_codes(codes, history, kPegs);
+  const std::set<Code> consistent(want.begin(), want.end());
+  std::set<unsigned> first_colours;
+  for (const Code code : want) first_colours.insert(code.peg(0));
+
+  CandidateGenerator generator(kPegs, kColours, history);
+  constexpr int kDraws = 20000;
+  double total = 0;
+  std::set<unsigned> drawn_first;
+  for (int i = 0; i < kDraws; ++i) {
+    double weight;
+    const std::optional<Code> code = generator.draw(rng, weight);
+    total += weight;
+    if (!code) continue;
+    ASSERT_TRUE(consistent.contains(*code)) << to_string(*code, kPegs);
+    drawn_first.insert(code->peg(0));
+  }
+  EXPECT_EQ(drawn_first, first_colours);
+  EXPECT_NEAR(total / kDraws, static_cast<double>(want.size()),
+              0.05 * static_cast<double>(want.size()));
+}
+
+// Propagation never removes a consistent code, proves inconsistency only
+// when there is none, and possible() is exactly membership.
+TEST_P(Candidates, PropagatorIsSoundAndPossibleIsExact) {
+  const auto [pegs, colours] = GetParam();
+  const std::vector<Code> codes = testing::all_codes(pegs, colours);
+  std::mt19937_64 rng(pegs * 43 + colours);
+  for (int round = 0; round < 60; ++round) {
+    const std::vector<Move> history =
+        random_history(rng, pegs, colours, round);
+    const std::vector<Code> want = consistent_codes(codes, history, pegs);
+    const std::set<Code> consistent(want.begin(), want.end());
+    Propagator propagator(pegs, colours);
+    propagator.add(history);
+    if (!propagator.consistent()) {
+      ASSERT_TRUE(want.empty());
+    }
+    ASSERT_EQ(propagator.satisfiable(), !want.empty());
+    ASSERT_GE(propagator.space_size(), static_cast<double>(want.size()));
+    for (const Code code : codes) {
+      const bool in = consistent.contains(code);
+      if (in) {
+        ASSERT_TRUE(propagator.admits(code)) << to_string(code, pegs);
+      }
+      ASSERT_EQ(propagator.possible(code), in) << to_string(code, pegs);
+    }
+  }
+}
+
+TEST(Propagator, NoMatchesRemovesColours) {
+  Propagator propagator(4, 6);
+  ASSERT_TRUE(propagator.add({*parse_code("0011", 4, 6), Feedback(0, 0)}));
+  for (unsigned peg = 0; peg < 4; ++peg) {
+    EXPECT_EQ(propagator.domain(peg), 0b111100);
+  }
+  EXPECT_EQ(propagator.max_count(0), 0u);
+  EXPECT_EQ(propagator.max_count(1), 0u);
+  // Four blacks on a removed colour cannot happen.
+  EXPECT_FALSE(propagator.add({*parse_code("0000", 4, 6), Feedback(4, 0)}));
+  EXPECT_FALSE(propagator.consistent());
+}
+
+INSTANTIATE_TEST_SUITE_P(Boards, Candidates,
+                         ::testing::Values(Board{2, 3}, Board{3, 5},
+                                           Board{4, 6}, Board{5, 5}),
+                         [](const auto& info) {
+                           return std::to_string(info.param.pegs) + "x" +
+                                  std::to_string(info.param.colours);
+                         });
+
+}  // namespace
+}  // namespace mastermyr
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/numa.hpp"
+#include "mastermyr/strategy_tree.hpp"
+#include "mastermyr/thread_pool.hpp"
+
+namespace mastermyr {
+namespace {
+
+const BoardKey kKey{4, 6, DuplicateRule::kAllowed};
+
+TEST(Numa, TopologyCoversTheAllowedCpus) {
+  const unsigned nodes = numa::nodes();
+  ASSERT_GE(nodes, 1u);
+  EXPECT_LT(numa::current_node(), nodes);
+  std::vector<unsigned> all;
+  for (unsigned node = 0; node < nodes; ++node) {
+    const std::vector<unsigned> cpus = numa::cpus(node);
+    EXPECT_TRUE(std::is_sorted(cpus.begin(), cpus.end()));
+    all.insert(all.end(), cpus.begin(), cpus.end());
+  }
+  ASSERT_FALSE(all.empty());
+  std::sort(all.begin(), all.end());
+  EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end())
+      << "a CPU on two nodes";
+  EXPECT_TRUE(numa::cpus(nodes).empty());
+}
+
+TEST(Numa, NodeBufferHoldsItsBytesAndMoves) {
+  numa::NodeBuffer buffer(std::size_t{1} << 20, numa::nodes() - 1);
+  ASSERT_NE(buffer.data(), nullptr);
+  ASSERT_EQ(buffer.size(), std::size_t{1} << 20);
+  std::memset(buffer.data(), 0x5a, buffer.size());
+  numa::NodeBuffer moved = std::move(buffer);
+  EXPECT_EQ(buffer.data(), nullptr);
+  EXPECT_EQ(moved.data()[moved.size() - 1], std::byte{0x5a});
+  EXPECT_EQ(numa::NodeBuffer(0, 0).data(), nullptr);
+}
+
+TEST(Numa, ReplicasMatchTheOriginal) {
+  auto matrix =
+      std::make_shared<const FeedbackMatrix>(FeedbackMatrix::build(kKey));
+  const numa::Replicated<FeedbackMatrix> matrices(matrix);
+  auto tree = std::make_shared<const StrategyTree>(
+      StrategyTree::compile(kKey.pegs, kKey.colours, {}));
+  const numa::Replicated<StrategyTree> trees(tree);
+  for (unsigned node = 0; node < numa::nodes(); ++node) {
+    const FeedbackMatrix& copy = *matrices.on(node);
+    ASSERT_EQ(copy.size(), matrix->size());
+    for (std::uint32_t g = 0; g < copy.size(); ++g) {
+      ASSERT_TRUE(std::equal(copy.row(g).begin(), copy.row(g).end(),
+                             matrix->row(g).begin()));
+    }
+    const StrategyTree& tree_copy = *trees.on(node);
+    ASSERT_EQ(tree_copy.size(), tree->size());
+    EXPECT_EQ(tree_copy.depth(), tree->depth());
+    EXPECT_EQ(evaluate(tree_copy).games, evaluate(*tree).games);
+  }
+  EXPECT_EQ(matrices.local(), matrices.on(numa::current_node()));
+
+  const StrategyTree copy = tree->copy_to_node(0);
+  for (StrategyTree::NodeIndex node = 0; node < tree->size(); ++node) {
+    ASSERT_EQ(copy.guess(node), tree->guess(node));
+    ASSERT_EQ(copy.candidates(node), tree->candidates(node));
+  }
+}
+
+TEST(Numa, PinnedPoolRunsEveryTask) {
+  ThreadPool pool(3, ThreadPool::Placement::kPinned);
+  ASSERT_EQ(pool.nodes(), numa::nodes());
+  for (unsigned worker = 0; worker < pool.workers(); ++worker) {
+    EXPECT_LT(pool.worker_node(worker), pool.nodes());
+  }
+
+  std::vector<std::uint64_t> sums(pool.concurrency());
+  pool.parallel_for(100000, 64, [&](std::size_t begin, std::size_t end,
+                                    unsigned participant) {
+    for (std::size_t i = begin; i < end; ++i) sums[participant] += i;
+  });
+  EXPECT_EQ(std::accumulate(sums.begin(), sums.end(), std::uint64_t{0}),
+            std::uint64_t{100000} * 99999 / 2);
+
+  constexpr int kTasks = 200;
+  std::atomic<int> done{0};
+  for (int i = 0; i < kTasks; ++i) {
+    pool.submit(
+        [&] {
+          if (done.fetch_add(1) + 1 == kTasks) done.notify_all();
+        },
+        static_cast<unsigned>(i));
+  }
+  for (int n = done.load(); n != kTasks; n = done.load()) done.wait(n);
+}
+
+}  // namespace
+}  // namespace mastermyr
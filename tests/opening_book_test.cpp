@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mastermyr/opening_book.hpp"
+#include "mastermyr/wire.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr unsigned kPegs = 4;
+constexpr unsigned kColours = 6;
+const BoardKey kKey{kPegs, kColours, DuplicateRule::kAllowed};
+
+// The moves the default solver makes against `secret`.
+std::vector<Move> solver_game(GameSolver& solver, Code secret) {
+  solver.reset();
+  std::vector<Move> moves;
+  while (!solver.solved()) {
+    const Code guess = solver.next_guess();
+    const Feedback feedback = score(guess, secret, kPegs);
+    solver.record(guess, feedback);
+    moves.push_back({guess, feedback});
+  }
+  return moves;
+}
+
+// A day's log: self-played games, skewed towards a few secrets so that
+// their positions dominate.
+std::string recorded_games(std::vector<std::vector<Move>>& games) {
+  const std::unique_ptr<GameSolver> solver = make_solver(kPegs, kColours);
+  const std::vector<Code> secrets = testing::all_codes(kPegs, kColours);
+  std::mt19937_64 rng(30);
+  std::vector<std::byte> frames;
+  for (std::uint64_t game = 0; game < 600; ++game) {
+    const std::size_t pick = rng() % 4 == 0 ? rng() % secrets.size()
+                                            : rng() % 8;
+    games.push_back(solver_game(*solver, secrets[pick]));
+    wire::append_game_state(frames, game, kPegs, kColours, games.back());
+  }
+  return {reinterpret_cast<const char*>(frames.data()), frames.size()};
+}
+
+// Every position a game needed a guess in counts once; the solved one, other
+// boards and malformed games do not.
+TEST(HistoryCounts, CountsEveryPositionOnce) {
+  std::vector<std::vector<Move>> games;
+  std::string log = recorded_games(games);
+  std::vector<std::byte> extra;
+  wire::append_game_state(extra, 1, 5, 8, games[0]);
+  const std::vector<Move> off_board = {{Code(0x7), Feedback(0, 0)}};
+  wire::append_game_state(extra, 2, kPegs, kColours, off_board);
+  log.append(reinterpret_cast<const char*>(extra.data()), extra.size());
+
+  HistoryCounts counts(kKey, 8);
+  std::istringstream in(log);
+  counts.ingest(in);
+  EXPECT_EQ(counts.games(), games.size());
+  EXPECT_EQ(counts.skipped(), 2u);
+  EXPECT_EQ(counts.error(), 0u);
+  EXPECT_EQ(counts.count({}), games.size());
+
+  const std::vector<Move>& game = games[0];
+  std::uint64_t same_start = 0;
+  for (const std::vector<Move>& other : games) {
+    same_start += other.size() > 1 && other[0].guess == game[0].guess &&
+                  other[0].feedback == game[0].feedback;
+  }
+  EXPECT_EQ(counts.count(std::span(game).first(1)), same_start);
+  EXPECT_GT(counts.count(std::span(game).first(game.size() - 1)), 0u);
+  EXPECT_EQ(counts.count(game), 0u);
+
+  std::vector<Move> moves;
+  counts.history(counts.find(std::span(game).first(2)), moves);
+  ASSERT_EQ(moves.size(), 2u);
+  EXPECT_EQ(moves[1].guess, game[1].guess);
+}
+
+// A trie capped below its size drops the rare positions and keeps the
+// common ones exactly counted.
+TEST(HistoryCounts, PruningKeepsTheFrequentPositions) {
+  std::mt19937_64 rng(31);
+  const std::vector<Move> common = {{Code(0x0011), Feedback(1, 0)},
+                                    {Code(0x0122), Feedback(0, 2)}};
+  HistoryCounts counts(kKey, 6, 64);
+  for (int game = 0; game < 2000; ++game) {
+    if (game % 3 == 0) {
+      counts.add(common);
+      continue;
+    }
+    std::vector<Move> moves(3);
+    for (Move& move : moves) {
+      move.guess = testing::random_code(rng, kPegs, kColours);
+      move.feedback = Feedback(static_cast<unsigned>(rng() % 3), 0);
+    }
+    counts.add(moves);
+  }
+  EXPECT_LE(counts.size(), 64u);
+  EXPECT_GT(counts.error(), 0u);
+  EXPECT_EQ(counts.count(common), 667u);
+  EXPECT_EQ(counts.count({}), 2000u);
+}
+
+// The book's guesses are the solver's, it covers the most frequent
+// positions, and it round-trips through a file as a partial tree.
+TEST(OpeningBook, AnswersTheFrequentPositionsAsTheSolverWould) {
+  std::vector<std::vector<Move>> games;
+  std::istringstream in(recorded_games(games));
+  HistoryCounts counts(kKey);
+  counts.ingest(in);
+  const StrategyTree book = build_opening_book(counts, 40, {});
+  EXPECT_FALSE(book.complete());
+  EXPECT_LE(book.size(), 40u);
+  EXPECT_GT(book_coverage(book, counts), 0.7);
+
+  const std::filesystem::path file =
+      std::filesystem::path(::testing::TempDir()) / "opening-book.bin";
+  book.save(file);
+  const auto loaded =
+      std::make_shared<const StrategyTree>(StrategyTree::load(file, kKey));
+  std::filesystem::remove(file);
+  EXPECT_FALSE(loaded->complete());
+  EXPECT_EQ(loaded->size(), book.size());
+  EXPECT_THROW(make_tree_solver(loaded), std::invalid_argument);
+
+  std::size_t hits = 0;
+  for (const std::vector<Move>& game : games) {
+    for (std::size_t n = 0; n < game.size(); ++n) {
+      const std::span<const Move> prefix = std::span(game).first(n);
+      const std::optional<Code> guess = loaded->lookup(prefix);
+      if (!guess) continue;
+      ++hits;
+      ASSERT_EQ(*guess, game[n].guess) << "after " << n << " moves";
+    }
+  }
+  // Every game starts in the book.
+  EXPECT_GE(hits, games.size());
+  const std::vector<Move> off_book = {{Code(0x5432), Feedback(0, 0)}};
+  EXPECT_FALSE(loaded->lookup(std::span<const Move>(off_book)));
+}
+
+}  // namespace
+}  // namespace mastermyr
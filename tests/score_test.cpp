@@ -0,0 +1,312 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mastermyr/boards.hpp"
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/hash.hpp"
+#include "mastermyr/partition_backend.hpp"
+#include "mastermyr/score.hpp"
+#include "mastermyr/solver.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+using testing::Board;
+
+// The textbook definition: mark exact matches, then pair each remaining
+// guess peg with an unused secret peg of its colour.
+Feedback oracle(Code guess, Code secret, unsigned pegs) {
+  std::array<bool, kMaxPegs> used_guess{};
+  std::array<bool, kMaxPegs> used_secret{};
+  unsigned black = 0;
+  for (unsigned i = 0; i < pegs; ++i) {
+    if (guess.peg(i) == secret.peg(i)) {
+      ++black;
+      used_guess[i] = used_secret[i] = true;
+    }
+  }
+  unsigned white = 0;
+  for (unsigned i = 0; i < pegs; ++i) {
+    if (used_guess[i]) continue;
+    for (unsigned j = 0; j < pegs; ++j) {
+      if (!used_secret[j] && guess.peg(i) == secret.peg(j)) {
+        used_secret[j] = true;
+        ++white;
+        break;
+      }
+    }
+  }
+  return Feedback(black, white);
+}
+
+using Kernel = void (*)(Code, const Code*, std::size_t, Feedback*, unsigned);
+
+std::vector<std::pair<std::string, Kernel>> kernels_under_test() {
+  std::vector<std::pair<std::string, Kernel>> kernels = {
+      {"dispatch", score_batch}, {"scalar", kernels::score_batch_scalar}};
+#if defined(MASTERMYR_HAVE_AVX2)
+  if (isa_supported(Isa::kAvx2)) {
+    kernels.emplace_back("avx2", kernels::score_batch_avx2);
+  }
+#endif
+#if defined(MASTERMYR_HAVE_AVX512)
+  if (isa_supported(Isa::kAvx512)) {
+    kernels.emplace_back("avx512", kernels::score_batch_avx512);
+  }
+#endif
+#if defined(MASTERMYR_HAVE_NEON)
+  if (isa_supported(Isa::kNeon)) {
+    kernels.emplace_back("neon", kernels::score_batch_neon);
+  }
+#endif
+  return kernels;
+}
+
+class ExhaustiveScore : public ::testing::TestWithParam<Board> {};
+
+// Every guess against every secret, through every kernel, at every batch
+// length modulo the vector widths (the candidates start at each offset).
+TEST_P(ExhaustiveScore, KernelsMatchReference) {
+  const auto [pegs, colours] = GetParam();
+  const std::vector<Code> codes = testing::all_codes(pegs, colours);
+  std::vector<Feedback> want(codes.size());
+  std::vector<Feedback> got(codes.size());
+  for (const auto& [name, kernel] : kernels_under_test()) {
+    for (const Code guess : codes) {
+      for (std::size_t i = 0; i < codes.size(); ++i) {
+        want[i] = score(guess, codes[i], pegs);
+      }
+      const std::size_t skip = guess.bits() % std::min<std::size_t>(
+                                                   17, codes.size());
+      kernel(guess, codes.data() + skip, codes.size() - skip,
+             got.data() + skip, pegs);
+      ASSERT_TRUE(std::equal(want.begin() + skip, want.end(),
+                             got.begin() + skip))
+          << name << " guess " << to_string(guess, pegs);
+    }
+  }
+}
+
+TEST_P(ExhaustiveScore, ReferenceMatchesOracle) {
+  const auto [pegs, colours] = GetParam();
+  const std::vector<Code> codes = testing::all_codes(pegs, colours);
+  for (const Code guess : codes) {
+    for (const Code secret : codes) {
+      ASSERT_EQ(score(guess, secret, pegs), oracle(guess, secret, pegs))
+          << to_string(guess, pegs) << " vs " << to_string(secret, pegs);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(SmallBoards, ExhaustiveScore,
+                         ::testing::Values(Board{1, 2}, Board{2, 3},
+                                           Board{3, 5}, Board{4, 6}),
+                         [](const auto& info) {
+                           return std::to_string(info.param.pegs) + "x" +
+                                  std::to_string(info.param.colours);
+                         });
+
+class RandomScore : public ::testing::TestWithParam<Board> {};
+
+// Properties that hold on any board: bounded pins, symmetry, a code against
+// itself, and invariance under relabelling colours and permuting pegs.
+TEST_P(RandomScore, Properties) {
+  const auto [pegs, colours] = GetParam();
+  std::mt19937_64 rng(pegs * 100 + colours);
+  const std::size_t n = 4099;
+  std::vector<Code> secrets(n);
+  std::vector<Feedback> got(n);
+  for (int round = 0; round < 64; ++round) {
+    const Code guess = testing::random_code(rng, pegs, colours);
+    for (Code& secret : secrets) {
+      secret = testing::random_code(rng, pegs, colours);
+    }
+    std::array<unsigned, kMaxColours> relabel{};
+    std::iota(relabel.begin(), relabel.begin() + colours, 0u);
+    std::shuffle(relabel.begin(), relabel.begin() + colours, rng);
+    std::array<unsigned, kMaxPegs> order{};
+    std::iota(order.begin(), order.begin() + pegs, 0u);
+    std::shuffle(order.begin(), order.begin() + pegs, rng);
+    auto transform = [&](Code code) {
+      Code out;
+      for (unsigned i = 0; i < pegs; ++i) {
+        out = out.with_peg(order[i], relabel[code.peg(i)]);
+      }
+      return out;
+    };
+
+    for (const auto& [name, kernel] : kernels_under_test()) {
+      kernel(guess, secrets.data(), n, got.data(), pegs);
+      for (std::size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(got[i], oracle(guess, secrets[i], pegs)) << name;
+      }
+    }
+    ASSERT_EQ(score(guess, guess, pegs), solved_feedback(pegs));
+    for (const Code secret : secrets) {
+      const Feedback f = score(guess, secret, pegs);
+      ASSERT_LE(f.black() + f.white(), pegs);
+      ASSERT_FALSE(f.black() == pegs - 1 && f.white() == 1);
+      ASSERT_EQ(f, score(secret, guess, pegs));
+      ASSERT_EQ(f, score(transform(guess), transform(secret), pegs));
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(LargeBoards, RandomScore,
+                         ::testing::Values(Board{5, 8}, Board{6, 10},
+                                           Board{7, 12}, Board{8, 12},
+                                           Board{8, 16}),
+                         [](const auto& info) {
+                           return std::to_string(info.param.pegs) + "x" +
+                                  std::to_string(info.param.colours);
+                         });
+
+// score_batch runs the widest kernel the CPU has unless MASTERMYR_ISA
+// names another one it has.
+TEST(Dispatch, PicksSupportedKernel) {
+  EXPECT_TRUE(isa_supported(Isa::kScalar));
+  const Isa active = active_isa();
+  ASSERT_TRUE(isa_supported(active)) << isa_name(active);
+  const char* forced = std::getenv("MASTERMYR_ISA");
+  if (forced != nullptr && *forced != '\0') {
+    GTEST_SKIP() << "MASTERMYR_ISA=" << forced;
+  }
+  for (const Isa isa : {Isa::kAvx512, Isa::kAvx2, Isa::kNeon}) {
+    if (isa_supported(isa)) {
+      EXPECT_EQ(active, isa) << isa_name(isa);
+      return;
+    }
+  }
+  EXPECT_EQ(active, Isa::kScalar);
+}
+
+// The solver's compile-time scorer agrees with the runtime one.
+template <unsigned P, unsigned C>
+void check_specialised_score() {
+  std::mt19937_64 rng(P * C);
+  for (int i = 0; i < 20000; ++i) {
+    const Code guess = testing::random_code(rng, P, C);
+    const Code secret = testing::random_code(rng, P, C);
+    const Feedback specialised = Solver<P, C>::score(guess, secret);
+    ASSERT_EQ(specialised, score(guess, secret, P));
+  }
+}
+
+TEST(SpecialisedScore, MatchesReference) {
+#define MASTERMYR_CHECK_SCORE(P, C) check_specialised_score<P, C>();
+  MASTERMYR_FOR_EACH_BOARD(MASTERMYR_CHECK_SCORE)
+#undef MASTERMYR_CHECK_SCORE
+}
+
+// Same for the variants' scorers, on codes of their boards.
+template <unsigned P, unsigned C, typename R>
+void check_variant_score() {
+  std::mt19937_64 rng(P * C + R::kDistinct);
+  auto draw = [&] {
+    Code code;
+    do {
+      code = testing::random_code(rng, P, C);
+    } while (!R::is_code(code, P));
+    return code;
+  };
+  for (int i = 0; i < 20000; ++i) {
+    const Code guess = draw();
+    const Code secret = draw();
+    ASSERT_EQ((Solver<P, C, R>::score(guess, secret)), score(guess, secret, P));
+  }
+}
+
+TEST(SpecialisedScore, VariantsMatchReference) {
+#define MASTERMYR_CHECK_VARIANT_SCORE(P, C, R) check_variant_score<P, C, R>();
+  MASTERMYR_FOR_EACH_VARIANT_BOARD(MASTERMYR_CHECK_VARIANT_SCORE)
+#undef MASTERMYR_CHECK_VARIANT_SCORE
+}
+
+TEST(FeedbackMatrix, RowsMatchReference) {
+  const BoardKey key{4, 6, DuplicateRule::kAllowed};
+  const FeedbackMatrix matrix = FeedbackMatrix::build(key);
+  const std::vector<Code> codes = enumerate_codes(key);
+  ASSERT_EQ(matrix.size(), codes.size());
+  for (std::uint32_t g = 0; g < codes.size(); ++g) {
+    const std::span<const Feedback> row = matrix.row(g);
+    for (std::size_t s = 0; s < codes.size(); ++s) {
+      ASSERT_EQ(row[s], score(codes[g], codes[s], 4));
+    }
+  }
+}
+
+// Headers whose code count or payload bounds do not fit the board are
+// rejected before anything is read through them, even with a valid checksum.
+TEST(FeedbackMatrix, LoadRejectsMalformedHeaders) {
+  const BoardKey key{4, 6, DuplicateRule::kAllowed};
+  const std::filesystem::path file =
+      std::filesystem::path(::testing::TempDir()) / "feedback-header.bin";
+  FeedbackMatrix::build(key).save(file);
+  std::string saved;
+  {
+    std::ifstream in(file, std::ios::binary);
+    saved.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  // Header fields: code_count at 16, payload_offset at 24, payload_size at
+  // 32 and checksum at 40; the payload starts at 64.
+  const auto load_with = [&](std::uint64_t count, std::uint64_t offset) {
+    std::string bytes = saved;
+    const std::uint64_t size = count * count;
+    const std::uint64_t checksum =
+        hash_bytes(bytes.data() + 64,
+                   std::min<std::uint64_t>(size, bytes.size() - 64));
+    std::memcpy(bytes.data() + 16, &count, sizeof(count));
+    std::memcpy(bytes.data() + 24, &offset, sizeof(offset));
+    std::memcpy(bytes.data() + 32, &size, sizeof(size));
+    std::memcpy(bytes.data() + 40, &checksum, sizeof(checksum));
+    std::ofstream(file, std::ios::binary | std::ios::trunc) << bytes;
+    return FeedbackMatrix::load(file, key);
+  };
+  EXPECT_EQ(load_with(1296, 64).size(), 1296u);
+  EXPECT_THROW(load_with(36, 64), CacheError);
+  EXPECT_THROW(load_with(1296, ~std::uint64_t{0} - 1000), CacheError);
+  std::filesystem::remove(file);
+}
+
+// Device backends are checked against the host backend; without a device
+// only the host backend itself is, against histograms of the reference.
+TEST(PartitionBackend, HistogramsMatchReference) {
+  const unsigned pegs = 5;
+  const unsigned colours = 8;
+  std::mt19937_64 rng(7);
+  std::vector<Code> guesses(37);
+  std::vector<Code> candidates(3001);
+  for (Code& c : guesses) c = testing::random_code(rng, pegs, colours);
+  for (Code& c : candidates) c = testing::random_code(rng, pegs, colours);
+  const std::size_t slots = feedback_slots(pegs);
+  std::vector<std::uint32_t> want(guesses.size() * slots);
+  for (std::size_t g = 0; g < guesses.size(); ++g) {
+    for (const Code c : candidates) {
+      ++want[g * slots + score(guesses[g], c, pegs).raw()];
+    }
+  }
+  std::vector<std::shared_ptr<PartitionBackend>> backends = {
+      make_host_backend()};
+  if (auto device = detect_partition_backend()) backends.push_back(device);
+  for (const auto& backend : backends) {
+    std::vector<std::uint32_t> got(want.size());
+    backend->partitions(guesses, candidates, pegs, got);
+    EXPECT_EQ(got, want) << backend->name();
+  }
+}
+
+}  // namespace
+}  // namespace mastermyr
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "mastermyr/server.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr unsigned kPegs = 4;
+constexpr unsigned kColours = 6;
+
+// A server on a free loopback port, run on its own thread.
+class ServerTest : public ::testing::Test {
+ protected:
+  void start(ServerOptions options) {
+    auto pool = std::make_shared<ThreadPool>(3);
+    start(
+        options,
+        [pool] {
+          SolverOptions solver_options;
+          solver_options.pool = pool;
+          return make_solver(kPegs, kColours, solver_options);
+        },
+        pool);
+  }
+
+  void start(ServerOptions options, SolverFactory factory,
+             std::shared_ptr<ThreadPool> pool) {
+    options.host = "127.0.0.1";
+    options.port = 0;
+    server_ = std::make_unique<Server>(options, kPegs, kColours,
+                                       std::move(factory), std::move(pool));
+    thread_ = std::thread([this] { server_->run(); });
+  }
+
+  void TearDown() override {
+    server_->stop();
+    thread_.join();
+  }
+
+  int connect() const {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server_->port());
+    ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    EXPECT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                        sizeof(address)),
+              0);
+    return fd;
+  }
+
+  std::unique_ptr<Server> server_;
+  std::thread thread_;
+};
+
+// Played-out histories of random games, one request each, and the guess a
+// solver makes after each.
+struct Requests {
+  std::vector<std::byte> frames;
+  std::vector<Code> guesses;
+};
+
+Requests random_requests(std::size_t count) {
+  std::mt19937_64 rng(14);
+  const std::unique_ptr<GameSolver> solver = make_solver(kPegs, kColours);
+  Requests requests;
+  std::vector<Move> moves;
+  for (std::uint64_t game = 0; game < count; ++game) {
+    const Code secret = testing::random_code(rng, kPegs, kColours);
+    solver->reset();
+    moves.clear();
+    const std::size_t length = rng() % 3;
+    for (std::size_t i = 0; i < length; ++i) {
+      const Code guess = solver->next_guess();
+      const Feedback feedback = score(guess, secret, kPegs);
+      if (feedback == solved_feedback(kPegs)) break;
+      solver->record(guess, feedback);
+      moves.push_back({guess, feedback});
+    }
+    requests.guesses.push_back(solver->next_guess());
+    wire::append_game_state(requests.frames, game, kPegs, kColours, moves);
+  }
+  return requests;
+}
+
+// Everything the server sends until it closes the connection.
+std::vector<std::byte> read_to_end(int fd) {
+  std::vector<std::byte> bytes;
+  std::byte chunk[4096];
+  ssize_t n;
+  while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+    bytes.insert(bytes.end(), chunk, chunk + n);
+  }
+  return bytes;
+}
+
+// A client that sends a batch and half-closes gets every answer, in request
+// order, and then the server closes; more requests than the backlog limit
+// are read as the answers go out.
+TEST_F(ServerTest, AnswersPipelinedRequestsInOrderAfterHalfClose) {
+  ServerOptions options;
+  options.max_pipelined = 4;
+  start(options);
+  const Requests requests = random_requests(200);
+  const int fd = connect();
+  ASSERT_EQ(::write(fd, requests.frames.data(), requests.frames.size()),
+            static_cast<ssize_t>(requests.frames.size()));
+  ASSERT_EQ(::shutdown(fd, SHUT_WR), 0);
+  const std::vector<std::byte> bytes = read_to_end(fd);
+  ::close(fd);
+
+  ASSERT_EQ(bytes.size(), requests.guesses.size() * wire::kAnswerFrame);
+  wire::FrameReader frames(bytes, wire::kAnswerBody);
+  std::span<const std::byte> body;
+  for (std::uint64_t game = 0; game < requests.guesses.size(); ++game) {
+    ASSERT_EQ(frames.next(body), wire::FrameReader::Result::kFrame);
+    const auto answer = wire::AnswerView::parse(body);
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(answer->game(), game);
+    EXPECT_EQ(answer->status(), wire::Status::kOk);
+    EXPECT_EQ(answer->guess(), requests.guesses[game]) << "game " << game;
+  }
+  EXPECT_EQ(server_->requests(), requests.guesses.size());
+}
+
+// A half-close with nothing outstanding closes the connection at once.
+TEST_F(ServerTest, ClosesAnIdleHalfClosedConnection) {
+  start({});
+  const int fd = connect();
+  ASSERT_EQ(::shutdown(fd, SHUT_WR), 0);
+  EXPECT_TRUE(read_to_end(fd).empty());
+  ::close(fd);
+}
+
+// A solver that throws answers kFailed instead of taking the server down,
+// and the next request still gets a solver.
+TEST_F(ServerTest, AnswersFailedWhenTheSolverThrows) {
+  auto calls = std::make_shared<std::atomic<int>>(0);
+  start({},
+        [calls] {
+          if (calls->fetch_add(1) == 0) throw std::runtime_error("no memory");
+          return make_solver(kPegs, kColours);
+        },
+        std::make_shared<ThreadPool>(1));
+  const Requests requests = random_requests(2);
+  const std::span<const std::byte> frames(requests.frames);
+  wire::FrameReader split(frames, frames.size());
+  std::span<const std::byte> body;
+  ASSERT_EQ(split.next(body), wire::FrameReader::Result::kFrame);
+  const std::size_t first = split.consumed();
+
+  std::vector<std::byte> bytes;
+  for (const auto& frame : {frames.first(first), frames.subspan(first)}) {
+    const int fd = connect();
+    ASSERT_EQ(::write(fd, frame.data(), frame.size()),
+              static_cast<ssize_t>(frame.size()));
+    ASSERT_EQ(::shutdown(fd, SHUT_WR), 0);
+    const std::vector<std::byte> answer = read_to_end(fd);
+    ::close(fd);
+    bytes.insert(bytes.end(), answer.begin(), answer.end());
+  }
+
+  ASSERT_EQ(bytes.size(), 2 * wire::kAnswerFrame);
+  wire::FrameReader reader(bytes, wire::kAnswerBody);
+  ASSERT_EQ(reader.next(body), wire::FrameReader::Result::kFrame);
+  auto answer = wire::AnswerView::parse(body);
+  ASSERT_TRUE(answer);
+  EXPECT_EQ(answer->game(), 0u);
+  EXPECT_EQ(answer->status(), wire::Status::kFailed);
+  ASSERT_EQ(reader.next(body), wire::FrameReader::Result::kFrame);
+  answer = wire::AnswerView::parse(body);
+  ASSERT_TRUE(answer);
+  EXPECT_EQ(answer->game(), 1u);
+  EXPECT_EQ(answer->status(), wire::Status::kOk);
+  EXPECT_EQ(answer->guess(), requests.guesses[1]);
+}
+
+}  // namespace
+}  // namespace mastermyr
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "mastermyr/score.hpp"
+#include "mastermyr/session.hpp"
+#include "mastermyr/solver.hpp"
+#include "mastermyr/strategy_tree.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr unsigned kPegs = 4;
+constexpr unsigned kColours = 6;
+
+// The moves a solver of its own makes against `secret`.
+std::vector<Move> solo_game(Code secret) {
+  std::unique_ptr<GameSolver> solver = make_solver(kPegs, kColours);
+  std::vector<Move> moves;
+  while (!solver->solved()) {
+    const Code guess = solver->next_guess();
+    const Feedback feedback = score(guess, secret, kPegs);
+    solver->record(guess, feedback);
+    moves.push_back({guess, feedback});
+  }
+  return moves;
+}
+
+// Every secret as its own session, all advanced one move per round on one
+// thread, plays exactly the game a dedicated solver plays.
+TEST(Session, InterleavedGamesMatchDedicatedSolvers) {
+  SessionHost host(make_solver(kPegs, kColours));
+  const std::vector<Code> secrets = testing::all_codes(kPegs, kColours);
+  std::vector<GameSession> sessions;
+  for (std::size_t i = 0; i < secrets.size(); ++i) {
+    sessions.push_back(host.start());
+  }
+  EXPECT_EQ(host.live(), secrets.size());
+  for (bool playing = true; playing;) {
+    playing = false;
+    for (std::size_t i = 0; i < sessions.size(); ++i) {
+      GameSession& session = sessions[i];
+      if (session.state() != SessionState::kPlaying) continue;
+      session.feedback(score(session.guess(), secrets[i], kPegs));
+      playing = true;
+    }
+  }
+  EXPECT_GT(host.replayed_moves(), 0u);
+  for (std::size_t i = 0; i < secrets.size(); i += 37) {
+    ASSERT_EQ(sessions[i].state(), SessionState::kSolved);
+    const std::vector<Move> want = solo_game(secrets[i]);
+    const std::span<const Move> got = sessions[i].history();
+    ASSERT_EQ(got.size(), want.size());
+    for (std::size_t m = 0; m < want.size(); ++m) {
+      EXPECT_EQ(got[m].guess, want[m].guess);
+      EXPECT_EQ(got[m].feedback, want[m].feedback);
+    }
+  }
+  sessions.clear();
+  EXPECT_EQ(host.live(), 0u);
+}
+
+TEST(Session, GamesPlayedInTurnReplayNothing) {
+  SessionHost host(make_solver(kPegs, kColours));
+  std::mt19937_64 rng(25);
+  for (int game = 0; game < 20; ++game) {
+    const Code secret = testing::random_code(rng, kPegs, kColours);
+    GameSession session = host.start();
+    while (session.state() == SessionState::kPlaying) {
+      session.feedback(score(session.guess(), secret, kPegs));
+    }
+    EXPECT_EQ(session.state(), SessionState::kSolved);
+    EXPECT_EQ(session.history().back().guess, secret);
+  }
+  EXPECT_EQ(host.replayed_moves(), 0u);
+}
+
+TEST(Session, ImpossibleFeedbackEndsTheGame) {
+  SessionHost host(make_solver(kPegs, kColours));
+  GameSession session = host.start();
+  session.feedback(Feedback(3, 1));
+  EXPECT_EQ(session.state(), SessionState::kInconsistent);
+  EXPECT_EQ(session.history().size(), 1u);
+  // The host's solver is still good for other games.
+  GameSession next = host.start();
+  EXPECT_EQ(next.state(), SessionState::kPlaying);
+  EXPECT_EQ(next.guess(), session.history().front().guess);
+}
+
+// Suspended games keep only their frame and a small arena.
+TEST(Session, ManyLiveGamesStaySmall) {
+  auto tree = std::make_shared<const StrategyTree>(
+      StrategyTree::compile(kPegs, kColours, {}));
+  SessionHost host(make_tree_solver(tree));
+  constexpr std::size_t kGames = 20000;
+  std::vector<GameSession> sessions;
+  sessions.reserve(kGames);
+  std::mt19937_64 rng(7);
+  std::vector<Code> secrets;
+  for (std::size_t i = 0; i < kGames; ++i) {
+    sessions.push_back(host.start());
+    secrets.push_back(testing::random_code(rng, kPegs, kColours));
+  }
+  for (std::size_t i = 0; i < kGames; ++i) {
+    sessions[i].feedback(score(sessions[i].guess(), secrets[i], kPegs));
+  }
+  EXPECT_EQ(host.live(), kGames);
+  for (std::size_t i = 0; i < kGames; ++i) {
+    ASSERT_LE(sessions[i].arena_stats().reserved, 256u);
+    while (sessions[i].state() == SessionState::kPlaying) {
+      sessions[i].feedback(score(sessions[i].guess(), secrets[i], kPegs));
+    }
+    ASSERT_EQ(sessions[i].state(), SessionState::kSolved);
+    ASSERT_LE(sessions[i].history().size(), tree->depth());
+  }
+}
+
+}  // namespace
+}  // namespace mastermyr
@@ -0,0 +1,446 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "mastermyr/distributed.hpp"
+#include "mastermyr/solver.hpp"
+#include "mastermyr/strategy_tree.hpp"
+#include "mastermyr/thread_pool.hpp"
+#include "mastermyr/transposition_table.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+using testing::Board;
+
+// Plays a game, checking that every guess after the first keeps the
+// secret among the candidates; returns the guess count.
+unsigned play(GameSolver& solver, Code secret, unsigned limit) {
+  solver.reset();
+  unsigned guesses = 0;
+  while (!solver.solved() && guesses < limit) {
+    const Code guess = solver.next_guess();
+    solver.record(guess, score(guess, secret, solver.pegs()));
+    ++guesses;
+  }
+  return guesses;
+}
+
+TEST(Solver, SolvesEverySmallBoardSecret) {
+  const std::unique_ptr<GameSolver> solver = make_solver(4, 6);
+  for (const Code secret : testing::all_codes(4, 6)) {
+    ASSERT_LE(play(*solver, secret, 10), 5u) << to_string(secret, 4);
+  }
+}
+
+class RandomGames : public ::testing::TestWithParam<Board> {};
+
+// Specialised boards are searched exactly, other ones by sampling; either
+// way the game ends and the remaining count never grows.
+TEST_P(RandomGames, EndWithinBound) {
+  const auto [pegs, colours] = GetParam();
+  SolverOptions options;
+  options.max_guesses = 256;
+  options.reservoir = 256;
+  options.sample_budget = 1 << 14;
+  const std::unique_ptr<GameSolver> solver =
+      make_solver(pegs, colours, options);
+  std::mt19937_64 rng(pegs * 59 + colours);
+  for (int game = 0; game < 6; ++game) {
+    const Code secret = testing::random_code(rng, pegs, colours);
+    solver->reset();
+    std::size_t remaining = solver->remaining();
+    unsigned guesses = 0;
+    while (!solver->solved()) {
+      ASSERT_LT(guesses++, 16u) << to_string(secret, pegs);
+      const Code guess = solver->next_guess();
+      solver->record(guess, score(guess, secret, pegs));
+      ASSERT_LE(solver->remaining(), remaining);
+      ASSERT_GE(solver->remaining(), 1u);
+      remaining = solver->remaining();
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Boards, RandomGames,
+                         ::testing::Values(Board{5, 8}, Board{6, 10},
+                                           Board{5, 6}, Board{7, 9}),
+                         [](const auto& info) {
+                           return std::to_string(info.param.pegs) + "x" +
+                                  std::to_string(info.param.colours);
+                         });
+
+class SearchSettings : public ::testing::TestWithParam<Strategy> {};
+
+// Pruning, the incremental histograms and the pooled search only make a
+// search faster: solvers with each switched from its default play the
+// default solver's guess after every move, on 4x6, which searches its
+// whole code space and so keeps histograms, and on 5x8, which does not.
+TEST_P(SearchSettings, DoNotChangeTheGuess) {
+  SolverOptions base;
+  base.strategy = GetParam();
+  std::vector<SolverOptions> variants(3, base);
+  variants[0].prune = false;
+  variants[1].incremental = false;
+  variants[2].pool = std::make_shared<ThreadPool>(4);
+  std::mt19937_64 rng(22);
+  for (const auto& [pegs, colours, games] :
+       {std::tuple{4u, 6u, 64}, std::tuple{5u, 8u, 4}}) {
+    const std::unique_ptr<GameSolver> solver =
+        make_solver(pegs, colours, base);
+    std::vector<std::unique_ptr<GameSolver>> others;
+    for (const SolverOptions& options : variants) {
+      others.push_back(make_solver(pegs, colours, options));
+    }
+    for (int game = 0; game < games; ++game) {
+      const Code secret = testing::random_code(rng, pegs, colours);
+      solver->reset();
+      for (const auto& other : others) other->reset();
+      while (!solver->solved()) {
+        const Code guess = solver->next_guess();
+        for (std::size_t v = 0; v < others.size(); ++v) {
+          ASSERT_EQ(others[v]->next_guess(), guess)
+              << pegs << "x" << colours << " variant " << v << " secret "
+              << to_string(secret, pegs);
+        }
+        const Feedback feedback = score(guess, secret, pegs);
+        solver->record(guess, feedback);
+        for (const auto& other : others) other->record(guess, feedback);
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Strategies, SearchSettings,
+                         ::testing::Values(Strategy::kMinimax,
+                                           Strategy::kMaxParts,
+                                           Strategy::kExpectedSize,
+                                           Strategy::kEntropy),
+                         [](const auto& info) {
+                           std::string name = strategy_name(info.param);
+                           std::erase(name, '-');
+                           return name;
+                         });
+
+// Threads storing and looking up overlapping keys in a table far smaller
+// than the key set only ever read back an entry stored for the key asked
+// about, and every operation is counted.
+TEST(TranspositionTable, ConcurrentLookupsSeeOnlyWholeEntries) {
+  TranspositionTable table(64 * 64);
+  constexpr unsigned kThreads = 4;
+  constexpr std::uint32_t kKeys = 4096;
+  constexpr int kRounds = 50000;
+  const auto key_of = [](std::uint32_t i) {
+    return PositionKey{i * 0x9e3779b97f4a7c15ull, ~std::uint64_t{i} << 17};
+  };
+  std::atomic<std::uint64_t> wrong{0};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937_64 rng(t);
+      for (int round = 0; round < kRounds; ++round) {
+        const auto i = static_cast<std::uint32_t>(rng() % kKeys);
+        if (rng() & 1) {
+          table.store(key_of(i), {Code(i), static_cast<float>(i) / 8});
+        } else if (const auto hit = table.lookup(key_of(i))) {
+          if (hit->guess != Code(i) || hit->cost != static_cast<float>(i) / 8) {
+            wrong.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(wrong.load(), 0u);
+  const TranspositionTable::Stats stats = table.stats();
+  EXPECT_EQ(stats.hits + stats.misses + stats.stores,
+            std::uint64_t{kThreads} * kRounds);
+  EXPECT_GT(stats.hits, 0u);
+}
+
+TEST(Solver, InconsistentFeedbackThrows) {
+  for (const Board board : {Board{4, 6}, Board{5, 6}}) {
+    const std::unique_ptr<GameSolver> solver =
+        make_solver(board.pegs, board.colours);
+    solver->record(Code(0), Feedback(0, 0));
+    solver->record(Code(0), Feedback(1, 0));
+    EXPECT_THROW(solver->next_guess(), InconsistentFeedback);
+  }
+  EXPECT_THROW(make_solver(9, 6), std::invalid_argument);
+}
+
+// A shared transposition table changes how fast positions are searched,
+// never which guess is played.
+TEST(Solver, TranspositionTableKeepsGuesses) {
+  SolverOptions cached;
+  cached.transposition_table = std::make_shared<TranspositionTable>(1 << 20);
+  const std::unique_ptr<GameSolver> plain = make_solver(4, 6);
+  const std::unique_ptr<GameSolver> with_table = make_solver(4, 6, cached);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const Code secret : testing::all_codes(4, 6)) {
+      plain->reset();
+      with_table->reset();
+      while (!plain->solved()) {
+        const Code guess = plain->next_guess();
+        ASSERT_EQ(with_table->next_guess(), guess);
+        const Feedback feedback = score(guess, secret, 4);
+        plain->record(guess, feedback);
+        with_table->record(guess, feedback);
+      }
+    }
+  }
+}
+
+// A budget too short for a search still yields a guess, from a partial
+// search whose gap accounts for what it skipped.
+TEST(Solver, TimeBudgetCutsTheSearchShort) {
+  SolverOptions rushed;
+  rushed.search_opening = true;
+  rushed.symmetry = false;
+  rushed.time_budget = std::chrono::microseconds(1);
+  const std::unique_ptr<GameSolver> solver = make_solver(5, 8, rushed);
+  solver->next_guess();
+  const SearchStats search = solver->last_search();
+  EXPECT_GE(search.visited, 1u);
+  EXPECT_LT(search.visited, search.space);
+  EXPECT_GE(search.cost, search.bound);
+  EXPECT_GE(search.gap(), 0);
+
+  const std::unique_ptr<GameSolver> exact = make_solver(4, 6);
+  const Code secret = testing::all_codes(4, 6)[700];
+  const Code opening = exact->next_guess();
+  EXPECT_EQ(exact->last_search().space, 0u);
+  exact->record(opening, score(opening, secret, 4));
+  exact->next_guess();
+  EXPECT_TRUE(exact->last_search().complete());
+  EXPECT_EQ(exact->last_search().gap(), 0);
+}
+
+// Ranking guesses on a sample of the candidates and rating the finalists
+// exactly lands within a few percent of the exact search's best cost.
+TEST(Solver, EstimatedSearchNearlyMatchesExact) {
+  std::mt19937_64 rng(27);
+  for (int game = 0; game < 4;) {
+    const Code secret = testing::random_code(rng, 5, 8);
+    SearchStats stats[2];
+    bool large = true;
+    for (const bool estimate : {true, false}) {
+      SolverOptions options;
+      options.symmetry = false;
+      options.estimate_from = estimate ? 4096 : 0;
+      const std::unique_ptr<GameSolver> solver = make_solver(5, 8, options);
+      const Code opening = solver->next_guess();
+      solver->record(opening, score(opening, secret, 5));
+      if (estimate) large = solver->remaining() >= options.estimate_from;
+      solver->next_guess();
+      stats[estimate] = solver->last_search();
+    }
+    if (!large) continue;
+    ++game;
+    const SearchStats& estimated = stats[1];
+    const SearchStats& exact = stats[0];
+    ASSERT_TRUE(exact.exact());
+    EXPECT_GT(estimated.sample, 0u);
+    EXPECT_TRUE(estimated.complete());
+    EXPECT_FALSE(estimated.exact());
+    EXPECT_GE(estimated.cost, exact.cost);
+    EXPECT_LE(estimated.cost, exact.cost * 1.05);
+  }
+}
+
+// Below GuessSearch::kMinEstimated candidates the sample would cover most
+// of them, so such searches stay exact whatever estimate_from says.
+TEST(Solver, SmallSearchesAreNeverEstimated) {
+  SolverOptions options;
+  options.symmetry = false;
+  options.incremental = false;
+  options.search_opening = true;
+  options.estimate_from = 1;
+  const std::unique_ptr<GameSolver> solver = make_solver(4, 6, options);
+  solver->next_guess();
+  EXPECT_TRUE(solver->last_search().exact());
+  EXPECT_EQ(solver->last_search().sample, 0u);
+}
+
+// Solvers with and without symmetry reduction search different spaces, so
+// they keep apart entries in a shared table.
+TEST(Solver, TranspositionTableSeparatesSymmetrySettings) {
+  SolverOptions reduced;
+  reduced.transposition_table = std::make_shared<TranspositionTable>(1 << 20);
+  SolverOptions full = reduced;
+  full.symmetry = false;
+  const Code opening = make_solver(4, 6)->next_guess();
+  const Feedback feedback = score(opening, Code(), 4);
+  for (const SolverOptions& options : {reduced, full}) {
+    const std::unique_ptr<GameSolver> solver = make_solver(4, 6, options);
+    solver->record(opening, feedback);
+    solver->next_guess();
+  }
+  const TranspositionTable::Stats stats =
+      reduced.transposition_table->stats();
+  EXPECT_EQ(stats.hits, 0u);
+  EXPECT_EQ(stats.stores, 2u);
+}
+
+// An estimated search is not stored, so a solver sharing the table that
+// does not estimate still plays its own exact guesses.
+TEST(Solver, TranspositionTableStoresOnlyExactSearches) {
+  std::mt19937_64 rng(270);
+  SolverOptions estimating;
+  estimating.symmetry = false;
+  estimating.estimate_from = 4096;
+  estimating.transposition_table =
+      std::make_shared<TranspositionTable>(1 << 20);
+  SolverOptions exact = estimating;
+  exact.estimate_from = 0;
+  const std::unique_ptr<GameSolver> shared = make_solver(5, 8, exact);
+  exact.transposition_table = nullptr;
+  const std::unique_ptr<GameSolver> plain = make_solver(5, 8, exact);
+  const std::unique_ptr<GameSolver> solver = make_solver(5, 8, estimating);
+  const Code opening = solver->next_guess();
+  Feedback feedback;
+  do {
+    feedback = score(opening, testing::random_code(rng, 5, 8), 5);
+    solver->reset();
+    solver->record(opening, feedback);
+  } while (solver->remaining() < estimating.estimate_from);
+  solver->next_guess();
+  ASSERT_FALSE(solver->last_search().exact());
+  EXPECT_EQ(estimating.transposition_table->stats().stores, 0u);
+
+  plain->record(opening, feedback);
+  shared->record(opening, feedback);
+  EXPECT_EQ(shared->next_guess(), plain->next_guess());
+  EXPECT_EQ(estimating.transposition_table->stats().stores, 1u);
+}
+
+TEST(Solver, PartitionCostBoundIsAnEvenSplit) {
+  EXPECT_EQ(partition_cost_bound(Strategy::kMinimax, 100, 14), 8);
+  EXPECT_EQ(partition_cost_bound(Strategy::kMaxParts, 5, 14), -5);
+  EXPECT_EQ(partition_cost_bound(Strategy::kExpectedSize, 10, 5), 2);
+  EXPECT_EQ(partition_cost_bound(Strategy::kEntropy, 8, 4), 1);
+  EXPECT_EQ(partition_cost_bound(Strategy::kEntropy, 3, 14), 0);
+}
+
+// Codes without a repeated colour, in code_index() order.
+std::vector<Code> distinct_codes(unsigned pegs, unsigned colours) {
+  std::vector<Code> codes = testing::all_codes(pegs, colours);
+  std::erase_if(codes, [&](Code c) { return has_repeated_colour(c, pegs); });
+  return codes;
+}
+
+// Without duplicates every secret is solved from the variant's board,
+// and a feedback matrix over that board, indexed by rank, plays alike.
+TEST(Variant, NoDuplicatesSolvesEverySecret) {
+  SolverOptions tabled;
+  tabled.feedback_matrix = std::make_shared<const FeedbackMatrix>(
+      FeedbackMatrix::build({4, 6, DuplicateRule::kForbidden}));
+  const std::unique_ptr<GameSolver> plain =
+      make_solver(4, 6, Variant::kNoDuplicates);
+  const std::unique_ptr<GameSolver> with_table =
+      make_solver(4, 6, Variant::kNoDuplicates, tabled);
+  const std::vector<Code> secrets = distinct_codes(4, 6);
+  EXPECT_EQ(plain->remaining(), secrets.size());
+  for (const Code secret : secrets) {
+    plain->reset();
+    with_table->reset();
+    unsigned guesses = 0;
+    while (!plain->solved()) {
+      ASSERT_LT(guesses++, 6u) << to_string(secret, 4);
+      const Code guess = plain->next_guess();
+      ASSERT_FALSE(has_repeated_colour(guess, 4)) << to_string(guess, 4);
+      ASSERT_EQ(with_table->next_guess(), guess);
+      const Feedback feedback = score(guess, secret, 4);
+      plain->record(guess, feedback);
+      with_table->record(guess, feedback);
+    }
+  }
+  // A matrix of the board with duplicates is for another code space.
+  tabled.feedback_matrix = std::make_shared<const FeedbackMatrix>(
+      FeedbackMatrix::build({4, 6, DuplicateRule::kAllowed}));
+  EXPECT_THROW(make_solver(4, 6, Variant::kNoDuplicates, tabled),
+               std::invalid_argument);
+}
+
+TEST(Variant, BullsAndCowsSolvesSampledSecrets) {
+  const std::unique_ptr<GameSolver> solver =
+      make_solver(4, 10, *parse_variant("bulls-and-cows"));
+  const std::vector<Code> secrets = distinct_codes(4, 10);
+  EXPECT_EQ(solver->remaining(), secrets.size());
+  for (std::size_t i = 0; i < secrets.size(); i += 97) {
+    EXPECT_LE(play(*solver, secrets[i], 12), 8u) << to_string(secrets[i], 4);
+    EXPECT_TRUE(solver->solved());
+  }
+}
+
+// Static Mastermind plays one probe book whatever the secret, then the
+// secret it pins down.
+TEST(Variant, StaticPlaysOneProbeBook) {
+  const std::unique_ptr<GameSolver> solver =
+      make_solver(4, 6, Variant::kStatic);
+  std::vector<Code> book;
+  for (const Code secret : testing::all_codes(4, 6)) {
+    solver->reset();
+    std::vector<Code> guesses;
+    while (!solver->solved()) {
+      ASSERT_LT(guesses.size(), 10u) << to_string(secret, 4);
+      const Code guess = solver->next_guess();
+      guesses.push_back(guess);
+      solver->record(guess, score(guess, secret, 4));
+    }
+    ASSERT_EQ(guesses.back(), secret);
+    if (book.empty()) book.assign(guesses.begin(), guesses.end() - 1);
+    // A secret in the book is solved at its probe.
+    const std::size_t probes = std::min(guesses.size(), book.size());
+    for (std::size_t i = 0; i < probes; ++i) {
+      ASSERT_EQ(guesses[i], book[i]) << to_string(secret, 4);
+    }
+    ASSERT_LE(guesses.size(), book.size() + 1);
+  }
+  EXPECT_LE(book.size(), 8u);
+  EXPECT_THROW(make_solver(5, 8, Variant::kStatic), std::invalid_argument);
+}
+
+// A coordinator with two in-process workers, one of which connects late,
+// assembles the same tree as a local compile. The workers' own search
+// settings and time budget do not matter.
+TEST(Distributed, CoordinatorAssemblesLocalTree) {
+  const SolverOptions options;
+  SolverOptions worker_options;
+  worker_options.estimate_from = 1;
+  worker_options.max_guesses = 16;
+  worker_options.time_budget = std::chrono::microseconds(1);
+  CoordinatorOptions coordinator_options;
+  coordinator_options.host = "127.0.0.1";
+  coordinator_options.port = 0;
+  Coordinator coordinator(coordinator_options, 4, 6, options);
+  ASSERT_GT(coordinator.jobs(), 1u);
+  std::size_t compiled = 0;
+  std::jthread workers([&] {
+    compiled =
+        run_worker("127.0.0.1", coordinator.port(), worker_options, 2);
+  });
+  const std::optional<StrategyTree> tree = coordinator.run();
+  workers.join();
+  ASSERT_TRUE(tree);
+  EXPECT_EQ(compiled, coordinator.jobs());
+
+  const StrategyTree local = StrategyTree::compile(4, 6, options);
+  ASSERT_EQ(tree->size(), local.size());
+  EXPECT_EQ(tree->depth(), local.depth());
+  for (StrategyTree::NodeIndex node = 0; node < local.size(); ++node) {
+    ASSERT_EQ(tree->guess(node), local.guess(node));
+    ASSERT_EQ(tree->candidates(node), local.candidates(node));
+  }
+}
+
+}  // namespace
+}  // namespace mastermyr
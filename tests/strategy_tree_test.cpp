@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mastermyr/feedback_matrix.hpp"
+#include "mastermyr/strategy_tree.hpp"
+#include "mastermyr/thread_pool.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+constexpr unsigned kPegs = 4;
+constexpr unsigned kColours = 6;
+const BoardKey kKey{kPegs, kColours, DuplicateRule::kAllowed};
+
+// Unique per test, so that the tests can run in parallel.
+std::filesystem::path temp_file(const std::string& name) {
+  std::string test =
+      ::testing::UnitTest::GetInstance()->current_test_info()->name();
+  std::replace(test.begin(), test.end(), '/', '-');
+  return std::filesystem::path(::testing::TempDir()) /
+         (name + "-" + test + ".bin");
+}
+
+std::string file_bytes(const std::filesystem::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::string tree_bytes(const StrategyTree& tree, const std::string& name) {
+  const std::filesystem::path file = temp_file(name);
+  tree.save(file);
+  std::string bytes = file_bytes(file);
+  std::filesystem::remove(file);
+  return bytes;
+}
+
+class Tree : public ::testing::TestWithParam<Strategy> {
+ protected:
+  SolverOptions options() const {
+    SolverOptions options;
+    options.strategy = GetParam();
+    return options;
+  }
+};
+
+// Walking every secret visits each node exactly candidates() times, every
+// child slot leads to a node reached by some secret, and each secret ends
+// on its own code within depth() guesses.
+TEST_P(Tree, EverySecretIsSolvedAndCountsAgree) {
+  const StrategyTree tree = StrategyTree::compile(kPegs, kColours, options());
+  ASSERT_EQ(tree.strategy(), GetParam());
+  std::vector<std::size_t> visits(tree.size());
+  for (const Code secret : testing::all_codes(kPegs, kColours)) {
+    StrategyTree::NodeIndex node = StrategyTree::kRoot;
+    for (unsigned guesses = 1;; ++guesses) {
+      ASSERT_LE(guesses, tree.depth()) << to_string(secret, kPegs);
+      ++visits[node];
+      const Feedback feedback = score(tree.guess(node), secret, kPegs);
+      if (feedback == solved_feedback(kPegs)) break;
+      node = tree.child(node, feedback);
+      ASSERT_NE(node, StrategyTree::kNone) << to_string(secret, kPegs);
+    }
+  }
+  for (StrategyTree::NodeIndex node = 0; node < tree.size(); ++node) {
+    ASSERT_EQ(visits[node], tree.candidates(node)) << "node " << node;
+  }
+  EXPECT_EQ(tree.candidates(StrategyTree::kRoot),
+            code_count(kPegs, kColours));
+}
+
+TEST_P(Tree, ParallelSplitAndAssembledCompilesMatchSerial) {
+  const StrategyTree serial =
+      StrategyTree::compile(kPegs, kColours, options());
+  const std::string want = tree_bytes(serial, "serial");
+
+  SolverOptions parallel_options = options();
+  parallel_options.pool = std::make_shared<ThreadPool>(3);
+  EXPECT_EQ(tree_bytes(StrategyTree::compile(kPegs, kColours,
+                                             parallel_options),
+                       "parallel"),
+            want);
+
+  const StrategyTree::Split split =
+      StrategyTree::split(kPegs, kColours, options());
+  std::vector<StrategyTree::Subtree> subtrees;
+  for (const std::vector<Move>& moves : split.jobs) {
+    subtrees.push_back(
+        StrategyTree::compile_subtree(kPegs, kColours, options(), moves));
+  }
+  EXPECT_EQ(tree_bytes(StrategyTree::assemble(split, subtrees), "assembled"),
+            want);
+  subtrees.pop_back();
+  EXPECT_THROW(StrategyTree::assemble(split, subtrees), std::invalid_argument);
+}
+
+TEST_P(Tree, SaveLoadRoundTripAndEvaluate) {
+  const StrategyTree tree = StrategyTree::compile(kPegs, kColours, options());
+  const std::filesystem::path file = temp_file("tree");
+  tree.save(file);
+  const StrategyTree loaded = StrategyTree::load(file, kKey);
+  EXPECT_TRUE(loaded.is_mapped());
+  ASSERT_EQ(loaded.size(), tree.size());
+  EXPECT_EQ(loaded.depth(), tree.depth());
+  EXPECT_EQ(loaded.strategy(), tree.strategy());
+  for (StrategyTree::NodeIndex node = 0; node < tree.size(); ++node) {
+    ASSERT_EQ(loaded.guess(node), tree.guess(node));
+  }
+
+  ThreadPool pool(2);
+  const TreeEvaluation serial = evaluate(loaded);
+  const TreeEvaluation parallel = evaluate(loaded, &pool);
+  EXPECT_EQ(serial.games, parallel.games);
+  EXPECT_EQ(serial.failures, 0u);
+  EXPECT_EQ(serial.secrets(), code_count(kPegs, kColours));
+  EXPECT_EQ(serial.worst(), tree.depth());
+  EXPECT_LT(serial.average(), 4.7);
+
+  EXPECT_THROW(StrategyTree::load(file, {5, 8, DuplicateRule::kAllowed}),
+               CacheError);
+  {
+    // Flip one payload byte.
+    std::fstream io(file, std::ios::in | std::ios::out | std::ios::binary);
+    io.seekg(100);
+    const char c = static_cast<char>(io.get());
+    io.seekp(100);
+    io.put(static_cast<char>(c ^ 1));
+  }
+  EXPECT_THROW(StrategyTree::load(file, kKey), CacheError);
+  std::filesystem::remove(file);
+}
+
+TEST_P(Tree, TreeSolverPlaysTheTree) {
+  auto tree = std::make_shared<const StrategyTree>(
+      StrategyTree::compile(kPegs, kColours, options()));
+  const std::unique_ptr<GameSolver> solver = make_tree_solver(tree);
+  for (const Code secret : testing::all_codes(kPegs, kColours)) {
+    solver->reset();
+    while (!solver->solved()) {
+      const Code guess = solver->next_guess();
+      solver->record(guess, score(guess, secret, kPegs));
+    }
+  }
+  solver->reset();
+  EXPECT_THROW(solver->record(Code(), Feedback(0, 0)), std::invalid_argument);
+}
+
+// A file whose checksum matches but whose slots point out of the arrays,
+// as a writer bug or a hand-built book could leave, does not load.
+TEST(StrategyTree, LoadRejectsOutOfBoundsSlots) {
+  const std::size_t ranks = feedback_ranks(kPegs);
+  const std::filesystem::path file = temp_file("malformed");
+  const auto load_with = [&](std::uint32_t first_slot,
+                             StrategyTree::NodeIndex child) {
+    StrategyTree::Subtree subtree;
+    subtree.depth = 2;
+    subtree.nodes = {{0x0011, first_slot, 1296},
+                     {0x0122, StrategyTree::kNone, 1}};
+    subtree.children.assign(ranks, StrategyTree::kNone);
+    subtree.children[0] = child;
+    StrategyTree::partial(kKey, Strategy::kMinimax, std::move(subtree))
+        .save(file);
+    return StrategyTree::load(file, kKey);
+  };
+  EXPECT_EQ(load_with(0, 1).size(), 2u);
+  EXPECT_THROW(load_with(1, 1), CacheError);
+  EXPECT_THROW(load_with(0, 2), CacheError);
+  std::filesystem::remove(file);
+}
+
+INSTANTIATE_TEST_SUITE_P(Strategies, Tree,
+                         ::testing::Values(Strategy::kMinimax,
+                                           Strategy::kMaxParts,
+                                           Strategy::kExpectedSize,
+                                           Strategy::kEntropy),
+                         [](const auto& info) {
+                           std::string name = strategy_name(info.param);
+                           std::erase(name, '-');
+                           return name;
+                         });
+
+}  // namespace
+}  // namespace mastermyr
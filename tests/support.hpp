@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "mastermyr/code.hpp"
+#include "mastermyr/solver.hpp"
+
+namespace mastermyr::testing {
+
+inline Code random_code(std::mt19937_64& rng, unsigned pegs,
+                        unsigned colours) {
+  Code code;
+  for (unsigned i = 0; i < pegs; ++i) {
+    code = code.with_peg(i, static_cast<unsigned>(rng() % colours));
+  }
+  return code;
+}
+
+// Every code of the board in code_index() order.
+inline std::vector<Code> all_codes(unsigned pegs, unsigned colours) {
+  std::vector<Code> codes(code_count(pegs, colours));
+  for (std::size_t i = 0; i < codes.size(); ++i) {
+    codes[i] = code_at_index(static_cast<std::uint32_t>(i), pegs, colours);
+  }
+  return codes;
+}
+
+struct Board {
+  unsigned pegs;
+  unsigned colours;
+};
+
+}  // namespace mastermyr::testing
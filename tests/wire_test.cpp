@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "mastermyr/batch_solver.hpp"
+#include "mastermyr/wire.hpp"
+#include "support.hpp"
+
+namespace mastermyr {
+namespace {
+
+using wire::FrameReader;
+using wire::GameStateView;
+using wire::Status;
+
+std::span<const std::byte> body_of(const std::vector<std::byte>& frame) {
+  return std::span(frame).subspan(wire::kLengthPrefix);
+}
+
+TEST(Wire, GameStateRoundTrip) {
+  std::mt19937_64 rng(3);
+  std::vector<Move> moves(9);
+  for (Move& move : moves) {
+    move.guess = testing::random_code(rng, 5, 8);
+    move.feedback = Feedback(static_cast<std::uint8_t>(rng() % 0x40));
+  }
+  std::vector<std::byte> frame;
+  wire::append_game_state(frame, 0x1122334455667788, 5, 8, moves);
+  ASSERT_EQ(frame.size(),
+            wire::kLengthPrefix + wire::kStateHeader + 9 * wire::kMoveSize);
+  const std::optional<GameStateView> state = GameStateView::parse(body_of(frame));
+  ASSERT_TRUE(state);
+  EXPECT_EQ(state->game(), 0x1122334455667788u);
+  EXPECT_EQ(state->pegs(), 5u);
+  EXPECT_EQ(state->colours(), 8u);
+  ASSERT_EQ(state->size(), moves.size());
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    EXPECT_EQ((*state)[i].guess, moves[i].guess);
+    EXPECT_EQ((*state)[i].feedback, moves[i].feedback);
+  }
+  // A truncated body does not parse.
+  EXPECT_FALSE(GameStateView::parse(body_of(frame).first(frame.size() - 5)));
+
+  std::vector<Move> too_many(wire::kMaxMoves + 1);
+  EXPECT_THROW(wire::append_game_state(frame, 1, 4, 6, too_many),
+               std::invalid_argument);
+}
+
+TEST(Wire, ValidMovesChecksCodesAndPins) {
+  std::vector<std::byte> frame;
+  const std::vector<Move> ok = {{*parse_code("0123", 4, 6), Feedback(1, 2)}};
+  wire::append_game_state(frame, 1, 4, 6, ok);
+  EXPECT_TRUE(GameStateView::parse(body_of(frame))->valid_moves());
+
+  frame.clear();
+  const std::vector<Move> bad_colour = {{Code(0x6000), Feedback(0, 0)}};
+  wire::append_game_state(frame, 1, 4, 6, bad_colour);
+  EXPECT_FALSE(GameStateView::parse(body_of(frame))->valid_moves());
+
+  frame.clear();
+  const std::vector<Move> bad_pins = {{Code(0), Feedback(3, 2)}};
+  wire::append_game_state(frame, 1, 4, 6, bad_pins);
+  EXPECT_FALSE(GameStateView::parse(body_of(frame))->valid_moves());
+}
+
+TEST(Wire, FrameReaderSplitsPartialAndOversizedFrames) {
+  std::vector<std::byte> bytes;
+  wire::append_answer(bytes, 7, Status::kOk, Code(0x1234));
+  wire::append_answer(bytes, 8, Status::kInconsistent, Code());
+  {
+    FrameReader reader({bytes.data(), bytes.size() - 3}, wire::kAnswerBody);
+    std::span<const std::byte> body;
+    ASSERT_EQ(reader.next(body), FrameReader::Result::kFrame);
+    const auto answer = wire::AnswerView::parse(body);
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(answer->game(), 7u);
+    EXPECT_EQ(answer->status(), Status::kOk);
+    EXPECT_EQ(answer->guess(), Code(0x1234));
+    EXPECT_EQ(reader.next(body), FrameReader::Result::kPartial);
+    EXPECT_EQ(reader.consumed(), wire::kAnswerFrame);
+  }
+  FrameReader small(bytes, wire::kAnswerBody - 1);
+  std::span<const std::byte> body;
+  EXPECT_EQ(small.next(body), FrameReader::Result::kOversized);
+}
+
+// A stream read through a buffer much smaller than itself comes back whole
+// and in order.
+TEST(Wire, GameStateReaderStreamsThroughSmallBuffer) {
+  std::mt19937_64 rng(5);
+  std::vector<std::byte> bytes;
+  for (std::uint64_t game = 0; game < 500; ++game) {
+    std::vector<Move> moves(rng() % 6);
+    for (Move& move : moves) move.guess = testing::random_code(rng, 4, 6);
+    wire::append_game_state(bytes, game, 4, 6, moves);
+  }
+  std::stringstream in(std::string(reinterpret_cast<const char*>(bytes.data()),
+                                   bytes.size()));
+  wire::GameStateReader reader(in, 0);
+  std::uint64_t next = 0;
+  while (true) {
+    const std::span<const GameStateView> batch = reader.next_batch(7);
+    if (batch.empty()) break;
+    for (const GameStateView& state : batch) EXPECT_EQ(state.game(), next++);
+  }
+  EXPECT_EQ(next, 500u);
+  EXPECT_EQ(reader.count(), 500u);
+
+  std::stringstream torn(std::string(
+      reinterpret_cast<const char*>(bytes.data()), bytes.size() - 2));
+  wire::GameStateReader torn_reader(torn, 0);
+  EXPECT_THROW(
+      while (!torn_reader.next_batch(64).empty()) {}, wire::WireError);
+}
+
+TEST(Wire, BatchAnswersMatchOneSolverPerGame) {
+  std::mt19937_64 rng(9);
+  std::vector<std::byte> frames;
+  std::vector<std::vector<Move>> games;
+  for (std::uint64_t game = 0; game < 200; ++game) {
+    const Code secret = testing::random_code(rng, 4, 6);
+    const std::unique_ptr<GameSolver> solver = make_solver(4, 6);
+    std::vector<Move> moves;
+    for (std::size_t n = rng() % 4; n > 0 && !solver->solved(); --n) {
+      const Code guess = solver->next_guess();
+      moves.push_back({guess, score(guess, secret, 4)});
+      solver->record(guess, moves.back().feedback);
+    }
+    if (game % 10 == 0) moves.push_back({Code(0), Feedback(3, 1)});
+    wire::append_game_state(frames, game, 4, 6, moves);
+    games.push_back(moves);
+  }
+  std::vector<GameStateView> states;
+  FrameReader reader(frames, wire::kMaxStateBody);
+  std::span<const std::byte> body;
+  while (reader.next(body) == FrameReader::Result::kFrame) {
+    states.push_back(*GameStateView::parse(body));
+  }
+  BatchSolver batch(4, 6);
+  std::vector<std::byte> out;
+  batch.answer(states, out);
+  ASSERT_EQ(out.size(), states.size() * wire::kAnswerFrame);
+  for (std::size_t g = 0; g < games.size(); ++g) {
+    const auto answer = wire::AnswerView::parse(
+        std::span(out).subspan(g * wire::kAnswerFrame + wire::kLengthPrefix,
+                               wire::kAnswerBody));
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(answer->game(), g);
+    const std::unique_ptr<GameSolver> solver = make_solver(4, 6);
+    try {
+      for (const Move& move : games[g]) solver->record(move.guess, move.feedback);
+      const Code guess = solver->next_guess();
+      EXPECT_EQ(answer->status(), Status::kOk);
+      EXPECT_EQ(answer->guess(), guess);
+    } catch (const InconsistentFeedback&) {
+      EXPECT_EQ(answer->status(), Status::kInconsistent);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace mastermyr